@@ -4,27 +4,45 @@ import yaml
 import matplotlib.pyplot as plt
 from matplotlib.patches import Ellipse
 from mpl_toolkits import mplot3d
+from sim_log import SimLog, text_steps, use_binary
 
 
 rospack = rospkg.RosPack()
 rospack.list() 
 path = rospack.get_path('amswarm')
 
-sim_data = np.loadtxt(path + "/data/sim_data.txt")
-sim_info = np.loadtxt(path + "/data/sim_info.txt")
+if use_binary(path + "/data/sim_data.bin", path + "/data/sim_data.txt"):
+    log = SimLog(path + "/data/sim_data.bin")
+    sim_data = log.sim_data()
+    steps = log.step
 
-dt = float(sim_info[0][2])
-num_obs = int(sim_info[0][1])
-num_drone = int(sim_info[0][0])
-dim_drone = sim_info[1]
+    dt = float(log.dt)
+    num_obs = int(log.num_obs)
+    num_drone = int(log.num_drone)
+    dim_drone = log.dim_drone
 
-a_drone, b_drone, c_drone = dim_drone
+    init_drone = log.init_drone
+    goal_drone = log.goal_drone
+
+    pos_obs = log.pos_obs
+    dim_obs = log.dim_obs
+else:
+    sim_data = np.loadtxt(path + "/data/sim_data.txt")
+    sim_info = np.loadtxt(path + "/data/sim_info.txt")
+
+    dt = float(sim_info[0][2])
+    num_obs = int(sim_info[0][1])
+    num_drone = int(sim_info[0][0])
+    dim_drone = sim_info[1]
+    steps = text_steps(path + "/data/sim_steps.txt", len(sim_data)//num_drone//3)
 
-init_drone = sim_info[2:2+num_drone]
-goal_drone = sim_info[2+num_drone:2+2*num_drone]
+    init_drone = sim_info[2:2+num_drone]
+    goal_drone = sim_info[2+num_drone:2+2*num_drone]
 
-pos_obs = sim_info[2+2*num_drone:2+2*num_drone+num_obs]
-dim_obs = sim_info[2+2*num_drone+num_obs:]
+    pos_obs = sim_info[2+2*num_drone:2+2*num_drone+num_obs]
+    dim_obs = sim_info[2+2*num_drone+num_obs:]
+
+a_drone, b_drone, c_drone = dim_drone
 
 x_obs = pos_obs[:,0]
 y_obs = pos_obs[:,1]
@@ -97,7 +115,7 @@ if num_obs > 0:
 
 collision_count_agent = 0
 collision_count_obs = 0
-sim_steps = (len(sim_data)/num_drone/3)
+sim_steps = len(steps)
 
 
 for i in range(sim_steps):
@@ -139,7 +157,7 @@ for i in range(sim_steps):
                     print(x_check, y_check, z_check, x_obs[n], y_obs[n], z_obs[n], a_obs[n], b_obs[n], c_obs[n])        
                     print(val)
             
-    stats = ax.text(0, y_lim[1], z_lim[1],'Obstacle Collision Count = {obs}\nInter-Agent Collision Count = {col}\nAgents = {n}\nSim-Step = {step}'.format(obs=collision_count_obs, col=collision_count_agent, n=num_drone, step=i)) 
+    stats = ax.text(0, y_lim[1], z_lim[1],'Obstacle Collision Count = {obs}\nInter-Agent Collision Count = {col}\nAgents = {n}\nSim-Step = {step}'.format(obs=collision_count_obs, col=collision_count_agent, n=num_drone, step=steps[i])) 
     
     
     # for k in range(0, num_drone):
@@ -4,23 +4,38 @@ import yaml
 import matplotlib.pyplot as plt
 from matplotlib.patches import Ellipse
 from mpl_toolkits import mplot3d
+from sim_log import SimLog, text_steps, use_binary
 
 rospack = rospkg.RosPack()
 rospack.list() 
 path = rospack.get_path('amswarm')
 
-sim_data_x = np.loadtxt(path + "/data/sim_data_upsampled_x.txt")
-sim_data_y = np.loadtxt(path + "/data/sim_data_upsampled_y.txt")
-sim_data_z = np.loadtxt(path + "/data/sim_data_upsampled_z.txt")
+if use_binary(path + "/data/sim_data.bin", path + "/data/sim_data_upsampled_x.txt"):
+    log = SimLog(path + "/data/sim_data.bin")
+    sim_data_x = log.sim_data_upsampled(0)
+    sim_data_y = log.sim_data_upsampled(1)
+    sim_data_z = log.sim_data_upsampled(2)
+    steps = log.step
 
-sim_info = np.loadtxt(path + "/data/sim_info.txt")
-dt = float(sim_info[0][2])
-num_obs = int(sim_info[0][1])
-num_drone = int(sim_info[0][0])
+    dt = float(log.dt)
+    num_obs = int(log.num_obs)
+    num_drone = int(log.num_drone)
+else:
+    sim_data_x = np.loadtxt(path + "/data/sim_data_upsampled_x.txt")
+    sim_data_y = np.loadtxt(path + "/data/sim_data_upsampled_y.txt")
+    sim_data_z = np.loadtxt(path + "/data/sim_data_upsampled_z.txt")
 
-sim_steps = (len(sim_data_x)/num_drone/3)
+    sim_info = np.loadtxt(path + "/data/sim_info.txt")
+    dt = float(sim_info[0][2])
+    num_obs = int(sim_info[0][1])
+    num_drone = int(sim_info[0][0])
+    steps = text_steps(path + "/data/sim_steps.txt", len(sim_data_x)//num_drone//3)
+
+sim_steps = len(steps)
 ### SEND COMMANDS AT PLANNING TIME / NUM_UP CONTROL FREQUENCY
 for i in range(sim_steps):
+    # commands of MPC step steps[i], starting at steps[i]*dt (a step dropped from the log leaves a gap)
+    t_start = steps[i]*dt
     x_cmd = sim_data_x[i:i+num_drone] 
     y_cmd = sim_data_y[i:i+num_drone]
     z_cmd = sim_data_z[i:i+num_drone]
@@ -44,8 +59,11 @@ for i in range(sim_steps):
     """
 
     for j in range(len(x_cmd[0])):
+        # the num_up/num commands of a step are evenly spread over its dt
+        t_cmd = t_start + j*dt/len(x_cmd[0])
         
         """
+            at time t_cmd
             send x_cmd[0][j] to drone 0
             send x_cmd[1][j] to drone 1
             send x_cmd[2][j] to drone 2
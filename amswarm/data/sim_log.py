@@ -0,0 +1,76 @@
+import os
+import zlib
+import numpy as np
+
+"""
+    Reader of the binary trajectory log written with log_format: binary (see include/simulator/trajectory_log.hpp).
+
+    log = SimLog(path + "/data/sim_data.bin")
+    log.step    ---> [steps] MPC step index of each frame, with log_queue_full: drop a skipped step leaves a gap
+    log.board   ---> [steps, 3 (x, y, z), num_drone, num] planned trajectories
+    log.up      ---> [steps, 3 (x, y, z), 3 (pos, vel, acc), num_drone, up_steps] upsampled commands
+
+    Uncompressed logs are memory mapped, so only the frames that are indexed get read.
+    sim_data() and sim_data_upsampled(axis) return the same arrays np.loadtxt gives for the text dumps.
+"""
+
+class SimLog:
+    def __init__(self, file_name):
+        with open(file_name, "rb") as f:
+            if f.read(8) != b"AMSWLOG\0":
+                raise ValueError(file_name + " is not an AMSwarm trajectory log")
+            (self.version, header_bytes, self.num_drone, self.num, self.num_up, self.up_steps,
+             self.num_obs, self.chunk_frames) = np.fromfile(f, dtype="<i4", count=8)
+            self.dt, a_drone, b_drone, c_drone = np.fromfile(f, dtype="<f4", count=4)
+            self.dim_drone = np.array([a_drone, b_drone, c_drone])
+            self.init_drone = np.fromfile(f, dtype="<f4", count=3*self.num_drone).reshape(-1, 3)
+            self.goal_drone = np.fromfile(f, dtype="<f4", count=3*self.num_drone).reshape(-1, 3)
+            self.pos_obs = np.fromfile(f, dtype="<f4", count=3*self.num_obs).reshape(-1, 3)
+            self.dim_obs = np.fromfile(f, dtype="<f4", count=3*self.num_obs).reshape(-1, 3)
+
+        # version 1 frames carry no step index, their steps are consecutive
+        step_size = 1 if self.version >= 2 else 0
+        frame_size = step_size + 3*self.num_drone*self.num + 9*self.num_drone*self.up_steps
+        if self.chunk_frames == 0:
+            steps = (os.path.getsize(file_name) - header_bytes)//(4*frame_size)
+            frames = np.memmap(file_name, dtype="<f4", mode="r", offset=header_bytes, shape=(steps, frame_size))
+        else:
+            chunks = []
+            with open(file_name, "rb") as f:
+                f.seek(header_bytes)
+                while True:
+                    chunk_header = np.fromfile(f, dtype="<u4", count=2)
+                    if len(chunk_header) < 2:
+                        break
+                    chunks.append(np.frombuffer(zlib.decompress(f.read(int(chunk_header[1]))), dtype="<f4"))
+            frames = np.concatenate(chunks).reshape(-1, frame_size) if chunks else np.zeros((0, frame_size), dtype="<f4")
+
+        self.steps = len(frames)
+        self.step = frames[:, 0].astype(int) if step_size else np.arange(self.steps)
+        split = step_size + 3*self.num_drone*self.num
+        self.board = frames[:, step_size:split].reshape(self.steps, 3, self.num_drone, self.num)
+        self.up = frames[:, split:].reshape(self.steps, 3, 3, self.num_drone, self.up_steps)
+
+    def sim_data(self):
+        # rows of sim_data.txt: per step x, y, z blocks of num_drone rows
+        return self.board.reshape(-1, self.num)
+
+    def sim_data_upsampled(self, axis):
+        # rows of sim_data_upsampled_{x,y,z}.txt: per step pos, vel, acc blocks of num_drone rows
+        return self.up[:, axis].reshape(-1, self.up_steps)
+
+
+def text_steps(file_name, num_frames):
+    # step index of each frame of the text dumps (sim_steps.txt), consecutive when it is missing or stale
+    if os.path.exists(file_name):
+        step = np.atleast_1d(np.loadtxt(file_name, dtype=int))
+        if len(step) == num_frames:
+            return step
+    return np.arange(num_frames)
+
+
+def use_binary(bin_name, txt_name):
+    # the newer of the two dumps, text when no binary log was written
+    if not os.path.exists(bin_name):
+        return False
+    return not os.path.exists(txt_name) or os.path.getmtime(bin_name) >= os.path.getmtime(txt_name)
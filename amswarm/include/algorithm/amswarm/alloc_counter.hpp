@@ -0,0 +1,7 @@
+#pragma once
+#include <cstddef>
+
+// Heap allocations made so far by the calling thread. Counting is compiled in with
+// AMSWARM_COUNT_ALLOCS, otherwise threadAllocCount() always returns 0
+bool allocCountEnabled();
+size_t threadAllocCount();
@@ -0,0 +1,11 @@
+#pragma once
+#include "algorithm/amswarm/trajectory_utils.hpp"
+
+// Process-wide basisCache entry for these parameters, computed on first use and shared while some
+// agent holds it; once the last holder is gone it is freed and built again on the next request. With
+// a non-empty cache_dir (relative paths are taken from the package directory) entries are also read
+// from and written to disk, so later runs and rebuilt entries skip the computation
+std :: shared_ptr<const basisCache> getBasis(int num, int num_up, float t_plan, int kappa, int order_smoothness, bool axis_wise, const std :: string &cache_dir);
+
+// Bases and constant costs of an entry, always computed
+void computeBasis(basisCache &basis, int num, int num_up, float t_plan, int kappa, int order_smoothness, bool axis_wise);
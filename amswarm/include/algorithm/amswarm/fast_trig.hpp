@@ -0,0 +1,36 @@
+#pragma once
+#include <cmath>
+#include <cfloat>
+
+// Branch-free polynomial atan2/sincos for the polar variable updates, written so that
+// `#pragma omp simd` loops vectorize them (AVX2/AVX-512 with AMSWARM_NATIVE_ARCH).
+// Max abs error: fastAtan2 < 2e-6 rad, fastSinCos < 4e-7 for |x| < 4 pi
+
+inline float fastAtan2(float y, float x)
+{
+    float ax = std :: fabs(x), ay = std :: fabs(y);
+    float t = std :: fmin(ax, ay) / std :: fmax(std :: fmax(ax, ay), FLT_MIN);
+    float t2 = t * t;
+
+    // atan on [0, 1], then fold back into the right octant/quadrant
+    float r = t * (0.99997726f + t2 * (-0.33262347f + t2 * (0.19354346f + t2 * (-0.11643287f + t2 * (0.05265332f + t2 * -0.01172120f)))));
+    r = ay > ax ? 1.57079633f - r : r;
+    r = x < 0.0f ? 3.14159265f - r : r;
+
+    return std :: copysign(r, y);
+}
+
+inline void fastSinCos(float x, float &s, float &c)
+{
+    // Reduce to |r| <= pi/4 (pi/2 split in two for the subtraction), q is the quadrant
+    float q = std :: floor(x * 0.63661977f + 0.5f);
+    float r = (x - q * 1.5703125f) - q * 4.83826794e-4f;
+    float r2 = r * r;
+
+    float sr = r + r * r2 * (-1.66666667e-1f + r2 * (8.33333333e-3f + r2 * -1.98412698e-4f));
+    float cr = 1.0f + r2 * (-0.5f + r2 * (4.16666667e-2f + r2 * (-1.38888889e-3f + r2 * 2.48015873e-5f)));
+
+    int iq = (int)q & 3;
+    s = iq == 0 ? sr : (iq == 1 ? cr : (iq == 2 ? -sr : -cr));
+    c = iq == 0 ? cr : (iq == 1 ? -sr : (iq == 2 ? -cr : sr));
+}
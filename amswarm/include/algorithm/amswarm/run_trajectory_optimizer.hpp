@@ -3,6 +3,9 @@
 #include "algorithm/amswarm/obstacles_utils.hpp" 
 #include "algorithm/amswarm/solve_polar_var.hpp"
 #include "algorithm/amswarm/solve_position_var.hpp"
+#include "algorithm/amswarm/alloc_counter.hpp"
+#include "algorithm/amswarm/telemetry.hpp"
+#include "algorithm/amswarm/basis_cache.hpp"
 
 void checkResiduals(probData &prob_data, int VERBOSE);
 void initializeOptimizer(probData &prob_data, int VERBOSE);
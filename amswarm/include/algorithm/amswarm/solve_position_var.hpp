@@ -1,6 +1,15 @@
 #pragma once
 #include "algorithm/amswarm/trajectory_utils.hpp"
 
+Eigen :: Array<float, 9, 1> kktKey(probData &prob_data, bool static_obs);
+void solveKKT(kktCache &cache, const Eigen :: Array<float, 9, 1> &key, const Eigen :: Ref<const Eigen :: MatrixXf> &objective, const Eigen :: Ref<const Eigen :: MatrixXf> &A_eq, 
+                const Eigen :: Ref<const Eigen :: MatrixXf> &lincost, const Eigen :: Ref<const Eigen :: MatrixXf> &b_eq, Eigen :: Ref<Eigen :: MatrixXf> sol);
+void solveKKT11(kktCache &cache, const Eigen :: Array<float, 9, 1> &key, const Eigen :: Ref<const Eigen :: MatrixXf> &objective, const Eigen :: Ref<const Eigen :: MatrixXf> &A_eq, 
+                const Eigen :: Ref<const Eigen :: MatrixXf> &lincost, const Eigen :: Ref<const Eigen :: MatrixXf> &b_eq, Eigen :: Ref<Eigen :: MatrixXf> sol);
+Eigen :: ArrayXXf solveKKT(kktCache &cache, const Eigen :: Array<float, 9, 1> &key, const Eigen :: ArrayXXf &objective, const Eigen :: ArrayXXf &A_eq, const Eigen :: ArrayXXf &lincost, const Eigen :: ArrayXXf &b_eq);
+void warmStartADMM(probData &prob_data);
+
+void endXYZ(probData &prob_data, int break_flag);
 void computeXYZ(probData &prob_data, int VERBOSE);
 void computeXYZAxis(probData &prob_data, int VERBOSE);
 void computeXY(probData &prob_data, int VERBOSE);
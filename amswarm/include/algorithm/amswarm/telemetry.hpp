@@ -0,0 +1,7 @@
+#pragma once
+#include "algorithm/amswarm/trajectory_utils.hpp"
+
+// Per agent ring buffer of stepTelemetry records, capacity 0 disables recording
+void initTelemetry(telemetryRing &ring, int capacity);
+void recordTelemetry(probData &prob_data);
+void writeTelemetryCSV(std :: ofstream &out, const telemetryRing &ring, int agent_id, bool header);
@@ -1,6 +1,9 @@
 #pragma once
 #include <eigen3/Eigen/Dense>
 #include <vector>
+#include <memory>
+#include <atomic>
+#include <algorithm>
 #include "yaml-cpp/yaml.h"
 #include <iostream>
 #include <fstream>
@@ -10,16 +13,122 @@
 #include <ros/ros.h>
 
 
+typedef Eigen :: Matrix<float, 11, 11> Matrix11f;
+typedef Eigen :: Matrix<float, 11, Eigen :: Dynamic, 0, 11, 3> Matrix11Xf;
+typedef Eigen :: Matrix<float, 3, Eigen :: Dynamic, 0, 3, 3> Matrix3Xf;
+
+// Horizon (num, kappa) of the shipped configs, computeXYZ has a fixed-size specialization for it
+const int FIXED_NUM = 30, FIXED_KAPPA = 10;
+
 struct five_var
 {
     Eigen :: ArrayXXf a, b, c, d, e;
 };    
+struct basisCache
+{
+    // Bernstein matrices on the num and num_up grids and the constant constraint/Gram matrices
+    // derived from them, identical for every agent with the same (num, num_up, t_plan, kappa,
+    // order_smoothness, axis_wise) and shared read-only between them (see getBasis)
+    Eigen :: ArrayXXf P, Pdot, Pddot, Pdddot, Pddddot;
+    Eigen :: ArrayXXf P_up, Pdot_up, Pddot_up, Pdddot_up, Pddddot_up;
+    Eigen :: ArrayXXf A_ineq, A_eq, A_v_ineq, A_a_ineq, A_j_ineq, A_s_ineq;
+    Eigen :: ArrayXXf cost_smoothness, cost_goal, cost_vel, cost_acc, cost_jerk, cost_snap, cost_ineq;
+    Eigen :: MatrixXf shift_dual, gram_P;
+};
+struct kktCache
+{
+    // Factorization of the equality constrained QP [Q A^T; A 0], reused while
+    // the weights/penalties that make up Q stay unchanged
+    bool valid = false;
+    Eigen :: Array<float, 9, 1> key;
+    Eigen :: LDLT<Eigen :: MatrixXf> cost_fact, schur_fact;
+    Eigen :: MatrixXf cost_inv_eq;
+
+    // Stack resident copy for the order 10 Bernstein basis (nvar = 11, 3 equality rows)
+    Eigen :: LDLT<Matrix11f> cost_fact_11;
+    Eigen :: LDLT<Eigen :: Matrix3f> schur_fact_11;
+    Eigen :: Matrix<float, 11, 3> cost_inv_eq_11;
+};
+struct repeatedBlock
+{
+    // Implicit vertical stack of num_blocks copies of block (P for the collision
+    // constraints), so A^T A and A^T b never depend on the stacked row count.
+    // block and its Gram matrix are not owned, they live in the shared basisCache
+    int num_blocks = 0;
+    const Eigen :: ArrayXXf *block = nullptr;
+    const Eigen :: MatrixXf *gram = nullptr;
+    Eigen :: VectorXf block_sum;
+};
+struct amWorkspace
+{
+    // Scratch for the AM iterations, sized once per agent so that a steady-state
+    // MPC step does not touch the heap. Columns of the 3 column arrays are x, y, z
+    int max_blocks = 0;
+    int num_drone_rows = 0, num_static_obs_rows = 0;
+    Eigen :: ArrayXXf objective_xy, objective_z, cost_drone, cost_static_obs;
+    Eigen :: ArrayXXf lincost, sol, b_eq;
+    Eigen :: ArrayXXf res_ineq, res_vel, res_acc, res_jerk, res_snap, ineq_tmp;
+    // 2num x 3, residual of one axis-wise box constraint family (position, velocity, ...) at a time
+    Eigen :: ArrayXXf res_box;
+    
+    // num x max_blocks, one column per neighbour/obstacle so leftCols(k) is the flattened (k*num) vector
+    Eigen :: ArrayXXf temp_x, temp_y, temp_z;
+};
+struct stepTelemetry
+{
+    // One record per agent per MPC step, residuals are the xyz norm of each constraint family
+    int mpc_step, num_iters;
+    bool converged;
+    float res_static_obs, res_drone, res_vel, res_acc, res_jerk, res_snap, res_ineq;
+    float rho_static_obs, rho_drone, rho_vel, rho_acc, rho_jerk, rho_snap, rho_ineq;
+    float time_polar, time_solve, time_residual, time_total;
+};
+struct telemetryRing
+{
+    // Preallocated, the oldest records are overwritten once capacity is reached
+    std :: vector<stepTelemetry> records;
+    size_t head = 0, count = 0;
+};
+struct spatialGrid
+{
+    // Uniform xy grid over axis-aligned boxes (x_min, y_min, x_max, y_max per row), every item is
+    // listed in each cell its box overlaps. Empty (nx = 0) when culling is disabled
+    float x_min = 0, y_min = 0, cell = 0;
+    int nx = 0, ny = 0;
+    Eigen :: ArrayXXf boxes;
+    std :: vector<int> cell_start, items;
+};
+struct bvhNode
+{
+    // Bounds of the subtree, children (-1 for a leaf) or the leaf's items[start, start + count)
+    float x_min, y_min, x_max, y_max;
+    int left, right, start, count;
+};
+struct obstacleBVH
+{
+    // Bounding-volume hierarchy over fixed xy boxes (x_min, y_min, x_max, y_max per row), built
+    // once by median splits along the longer axis
+    std :: vector<bvhNode> nodes;
+    std :: vector<int> items;
+    Eigen :: ArrayXXf boxes;
+};
+struct trajectoryBoard
+{
+    // Predicted trajectories of all agents (one row each), double-buffered: publishes go to the
+    // back buffer and flipBoard() swaps it to the front, which agents only read through const views.
+    // grid[front] indexes the swept boxes of the front trajectories when grid_cell > 0
+    Eigen :: ArrayXXf x[2], y[2], z[2];
+    spatialGrid grid[2];
+    float grid_cell;
+    std :: atomic<size_t> epoch{0};
+};
 struct probData
 {
-    bool jerk_snap_constraints, axis_wise, free_space;
+    bool jerk_snap_constraints, axis_wise, free_space, trig_free, warm_start, fixed_basis;
 
     int num, num_up, num_static_obs, num_drone, num_obs, nvar, id_badge, unify_obs,
-        max_iter, mpc_step, kappa, world;
+        max_iter, mpc_step, kappa, world, num_iters;
+    bool converged;
 
     
     float t_plan, vel_max, acc_max, jerk_max, snap_max, max_sim_time, dt, dist_to_goal, total_dist;
@@ -27,7 +136,7 @@ struct probData
     float rho_static_obs, rho_drone, rho_vel, rho_acc, rho_jerk, rho_snap, rho_ineq;
     float rho_static_obs_max, rho_drone_max, rho_vel_max, rho_acc_max, rho_jerk_max, rho_snap_max, rho_ineq_max;
     float delta_static_obs, delta_drone, delta_vel, delta_acc, delta_jerk, delta_snap, delta_ineq, delta_aggressive;
-    float buffer, prox_obs, prox_agent, dist_stop;
+    float buffer, prox_obs, prox_agent, dist_stop, warm_start_decay;
     float lx_drone, ly_drone, lz_drone;
 
     float x_min, y_min, z_min,
@@ -49,13 +158,14 @@ struct probData
             res_x_snap_norm, res_y_snap_norm, res_z_snap_norm,
             res_x_ineq_norm, res_y_ineq_norm, res_z_ineq_norm;
 
-    Eigen :: ArrayXXf agents_x, agents_y, agents_z;
-    Eigen :: ArrayXXf cost_smoothness, cost_goal, cost_vel, cost_acc, cost_jerk, cost_snap, cost_ineq, I;
+    const trajectoryBoard *board;
+    size_t board_epoch;
+    obstacleBVH obs_bvh;
+    std :: vector<int> candidates;
+    Eigen :: ArrayXXf I;
 
-    Eigen :: ArrayXXf P, Pdot, Pddot, Pdddot, Pddddot;  
-    Eigen :: ArrayXXf P_up, Pdot_up, Pddot_up, Pdddot_up, Pddddot_up;
-
-    Eigen :: ArrayXXf A_ineq, A_v_ineq, A_a_ineq, A_j_ineq, A_s_ineq, A_eq, A_static_obs, A_drone;
+    // Bernstein matrices, constraint matrices and constant costs are read from basis
+    repeatedBlock A_static_obs, A_drone;
 
     Eigen :: ArrayXXf B_x_ineq, B_y_ineq, B_z_ineq;
     Eigen :: ArrayXXf b_x_ineq, b_y_ineq, b_z_ineq;
@@ -90,11 +200,19 @@ struct probData
     Eigen :: ArrayXXf alpha_static_obs, alpha_drone, alpha_vel, alpha_acc, alpha_jerk, alpha_snap;
     Eigen :: ArrayXXf beta_drone, beta_vel, beta_acc, beta_jerk, beta_snap; 
 
+    // Unit directions (cos(alpha)sin(beta), sin(alpha)sin(beta), cos(beta)) of the polar variables,
+    // in 2D just (cos(alpha), sin(alpha))
+    Eigen :: ArrayXXf dir_x_static_obs, dir_y_static_obs;
+    Eigen :: ArrayXXf dir_x_drone, dir_y_drone, dir_z_drone;
+    Eigen :: ArrayXXf dir_x_vel, dir_y_vel, dir_z_vel, dir_x_acc, dir_y_acc, dir_z_acc;
+    Eigen :: ArrayXXf dir_x_jerk, dir_y_jerk, dir_z_jerk, dir_x_snap, dir_y_snap, dir_z_snap;
+
     Eigen :: ArrayXXf x_static_obs, y_static_obs, z_static_obs;
-    Eigen :: ArrayXXf x_static_obs_og, y_static_obs_og, z_static_obs_og;
     Eigen :: ArrayXXf x_drone, y_drone, z_drone;
     Eigen :: ArrayXXf a_static_obs, b_static_obs, c_static_obs;
-    Eigen :: ArrayXXf a_static_obs_og, b_static_obs_og, c_static_obs_og;  
+    // Every obstacle of the map, one record each
+    Eigen :: ArrayXf x_static_obs_og, y_static_obs_og, z_static_obs_og;
+    Eigen :: ArrayXf a_static_obs_og, b_static_obs_og, c_static_obs_og;
     Eigen :: ArrayXXf a_drone, b_drone, c_drone;
 
     Eigen :: ArrayXXf x, y, z,
@@ -111,6 +229,13 @@ struct probData
     Eigen :: ArrayXXf lamda_x, lamda_y, lamda_z;
     Eigen :: ArrayXXf lamda_x_ineq, lamda_y_ineq, lamda_z_ineq;        
 
+    std :: shared_ptr<const basisCache> basis;
+    kktCache kkt_xy, kkt_z;
+    amWorkspace ws;
+    size_t num_allocs;
+    stepTelemetry step_telemetry;
+    telemetryRing telemetry;
+
     std :: vector<float> smoothness, arc_length, inter_agent_dist, agent_obs_dist, inter_agent_dist_min, agent_obs_dist_min;
     std :: vector<std :: vector<float>> pos_static_obs, dim_static_obs;
 
@@ -126,4 +251,17 @@ Eigen :: ArrayXXf reshape(Eigen :: ArrayXXf x, uint32_t r, uint32_t c);
 Eigen :: ArrayXXf arctan2(Eigen :: ArrayXXf arr1, Eigen :: ArrayXXf arr2);
 Eigen :: ArrayXXf maximum(float val, Eigen :: ArrayXXf arr2);
 Eigen :: ArrayXXf delete_values(float val, Eigen :: ArrayXXf arr);
-Eigen :: ArrayXXf diff(Eigen :: ArrayXXf arr);
\ No newline at end of file
+Eigen :: ArrayXXf diff(Eigen :: ArrayXXf arr);
+void reserveWorkspace(probData &prob_data, int num_blocks);
+void initRepeatedBlock(repeatedBlock &A, const Eigen :: ArrayXXf &block, const Eigen :: MatrixXf &gram, int num_blocks);
+Eigen :: ArrayXXf repeatedGram(const repeatedBlock &A);
+Eigen :: ArrayXXf repeatedTransposeTimes(repeatedBlock &A, const Eigen :: ArrayXXf &b);
+void subRepeatedTransposeTimes(repeatedBlock &A, float alpha, const Eigen :: Ref<const Eigen :: VectorXf> &b, Eigen :: Ref<Eigen :: MatrixXf> out);
+void buildGrid(spatialGrid &grid, const Eigen :: ArrayXXf &boxes, float cell);
+void queryGrid(const spatialGrid &grid, float x_min, float y_min, float x_max, float y_max, std :: vector<int> &out);
+void buildBVH(obstacleBVH &bvh, const Eigen :: ArrayXXf &boxes);
+void queryBVH(const obstacleBVH &bvh, float x_min, float y_min, float x_max, float y_max, std :: vector<int> &out);
+void initBoard(trajectoryBoard &board, int num_agents, int num, float grid_cell);
+void publishTrajectory(trajectoryBoard &board, int id, const Eigen :: ArrayXXf &x, const Eigen :: ArrayXXf &y, const Eigen :: ArrayXXf &z);
+void flipBoard(trajectoryBoard &board);
+int boardFront(const trajectoryBoard &board);
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+#include <eigen3/Eigen/Dense>
+#include <memory>
+#include <vector>
+
+class QProblem;
+
+/**
+ * Persistent active-set QP of one agent on top of the vendored qpOASES (sized by
+ * algorithm/scp/qpoases_interface.hpp), for the same problem as Eigen::QuadProgDense
+ *     min 0.5 x^T Q x + q^T x   s.t.   A_eq x = b_eq,   A_ineq x <= b_ineq
+ * Consecutive MPC steps have nearly the same active set, so the solver is never started from an
+ * empty working set once it has a solution. With Q and the constraint matrix unchanged the previous
+ * QP is continued by QProblem::hotstart, otherwise the working set is guessed from the previous
+ * multipliers moved along dual_map. A failed warm solve is repeated cold.
+ */
+class HotQP{
+    public:
+        HotQP(int max_nwsr);
+        ~HotQP();
+        // Whether nv variables and nc equality plus inequality rows fit the static qpOASES arrays
+        static bool fits(int nv, int nc);
+        // dual_map[i] is the row of the previous solve whose multiplier seeds row i of [A_eq; A_ineq],
+        // -1 for none. Ignored for rows beyond the previous row count
+        bool solve(const Eigen :: MatrixXd &Q, const Eigen :: VectorXd &q,
+                    const Eigen :: MatrixXd &A_eq, const Eigen :: VectorXd &b_eq,
+                    const Eigen :: MatrixXd &A_ineq, const Eigen :: VectorXd &b_ineq,
+                    const std :: vector<int> &dual_map);
+        const Eigen :: VectorXd &result() const;
+        int fail() const;
+        // Working set changes of the last solve, including a cold retry
+        int changes() const;
+        // 0 cold, 1 warm (guessed working set), 2 hot (QProblem::hotstart)
+        int start() const;
+    private:
+        std :: unique_ptr<QProblem> qp;
+        Eigen :: Matrix<double, Eigen :: Dynamic, Eigen :: Dynamic, Eigen :: RowMajor> A;
+        Eigen :: MatrixXd H;
+        Eigen :: VectorXd g, lbA, ubA, x, y, y_guess;
+        int max_nwsr, status, num_changes, start_type;
+        bool solved;
+};
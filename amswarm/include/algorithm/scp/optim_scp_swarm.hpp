@@ -2,6 +2,8 @@
 #include <eigen3/Eigen/Dense>
 #include <vector>
 #include "yaml-cpp/yaml.h"
+#include "algorithm/scp/sparse_qp.hpp"
+#include "algorithm/scp/hot_qp.hpp"
 
 
 struct five_var
@@ -9,13 +11,38 @@ struct five_var
     Eigen :: ArrayXXf a, b, c, d, e;
 };       
 
+struct scpWorkspace
+{
+    // QP buffers in double precision. The bound rows [pos; vel; acc], the equality rows and the
+    // goal/smoothness cost are assembled once by assembleConstraints, A_ineq holds
+    // [bound; collision; slack >= 0; trust region] rows and a linearization only overwrites the
+    // collision rows and the trust region bounds
+    Eigen :: MatrixXd A_bound, cost;
+    Eigen :: VectorXd b_bound, lincost;
+    Eigen :: MatrixXd Q, A_eq, A_ineq;
+    Eigen :: VectorXd q, b_eq, b_ineq;
+
+    // Seeds the "qpoases" and "admm" warm starts, see HotQP::solve
+    std :: vector<int> dual_map;
+    int num_trust;
+
+    // Sparse copies for "admm" with a pattern fixed per layout (new_layout is set by reserveQP when
+    // it resized the buffers). In between only the collision rows, which keep all their variable
+    // columns in the pattern, the slack weights and the soft rows A_pen of "penalty" are rewritten
+    Eigen :: SparseMatrix<double> Q_sp, A_eq_sp, A_ineq_sp, A_pen_sp;
+    Eigen :: MatrixXd A_pen;
+    Eigen :: VectorXd b_pen;
+    bool new_layout;
+};
+
 struct probData
 {
     bool mpc, free_space, on_demand;
-    int num, num_up, num_ctrl, nvar, kappa, VERBOSE, mpc_step, max_time, num_static_obs, num_drone, qp_fail, id_badge, colliding_step, world;
+    int num, num_up, num_ctrl, nvar, kappa, VERBOSE, mpc_step, max_time, num_static_obs, num_drone, qp_fail, id_badge, colliding_step, world, num_slack, scp_max_iter;
 
     float dt, t_plan, weight_smoothness, weight_goal, weight_quad_slack, weight_lin_slack, dist_to_goal, dist_stop, buffer, weight_lin_slack_og, weight_quad_slack_og;
     float vel_max, acc_max, prox_obs, prox_agent, lx_drone, ly_drone, lz_drone, rmin;
+    float trust_region, scp_tol_cost, scp_tol_coll;
 
     float x_min, y_min, z_min,
             x_max, y_max, z_max,
@@ -30,8 +57,8 @@ struct probData
 
     Eigen :: ArrayXXf A_coll, b_coll;
     Eigen :: ArrayXXf agents_x, agents_y, agents_z; 
-    Eigen :: ArrayXXf A_eq, A_ineq, A_obs, cost_goal, cost_smoothness, cost_slack;
-    Eigen :: ArrayXXf b_eq, b_ineq, lincost_goal;
+    Eigen :: ArrayXXf A_obs, cost_goal, cost_smoothness;
+    Eigen :: ArrayXXf lincost_goal;
 
     Eigen :: ArrayXXf P, Pdot, Pddot, Pdddot, Pddddot;  
     Eigen :: ArrayXXf P_up, Pdot_up, Pddot_up, Pdddot_up, Pddddot_up;
@@ -58,7 +85,13 @@ struct probData
                         xddot_up, yddot_up, zddot_up;
     
     std :: vector<float> smoothness, arc_length, inter_agent_dist, agent_obs_dist, inter_agent_dist_min, agent_obs_dist_min;
-    std :: string solver;
+    // qpoases working set changes of every QP solve (-1 if it ran on quadprog) and linearizations of every MPC step
+    std :: vector<int> qp_changes, scp_iters;
+    std :: string solver, slack_mode;
+    sparseQPSettings qp_settings;
+    std :: shared_ptr<HotQP> hot_qp;
+    std :: shared_ptr<SparseQP> sparse_qp;
+    scpWorkspace ws;
     YAML :: Node params;
 
     std :: vector<std :: vector<float>> pos_static_obs, dim_static_obs;
@@ -74,11 +107,16 @@ Eigen :: ArrayXXf delete_values(float val, Eigen :: ArrayXXf arr);
 Eigen :: ArrayXXf block_diag(Eigen :: ArrayXXf arr1, Eigen :: ArrayXXf arr2);
 Eigen :: ArrayXXf diff(Eigen :: ArrayXXf arr);
 
+void assembleConstraints(probData &prob_data);
+void reserveQP(probData &prob_data, int num_coll_rows, int scp_iter);
+void updateSparseQP(probData &prob_data, int num_coll_rows, bool penalty);
+float collisionViolation(probData &prob_data);
 int computeXYZ(probData &prob_data, int VERBOSE);
 
 void initObstacles(probData &prob_data, int VERBOSE);
 void neigbhoringAgents(probData &prob_data, int VERBOSE);
 
+Eigen :: ArrayXXf addCollisionSlack(probData &prob_data, Eigen :: ArrayXXf A_f);
 void continuousCA(probData &prob_data, int VERBOSE);
 void ondemandCA(probData &prob_data, int VERBOSE);
 int collidingStep(probData &prob_data, int VERBOSE);
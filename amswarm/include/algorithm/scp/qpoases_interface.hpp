@@ -0,0 +1,10 @@
+#pragma once
+// qpOASES sizes for the SCP planner (QPOASES_CUSTOM_INTERFACE of lib_scp_swarm). Fits the condensed
+// formulations, 33 + num_obs variables and 9 + 18*num + num_obs*(num + 1) rows (66 more for the trust
+// region with scp_max_iter > 1), up to 31 obstacles at num = 30. Larger QPs are solved by QuadProgDense instead
+#define QPOASES_NVMAX      64
+#define QPOASES_NCMAX      1600
+#define QPOASES_NWSRMAX    2000
+#define QPOASES_PRINTLEVEL PL_NONE
+#define QPOASES_EPS        2.221e-16
+typedef double real_t;
@@ -0,0 +1,68 @@
+#pragma once
+#include <eigen3/Eigen/Dense>
+#include <eigen3/Eigen/Sparse>
+#include <eigen3/Eigen/SparseCholesky>
+#include <vector>
+
+struct sparseQPSettings
+{
+    int max_iter;
+    double rho, eps_abs, eps_rel;
+};
+
+/**
+ * Sparse alternative to Eigen::QuadProgDense for the SCP problems, an operator splitting (ADMM)
+ * solver in the style of OSQP for
+ *     min 0.5 x^T P x + q^T x   s.t.   A_eq x = b_eq,   A_ineq x <= b_ineq
+ * Both constraint sets are handled as l <= A x <= u on a Ruiz-equilibrated copy of the problem.
+ * Every iteration solves the reduced KKT system (P + sigma I + A^T diag(rho) A) with a sparse
+ * LDL^T factorization, which is only refactored when the step size rho is adapted. Once the
+ * residuals converge the active set guessed from the multipliers is polished by one equality
+ * constrained solve, which replaces the iterate by an exact solution when it checks out.
+ *
+ * One instance is kept per agent. While the sparsity pattern of P and [A_eq; A_ineq; A_pen] is
+ * that of the previous solve, only the values are copied in and the Ruiz scaling and the
+ * fill-reducing ordering of the KKT factorization are kept. After a converged solve the next one
+ * starts from its primal point, its multipliers (moved along dual_map as in HotQP::solve) and rho.
+ */
+class SparseQP{
+    public:
+        SparseQP(const sparseQPSettings &settings);
+        // Soft rows A_pen x <= b_pen for the following solves (an empty A_pen removes them), a
+        // violation t >= 0 of a row is charged w_lin t + 0.5 w_quad t^2 in the cost instead of
+        // being forbidden (an exact penalty for w_lin larger than the row multiplier)
+        void penalize(const Eigen :: SparseMatrix<double> &A_pen, const Eigen :: VectorXd &b_pen, double w_lin, double w_quad);
+        // dual_map[i] is the row of the previous solve whose multiplier seeds row i of [A_eq; A_ineq],
+        // -1 for none. Ignored for rows beyond its size
+        bool solve(const Eigen :: SparseMatrix<double> &P, const Eigen :: VectorXd &q,
+                    const Eigen :: SparseMatrix<double> &A_eq, const Eigen :: VectorXd &b_eq,
+                    const Eigen :: SparseMatrix<double> &A_ineq, const Eigen :: VectorXd &b_ineq,
+                    const std :: vector<int> &dual_map);
+        const Eigen :: VectorXd &result() const;
+        // 0 when converged, 1 on the iteration limit, 2 when the KKT factorization failed
+        int fail() const;
+        int iterations() const;
+    private:
+        sparseQPSettings settings;
+        Eigen :: SparseMatrix<double> P, A, K;
+        Eigen :: VectorXd q, l, u, rho, D, E;
+        double c, rho_ineq;
+        Eigen :: SparseMatrix<double> A_pen;
+        Eigen :: VectorXd b_pen, pen_lin, pen_quad;
+        double w_lin, w_quad;
+        int m_eq, m_hard;
+        // x_out and y_out are the unscaled solution and multipliers
+        Eigen :: VectorXd x, z, y, x_out, y_out;
+        Eigen :: SimplicialLDLT<Eigen :: SparseMatrix<double>> ldlt;
+        int status, num_iter;
+        bool setup;
+
+        bool restack(const Eigen :: SparseMatrix<double> &P, const Eigen :: SparseMatrix<double> &A_eq, const Eigen :: SparseMatrix<double> &A_ineq);
+        void scale();
+        void scaleBounds();
+        bool factorize(bool analyze);
+        void project(const Eigen :: VectorXd &v);
+        void residuals(const Eigen :: VectorXd &x, const Eigen :: VectorXd &z, const Eigen :: VectorXd &y,
+                        double &res_prim, double &res_dual, double &tol_prim, double &tol_dual) const;
+        bool polish();
+};
@@ -0,0 +1,36 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+/**
+ * Persistent worker pool for the per-step agent solves, shared by the AM and SCP simulators.
+ * run(num_tasks, task) wakes the workers, each idle worker claims the next unclaimed agent
+ * index until all are taken (so a long solve never holds up the short ones queued behind it),
+ * and returns once every task of the step has finished.
+ */
+class AgentPool{
+    public:
+        // num_threads <= 0 uses one worker per hardware thread, at most max_tasks (one per agent) are
+        // started. pin_threads binds worker i to cpu i
+        AgentPool(int num_threads, int max_tasks, bool pin_threads);
+        ~AgentPool();
+        void run(int num_tasks, const std :: function<void(int)> &task);
+        int size() const;
+    private:
+        std :: vector<std :: thread> workers;
+        std :: mutex mtx;
+        std :: condition_variable cv_start, cv_done;
+
+        // Step state, written by run() under mtx while no worker is active
+        const std :: function<void(int)> *step_task;
+        int step_size, num_done, num_active;
+        size_t epoch;
+        bool stop;
+        std :: atomic<int> next_task;
+
+        void work(int id, bool pin_thread);
+};
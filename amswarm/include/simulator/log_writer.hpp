@@ -0,0 +1,42 @@
+#pragma once
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+/**
+ * Writer thread for the per-step simulation outputs. The simulation thread fills fixed-size float
+ * frames in a single-producer single-consumer ring (acquire(), then publish()), the writer drains
+ * whatever is queued, hands each frame to write_frame and calls flush once per drained batch.
+ * Neither side takes a lock; an empty writer or, with block, a full producer sleeps briefly.
+ * Without block a frame arriving at a full ring is dropped and counted.
+ */
+class LogWriter{
+    public:
+        LogWriter(int frame_size, int queue_frames, bool block,
+                    const std :: function<void(const float*)> &write_frame, const std :: function<void()> &flush);
+        ~LogWriter();
+        // Slot for the next frame, nullptr when the ring is full and the frame is dropped
+        float *acquire();
+        // Hands the acquired slot to the writer
+        void publish();
+        // Writes the queued frames and joins the writer thread
+        void close();
+        size_t dropped() const;
+    private:
+        std :: vector<float> ring;
+        int frame_size;
+        size_t capacity;
+        bool block;
+        std :: function<void(const float*)> write_frame;
+        std :: function<void()> flush;
+
+        // head is written by the producer only, tail by the writer only
+        alignas(64) std :: atomic<size_t> head;
+        alignas(64) std :: atomic<size_t> tail;
+        std :: atomic<bool> stop;
+        size_t num_dropped;
+        std :: thread worker;
+
+        void work();
+};
@@ -2,20 +2,38 @@
 #include <fstream>
 #include <chrono>
 #include <sstream>
+#include <memory>
+#include <numeric>
 #include "algorithm/amswarm/run_trajectory_optimizer.hpp"
+#include "simulator/agent_pool.hpp"
+#include "simulator/trajectory_log.hpp"
+#include "simulator/log_writer.hpp"
 
 class Simulator{
     public:
         bool success;
-        Simulator(int cf_num, bool read_cf, int num_drones, bool use_model, std::vector<float> noise);
+        // Mission time [s], mean compute time per agent and MPC step [s] and mean AM iterations, set by runSimulation()
+        float mission_time, comp_time, am_iters;
+        // pool_size >= 0 overrides the pool_size of config_am_swarm.yaml
+        Simulator(int cf_num, bool read_cf, int num_drones, bool use_model, std::vector<float> noise, int pool_size = -1);
         void runSimulation();
         void saveMetrics();
     private:
-        std :: ofstream save_data, save_data_2, save_data_3, save_data_4;
+        std :: ofstream save_data, save_data_2, save_data_3, save_data_4, save_steps;
 
         std :: string path;
         YAML :: Node params;
 
+        // Binary trajectory log replacing the sim_data text dumps, null with log_format text
+        bool binary_log;
+        int log_chunk_frames;
+        std :: unique_ptr<TrajectoryLog> traj_log;
+        std :: vector<float> log_frame;
+        // Writer thread taking the frames off the simulation thread, null with log_async false
+        bool log_async, log_block;
+        int log_queue_frames;
+        std :: unique_ptr<LogWriter> log_writer;
+
         int config_num;
         int VERBOSE;
         int num;
@@ -36,15 +54,13 @@ class Simulator{
         float dt;
 
         bool out_space;
-        float mission_time;
         bool collision_agent, collision_obstacle;
         std :: chrono :: duration<double, std::milli> total_time;
 
-        probData *prob_data;
+        std :: unique_ptr<probData[]> prob_data;
+        std :: unique_ptr<AgentPool> pool;
 
-        Eigen :: ArrayXXf agents_x, 
-                        agents_y, 
-                        agents_z;
+        std :: unique_ptr<trajectoryBoard> board;
 
         Eigen :: ArrayXf smoothness,
                         arc_length,
@@ -57,7 +73,7 @@ class Simulator{
         std :: vector<std :: vector<float>> _pos_static_obs;
         std :: vector<std :: vector<float>> _dim_static_obs;
 
-        std :: vector <float> smoothness_agent, traj_length_agent, comp_time_agent, inter_agent_dist, agent_obs_dist;
+        std :: vector <float> smoothness_agent, traj_length_agent, comp_time_agent, iter_agent, inter_agent_dist, agent_obs_dist;
         int num_obs, num_obs_2;    
 
 
@@ -68,4 +84,11 @@ class Simulator{
         void checkAtGoal();
         void checkViolation();
         void calculateDistances();
+        void saveTelemetry();
+        void openLogs();
+        void closeLogs();
+        void logStep();
+        void packFrame(float *frame);
+        void writeFrame(const float *frame);
+        void flushLogs();
 };
\ No newline at end of file
@@ -1,7 +1,9 @@
 #pragma once
 #include <fstream>
 #include <chrono>
+#include <memory>
 #include "algorithm/scp/optim_scp_swarm.hpp"
+#include "simulator/agent_pool.hpp"
 
 class Simulator{
     public:
@@ -10,7 +12,7 @@ class Simulator{
         void runSimulation();
         void saveMetrics();
     private:
-        std :: ofstream save_data, save_data_2;
+        std :: ofstream save_data, save_data_2, save_qp;
 
         std :: string path;
         YAML :: Node params;
@@ -37,7 +39,8 @@ class Simulator{
         bool collision_agent, collision_obstacle;
         std :: chrono :: duration<double, std::milli> total_time;
 
-        probData *prob_data;
+        std :: unique_ptr<probData[]> prob_data;
+        std :: unique_ptr<AgentPool> pool;
 
         Eigen :: ArrayXXf agents_x, 
                         agents_y, 
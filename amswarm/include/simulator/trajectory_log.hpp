@@ -0,0 +1,48 @@
+#pragma once
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/**
+ * Binary replacement of the sim_data*.txt dumps, read back by data/sim_log.py.
+ *
+ * Layout (little endian):
+ *   char[8]  magic "AMSWLOG"
+ *   int32    version, header_bytes, num_drone, num, num_up, up_steps, num_obs, chunk_frames
+ *   float32  dt, a_drone, b_drone, c_drone
+ *   float32  init[num_drone][3], goal[num_drone][3], pos_obs[num_obs][3], dim_obs[num_obs][3]
+ * followed by one fixed-size float32 frame per MPC step:
+ *   step     MPC step index (an exact integer), steps dropped by a full log queue leave gaps
+ *   board    x, y, z planned trajectories, [3][num_drone][num]
+ *   up       x, y, z upsampled commands over the first step, [3][pos, vel, acc][num_drone][up_steps]
+ *
+ * With chunk_frames == 0 the frames are stored raw and the file can be memory mapped as is,
+ * otherwise every chunk_frames frames are deflated as one block preceded by
+ * uint32 num_frames, uint32 num_bytes.
+ */
+struct trajLogInfo
+{
+    int num_drone, num, num_up, up_steps, num_obs;
+    float dt, a_drone, b_drone, c_drone;
+    std :: vector<std :: vector<float>> init_drone, goal_drone, pos_static_obs, dim_static_obs;
+};
+
+class TrajectoryLog{
+    public:
+        // chunk_frames > 0 needs zlib (AMSWARM_HAVE_ZLIB), without it the frames are stored raw
+        TrajectoryLog(const std :: string &file_name, const trajLogInfo &info, int chunk_frames);
+        ~TrajectoryLog();
+        // Appends one frame, 1 + 3*num_drone*num + 9*num_drone*up_steps floats
+        void writeFrame(const float *frame);
+        // Pushes the frames written so far to the file, a pending compressed chunk stays buffered
+        void flush();
+        void close();
+    private:
+        std :: ofstream file;
+        int frame_size, chunk_frames, num_pending;
+        std :: vector<float> chunk;
+        std :: vector<unsigned char> deflated;
+
+        void flushChunk();
+};
@@ -0,0 +1,83 @@
+#include "algorithm/amswarm/alloc_counter.hpp"
+
+#ifdef AMSWARM_COUNT_ALLOCS
+
+#include <cerrno>
+
+// Interposes the glibc allocator, Eigen and operator new both end up here
+extern "C" {
+    void *__libc_malloc(size_t size);
+    void *__libc_calloc(size_t num, size_t size);
+    void *__libc_realloc(void *ptr, size_t size);
+    void *__libc_memalign(size_t alignment, size_t size);
+}
+
+// initial-exec keeps the counter in static TLS, dynamic TLS setup may itself call malloc
+static __thread size_t thread_alloc_count __attribute__((tls_model("initial-exec"))) = 0;
+
+extern "C" void *malloc(size_t size)
+{
+    thread_alloc_count++;
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t num, size_t size)
+{
+    thread_alloc_count++;
+    return __libc_calloc(num, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size)
+{
+    thread_alloc_count++;
+    return __libc_realloc(ptr, size);
+}
+
+extern "C" void *memalign(size_t alignment, size_t size)
+{
+    thread_alloc_count++;
+    return __libc_memalign(alignment, size);
+}
+
+extern "C" int posix_memalign(void **ptr, size_t alignment, size_t size)
+{
+    // alignment must be a power of two multiple of sizeof(void *), *ptr is left untouched on failure
+    if(alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0)
+        return EINVAL;
+    thread_alloc_count++;
+    void *mem = __libc_memalign(alignment, size);
+    if(mem == nullptr)
+        return ENOMEM;
+    *ptr = mem;
+    return 0;
+}
+
+extern "C" void *aligned_alloc(size_t alignment, size_t size)
+{
+    thread_alloc_count++;
+    return __libc_memalign(alignment, size);
+}
+
+bool allocCountEnabled()
+{
+    return true;
+}
+
+size_t threadAllocCount()
+{
+    return thread_alloc_count;
+}
+
+#else
+
+bool allocCountEnabled()
+{
+    return false;
+}
+
+size_t threadAllocCount()
+{
+    return 0;
+}
+
+#endif
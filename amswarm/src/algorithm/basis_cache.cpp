@@ -0,0 +1,186 @@
+#include "algorithm/amswarm/basis_cache.hpp"
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <sstream>
+#include <cstdio>
+#include <unistd.h>
+
+typedef std :: tuple<int, int, float, int, int, bool> basisKey;
+
+static std :: mutex basis_mtx;
+// Held by the agents only, an entry nobody uses is freed and built again (or read from disk) on the next request
+static std :: map<basisKey, std :: weak_ptr<const basisCache>> basis_entries;
+
+static const char BASIS_MAGIC[8] = "AMSWBAS";
+static const int BASIS_VERSION = 1;
+
+// Every matrix of the entry, in file order
+static std :: vector<Eigen :: ArrayXXf*> basisArrays(basisCache &basis)
+{
+    return {&basis.P, &basis.Pdot, &basis.Pddot, &basis.Pdddot, &basis.Pddddot,
+            &basis.P_up, &basis.Pdot_up, &basis.Pddot_up, &basis.Pdddot_up, &basis.Pddddot_up,
+            &basis.A_ineq, &basis.A_eq, &basis.A_v_ineq, &basis.A_a_ineq, &basis.A_j_ineq, &basis.A_s_ineq,
+            &basis.cost_smoothness, &basis.cost_goal, &basis.cost_vel, &basis.cost_acc, &basis.cost_jerk, &basis.cost_snap, &basis.cost_ineq};
+}
+
+void computeBasis(basisCache &basis, int num, int num_up, float t_plan, int kappa, int order_smoothness, bool axis_wise)
+{
+    // @ Compute Bernstein P, Pdot, Pddot,... matrix
+    Eigen :: ArrayXf tot_time = Eigen :: ArrayXf(num);
+    Eigen :: ArrayXf tot_time_up = Eigen :: ArrayXf(num_up);
+
+    tot_time.setLinSpaced(num, 0.0, t_plan);
+    tot_time_up.setLinSpaced(num_up, 0.0, t_plan);
+
+    five_var PPP = computeBernstein(tot_time, t_plan, num);
+    basis.P = PPP.a;
+    basis.Pdot = PPP.b;
+    basis.Pddot = PPP.c;
+    basis.Pdddot = PPP.d;
+    basis.Pddddot = PPP.e;
+
+    five_var PPP_up = computeBernstein(tot_time_up, t_plan, num_up);
+    basis.P_up = PPP_up.a;
+    basis.Pdot_up = PPP_up.b;
+    basis.Pddot_up = PPP_up.c;
+    basis.Pdddot_up = PPP_up.d;
+    basis.Pddddot_up = PPP_up.e;
+
+    // @ Position Constraints and Initial Conditions
+    basis.A_ineq = stack(basis.P, -basis.P, 'v');
+    basis.A_eq = stack(basis.P.row(0), stack(basis.Pdot.row(0), basis.Pddot.row(0), 'v'), 'v');
+
+    // @ Warm start, multipliers are P^T mu for samples mu, shift mu by one sample in dual space
+    Eigen :: MatrixXf shift = Eigen :: MatrixXf :: Zero(num, num);
+    for(int i = 0; i < num - 1; i++) shift(i, i + 1) = 1.0;
+    shift(num - 1, num - 1) = 1.0;
+
+    basis.gram_P = basis.P.matrix().transpose() * basis.P.matrix();
+    basis.shift_dual = basis.P.matrix().transpose() * shift * basis.P.matrix() * basis.gram_P.inverse();
+
+    // @ Axis-wise Velocity, Acceleration, Jerk and Snap Constraints
+    if(axis_wise){
+        basis.A_v_ineq = stack(basis.Pdot, -basis.Pdot, 'v');
+        basis.A_a_ineq = stack(basis.Pddot, -basis.Pddot, 'v');
+        basis.A_j_ineq = stack(basis.Pdddot, -basis.Pdddot, 'v');
+        basis.A_s_ineq = stack(basis.Pddddot, -basis.Pddddot, 'v');
+    }
+
+    // @ Constant Costs
+    basis.cost_ineq = basis.A_ineq.transpose().matrix() * basis.A_ineq.matrix();
+    if(order_smoothness == 4)
+        basis.cost_smoothness = basis.Pddddot.transpose().matrix() * basis.Pddddot.matrix();
+    else if(order_smoothness == 3)
+        basis.cost_smoothness = basis.Pdddot.transpose().matrix() * basis.Pdddot.matrix();
+    else if(order_smoothness == 2)
+        basis.cost_smoothness = basis.Pddot.transpose().matrix() * basis.Pddot.matrix();
+    else
+        ROS_ERROR_STREAM("Invalid order_smoothness value");
+
+    basis.cost_goal = basis.P.bottomRows(kappa).transpose().matrix() * basis.P.bottomRows(kappa).matrix();
+
+    if(!axis_wise){
+        basis.cost_vel = basis.Pdot.transpose().matrix() * basis.Pdot.matrix();
+        basis.cost_acc = basis.Pddot.transpose().matrix() * basis.Pddot.matrix();
+        basis.cost_jerk = basis.Pdddot.transpose().matrix() * basis.Pdddot.matrix();
+        basis.cost_snap = basis.Pddddot.transpose().matrix() * basis.Pddddot.matrix();
+    }
+    else{
+        basis.cost_vel = basis.A_v_ineq.transpose().matrix() * basis.A_v_ineq.matrix();
+        basis.cost_acc = basis.A_a_ineq.transpose().matrix() * basis.A_a_ineq.matrix();
+        basis.cost_jerk = basis.A_j_ineq.transpose().matrix() * basis.A_j_ineq.matrix();
+        basis.cost_snap = basis.A_s_ineq.transpose().matrix() * basis.A_s_ineq.matrix();
+    }
+}
+
+static std :: string basisFileName(const std :: string &cache_dir, int num, int num_up, float t_plan, int kappa, int order_smoothness, bool axis_wise)
+{
+    std :: string dir = cache_dir;
+    if(dir[0] != '/')
+        dir = ros :: package :: getPath("amswarm") + "/" + dir;
+
+    std :: stringstream file_name;
+    file_name << dir << "/basis_num_" << num << "_up_" << num_up << "_t_" << t_plan << "_kappa_" << kappa
+                << "_order_" << order_smoothness << (axis_wise ? "_ax" : "_qd") << ".bin";
+    return file_name.str();
+}
+
+static void writeArray(std :: ofstream &file, const Eigen :: ArrayXXf &arr)
+{
+    int32_t size[2] = {(int32_t)arr.rows(), (int32_t)arr.cols()};
+    file.write(reinterpret_cast<const char*>(size), sizeof(size));
+    file.write(reinterpret_cast<const char*>(arr.data()), arr.size()*sizeof(float));
+}
+
+static bool readArray(std :: ifstream &file, Eigen :: ArrayXXf &arr)
+{
+    int32_t size[2];
+    if(!file.read(reinterpret_cast<char*>(size), sizeof(size)) || size[0] < 0 || size[1] < 0)
+        return false;
+    arr.resize(size[0], size[1]);
+    return (bool)file.read(reinterpret_cast<char*>(arr.data()), arr.size()*sizeof(float));
+}
+
+static bool loadBasis(basisCache &basis, const std :: string &file_name)
+{
+    std :: ifstream file(file_name, std :: ios :: binary);
+    char magic[8];
+    int32_t version;
+    if(!file.read(magic, 8) || !std :: equal(magic, magic + 8, BASIS_MAGIC))
+        return false;
+    if(!file.read(reinterpret_cast<char*>(&version), sizeof(version)) || version != BASIS_VERSION)
+        return false;
+    for(Eigen :: ArrayXXf *arr : basisArrays(basis))
+        if(!readArray(file, *arr))
+            return false;
+
+    Eigen :: ArrayXXf shift_dual;
+    if(!readArray(file, shift_dual))
+        return false;
+    basis.shift_dual = shift_dual.matrix();
+
+    // nvar x nvar, cheaper to form again than to store
+    basis.gram_P = basis.P.matrix().transpose() * basis.P.matrix();
+    return true;
+}
+
+static void saveBasis(basisCache &basis, const std :: string &file_name)
+{
+    // Written aside and renamed, concurrent runs never read a partial file
+    std :: string tmp_name = file_name + ".tmp" + std :: to_string(getpid());
+    std :: ofstream file(tmp_name, std :: ios :: binary);
+    if(!file.is_open()){
+        ROS_WARN_STREAM("Could not write the basis cache " << file_name);
+        return;
+    }
+    int32_t version = BASIS_VERSION;
+    file.write(BASIS_MAGIC, 8);
+    file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    for(Eigen :: ArrayXXf *arr : basisArrays(basis))
+        writeArray(file, *arr);
+    writeArray(file, basis.shift_dual.array());
+    file.close();
+    std :: rename(tmp_name.c_str(), file_name.c_str());
+}
+
+std :: shared_ptr<const basisCache> getBasis(int num, int num_up, float t_plan, int kappa, int order_smoothness, bool axis_wise, const std :: string &cache_dir)
+{
+    basisKey key(num, num_up, t_plan, kappa, order_smoothness, axis_wise);
+    std :: lock_guard<std :: mutex> lock(basis_mtx);
+    std :: weak_ptr<const basisCache> &entry = basis_entries[key];
+    if(std :: shared_ptr<const basisCache> shared = entry.lock())
+        return shared;
+
+    std :: shared_ptr<basisCache> basis = std :: make_shared<basisCache>();
+    std :: string file_name;
+    if(!cache_dir.empty())
+        file_name = basisFileName(cache_dir, num, num_up, t_plan, kappa, order_smoothness, axis_wise);
+    if(file_name.empty() || !loadBasis(*basis, file_name)){
+        computeBasis(*basis, num, num_up, t_plan, kappa, order_smoothness, axis_wise);
+        if(!file_name.empty())
+            saveBasis(*basis, file_name);
+    }
+    entry = basis;
+    return basis;
+}
@@ -0,0 +1,102 @@
+#include "algorithm/scp/hot_qp.hpp"
+#include <QProblem.hpp>
+
+HotQP :: HotQP(int max_nwsr) : max_nwsr(max_nwsr), status(1), num_changes(0), start_type(0), solved(false)
+{
+}
+
+HotQP :: ~HotQP()
+{
+}
+
+bool HotQP :: fits(int nv, int nc)
+{
+    return nv <= NVMAX && nc <= NCMAX;
+}
+
+bool HotQP :: solve(const Eigen :: MatrixXd &Q, const Eigen :: VectorXd &q,
+                    const Eigen :: MatrixXd &A_eq, const Eigen :: VectorXd &b_eq,
+                    const Eigen :: MatrixXd &A_ineq, const Eigen :: VectorXd &b_ineq,
+                    const std :: vector<int> &dual_map){
+    int nv = Q.rows(), neq = A_eq.rows(), nc = neq + A_ineq.rows();
+    bool same_dims = solved && qp->getNV() == nv && qp->getNC() == nc;
+    bool same_data = same_dims && H == Q && A.topRows(neq) == A_eq && A.bottomRows(nc - neq) == A_ineq;
+
+    if(!same_data){
+        H = Q;
+        A.resize(nc, nv);
+        A << A_eq, A_ineq;
+    }
+    g = q;
+    lbA.resize(nc);
+    ubA.resize(nc);
+    lbA << b_eq, Eigen :: VectorXd :: Constant(nc - neq, -INFTY);
+    ubA << b_eq, b_ineq;
+
+    returnValue ret = RET_HOTSTART_FAILED;
+    num_changes = 0;
+    if(same_data){
+        // @ Hot start, homotopy from the previous QP keeping its factorization
+        start_type = 2;
+        int nwsr = max_nwsr;
+        ret = qp->hotstart(g.data(), 0, 0, lbA.data(), ubA.data(), nwsr, 0);
+        num_changes += nwsr;
+    }
+    else if(solved){
+        // @ Warm start, the working set is read off the signs of the mapped multipliers
+        start_type = 1;
+        int nv_prev = qp->getNV(), nc_prev = qp->getNC();
+        y_guess.setZero(nv + nc);
+        for(int i = 0; i < nc && i < (int)dual_map.size(); i++)
+            if(dual_map[i] >= 0 && dual_map[i] < nc_prev)
+                y_guess(nv + i) = y(nv_prev + dual_map[i]);
+
+        // init on a used QProblem keeps the old factorization and cycling data, which stalls the
+        // homotopy from the guessed working set
+        if(!same_dims)
+            qp.reset(new QProblem(nv, nc));
+        else
+            qp->reset();
+        int nwsr = max_nwsr;
+        ret = qp->init(H.data(), g.data(), A.data(), 0, 0, lbA.data(), ubA.data(), nwsr, y_guess.data());
+        num_changes += nwsr;
+    }
+
+    if(ret != SUCCESSFUL_RETURN){
+        // @ Cold start from the equality rows only
+        start_type = 0;
+        qp.reset(new QProblem(nv, nc));
+        int nwsr = max_nwsr;
+        ret = qp->init(H.data(), g.data(), A.data(), 0, 0, lbA.data(), ubA.data(), nwsr, 0);
+        num_changes += nwsr;
+    }
+
+    x.resize(nv);
+    y.resize(nv + nc);
+    qp->getPrimalSolution(x.data());
+    qp->getDualSolution(y.data());
+
+    status = ret == SUCCESSFUL_RETURN ? 0 : 1;
+    solved = status == 0;
+    return solved;
+}
+
+const Eigen :: VectorXd &HotQP :: result() const
+{
+    return x;
+}
+
+int HotQP :: fail() const
+{
+    return status;
+}
+
+int HotQP :: changes() const
+{
+    return num_changes;
+}
+
+int HotQP :: start() const
+{
+    return start_type;
+}
@@ -3,47 +3,43 @@
 
 void initObstacles(probData &prob_data, int VERBOSE)
 {
-    // prob_data.agent_obs_dist.clear();
+    // Candidates from the obstacle hierarchy, inflated footprints overlapping the swept box of the
+    // last prediction
+    queryBVH(prob_data.obs_bvh, prob_data.x.minCoeff(), prob_data.y.minCoeff(), prob_data.x.maxCoeff(), prob_data.y.maxCoeff(), prob_data.candidates);
+    int num_candidates = std :: max((int)prob_data.candidates.size(), 1);
 
-    Eigen :: ArrayXXf val = pow(((-prob_data.x_static_obs_og).rowwise() + prob_data.x.transpose().row(0))/(prob_data.a_static_obs_og + prob_data.prox_obs), 2) 
-                                + pow(((-prob_data.y_static_obs_og).rowwise() + prob_data.y.transpose().row(0))/(prob_data.b_static_obs_og + prob_data.prox_obs), 2);
+    prob_data.x_static_obs = Eigen :: ArrayXXf :: Ones(num_candidates, prob_data.num); 
+    prob_data.y_static_obs = Eigen :: ArrayXXf :: Ones(num_candidates, prob_data.num);
+    prob_data.z_static_obs = Eigen :: ArrayXXf :: Ones(num_candidates, prob_data.num);
 
-    prob_data.x_static_obs = Eigen :: ArrayXXf :: Ones(prob_data.x_static_obs_og.rows(), prob_data.num); 
-    prob_data.y_static_obs = Eigen :: ArrayXXf :: Ones(prob_data.x_static_obs_og.rows(), prob_data.num);
-    prob_data.z_static_obs = Eigen :: ArrayXXf :: Ones(prob_data.x_static_obs_og.rows(), prob_data.num);
-
-    prob_data.a_static_obs = Eigen :: ArrayXXf :: Ones(prob_data.x_static_obs_og.rows(), prob_data.num);
-    prob_data.b_static_obs = Eigen :: ArrayXXf :: Ones(prob_data.x_static_obs_og.rows(), prob_data.num);
-    prob_data.c_static_obs = Eigen :: ArrayXXf :: Ones(prob_data.x_static_obs_og.rows(), prob_data.num);
-
-
-    Eigen :: ArrayXf dist = -prob_data.a_static_obs_og.col(0) + prob_data.lx_drone + prob_data.buffer + (sqrt(pow((prob_data.agents_x(prob_data.id_badge, 0) - prob_data.x_static_obs_og.col(0)),2) 
-                                + pow((prob_data.agents_y(prob_data.id_badge, 0) - prob_data.y_static_obs_og.col(0)),2)));
-    
+    prob_data.a_static_obs = Eigen :: ArrayXXf :: Ones(num_candidates, prob_data.num);
+    prob_data.b_static_obs = Eigen :: ArrayXXf :: Ones(num_candidates, prob_data.num);
+    prob_data.c_static_obs = Eigen :: ArrayXXf :: Ones(num_candidates, prob_data.num);
 
     int k = 0;
     prob_data.unify_obs = 0;
-    for(int i = 0; i < prob_data.x_static_obs_og.rows(); i++){	
-        if((val.row(i) <= 1.0).any()){
-            prob_data.x_static_obs.row(k) = prob_data.x_static_obs_og.row(i);
-            prob_data.y_static_obs.row(k) = prob_data.y_static_obs_og.row(i);
-            prob_data.z_static_obs.row(k) = prob_data.z_static_obs_og.row(i);
-
-            prob_data.a_static_obs.row(k) = prob_data.a_static_obs_og.row(i);
-            prob_data.b_static_obs.row(k) = prob_data.b_static_obs_og.row(i);
-            prob_data.c_static_obs.row(k) = prob_data.c_static_obs_og.row(i);
+    for(int i : prob_data.candidates){
+        // Any sample of the prediction within prox_obs of the obstacle ellipse
+        Eigen :: ArrayXXf val = ((prob_data.x - prob_data.x_static_obs_og(i))/(prob_data.a_static_obs_og(i) + prob_data.prox_obs)).square()
+                                + ((prob_data.y - prob_data.y_static_obs_og(i))/(prob_data.b_static_obs_og(i) + prob_data.prox_obs)).square();
+        if((val <= 1.0).any()){
+            prob_data.x_static_obs.row(k).setConstant(prob_data.x_static_obs_og(i));
+            prob_data.y_static_obs.row(k).setConstant(prob_data.y_static_obs_og(i));
+            prob_data.z_static_obs.row(k).setConstant(prob_data.z_static_obs_og(i));
+
+            prob_data.a_static_obs.row(k).setConstant(prob_data.a_static_obs_og(i));
+            prob_data.b_static_obs.row(k).setConstant(prob_data.b_static_obs_og(i));
+            prob_data.c_static_obs.row(k).setConstant(prob_data.c_static_obs_og(i));
 
             
             if(prob_data.c_static_obs(k, 0) < prob_data.z_max) 
                 prob_data.unify_obs++;
             
             k++;
-        }	
-
-        // prob_data.agent_obs_dist.push_back(dist(i));
+        }
     }
 
-    if(k!=0 && prob_data.x_static_obs_og.rows() > 1){
+    if(k!=0){
         prob_data.x_static_obs.conservativeResize(k, prob_data.num);
         prob_data.y_static_obs.conservativeResize(k, prob_data.num);
         prob_data.z_static_obs.conservativeResize(k, prob_data.num);
@@ -54,19 +50,16 @@ void initObstacles(probData &prob_data, int VERBOSE)
     }
     prob_data.num_static_obs = k;
 
-    prob_data.A_static_obs = prob_data.P;
-    for(int i = 0; i < prob_data.num_static_obs - 1; i++) prob_data.A_static_obs = stack(prob_data.A_static_obs, prob_data.P, 'v');
+    prob_data.A_static_obs.num_blocks = prob_data.num_static_obs;
 }
 
 void neigbhoringAgents(probData &prob_data, int VERBOSE)
 {
-    // prob_data.inter_agent_dist.clear();
-
-    Eigen :: ArrayXXf agents_x, agents_y, agents_z;
-
-    agents_x = prob_data.agents_x;
-    agents_y = prob_data.agents_y;
-    agents_z = prob_data.agents_z;
+    // Zero-copy views of the shared board, as published before this step
+    int front = prob_data.board_epoch & 1;
+    const Eigen :: ArrayXXf &agents_x = prob_data.board->x[front];
+    const Eigen :: ArrayXXf &agents_y = prob_data.board->y[front];
+    const Eigen :: ArrayXXf &agents_z = prob_data.board->z[front];
 
     prob_data.x_drone = Eigen :: ArrayXXf :: Ones(agents_x.rows(), prob_data.num);
     prob_data.y_drone = Eigen :: ArrayXXf :: Ones(agents_y.rows(), prob_data.num);
@@ -77,29 +70,39 @@ void neigbhoringAgents(probData &prob_data, int VERBOSE)
     prob_data.c_drone = Eigen :: ArrayXXf :: Ones(agents_x.rows(), prob_data.num) * (2*prob_data.lz_drone + prob_data.buffer);
 
     float del = (abs(prob_data.world - 2.0001)/(prob_data.world - 2.0001) + 1)/2;
+    float rx = 2*prob_data.lx_drone + prob_data.prox_agent;
+    float ry = 2*prob_data.ly_drone + prob_data.prox_agent;
+    float rz = 2*prob_data.lz_drone + prob_data.prox_agent;
+
+    // Candidates from the board grid (swept boxes within reach of this agent's), all agents when
+    // the grid is disabled
+    const spatialGrid &grid = prob_data.board->grid[front];
+    if(grid.nx > 0){
+        float reach = std :: max(rx, ry) + 1e-4;
+        queryGrid(grid, grid.boxes(prob_data.id_badge, 0) - reach, grid.boxes(prob_data.id_badge, 1) - reach, 
+                        grid.boxes(prob_data.id_badge, 2) + reach, grid.boxes(prob_data.id_badge, 3) + reach, prob_data.candidates);
+    }
+    else{
+        prob_data.candidates.resize(agents_x.rows());
+        for(int i = 0; i < agents_x.rows(); i++)
+            prob_data.candidates[i] = i;
+    }
 
     int k = 0;
-    Eigen :: ArrayXXf val = pow(((-agents_x).rowwise() + agents_x.row(prob_data.id_badge))/(2*prob_data.lx_drone + prob_data.prox_agent), 2) 
-                                + pow(((-agents_y).rowwise() + agents_y.row(prob_data.id_badge))/(2*prob_data.ly_drone + prob_data.prox_agent), 2)
-                                + del * pow(((-agents_z).rowwise() + agents_z.row(prob_data.id_badge))/(2*prob_data.lz_drone + prob_data.prox_agent), 2);
-
-    Eigen :: ArrayXf dist = (sqrt(pow((agents_x(prob_data.id_badge, 0) - agents_x.col(0)),2) 
-                                + pow((agents_y(prob_data.id_badge, 0) - agents_y.col(0)),2)
-                                + pow((agents_z(prob_data.id_badge, 0) - agents_z.col(0)),2))).max(0.0);
-
-    
-    for(int i = 0; i < agents_x.rows(); i++)
+    for(int i : prob_data.candidates)
     {
         if(i == prob_data.id_badge)
             continue;
-        if((val.row(i) <= 1.0).any()){
+        // Any pair of simultaneous samples within prox_agent of the inter-agent ellipsoid
+        Eigen :: ArrayXXf val = ((agents_x.row(prob_data.id_badge) - agents_x.row(i))/rx).square()
+                                + ((agents_y.row(prob_data.id_badge) - agents_y.row(i))/ry).square()
+                                + del * ((agents_z.row(prob_data.id_badge) - agents_z.row(i))/rz).square();
+        if((val <= 1.0).any()){
             prob_data.x_drone.row(k) = agents_x.row(i).rightCols(prob_data.num);
             prob_data.y_drone.row(k) = agents_y.row(i).rightCols(prob_data.num);
             prob_data.z_drone.row(k) = agents_z.row(i).rightCols(prob_data.num);
             k++; 
         }
-
-        // prob_data.inter_agent_dist.push_back(dist(i));
     }
 
     
@@ -114,8 +117,7 @@ void neigbhoringAgents(probData &prob_data, int VERBOSE)
     }
     prob_data.num_drone = k;
 
-    prob_data.A_drone = prob_data.P;    
-    for(int i = 0; i < prob_data.num_drone - 1; i++) prob_data.A_drone = stack(prob_data.A_drone, prob_data.P, 'v');
+    prob_data.A_drone.num_blocks = prob_data.num_drone;
 
     if(prob_data.unify_obs!=0 && prob_data.num_static_obs!=0){
         
@@ -128,7 +130,7 @@ void neigbhoringAgents(probData &prob_data, int VERBOSE)
             prob_data.b_drone = stack(prob_data.b_drone, prob_data.b_static_obs.bottomRows(prob_data.num_static_obs - prob_data.unify_obs), 'v');
             prob_data.c_drone = stack(prob_data.c_drone, prob_data.c_static_obs.bottomRows(prob_data.num_static_obs - prob_data.unify_obs), 'v');
             
-            prob_data.A_drone = stack(prob_data.A_drone, prob_data.A_static_obs.bottomRows((prob_data.num_static_obs - prob_data.unify_obs)*prob_data.num), 'v'); 
+            prob_data.A_drone.num_blocks += prob_data.num_static_obs - prob_data.unify_obs;
         }
         else{
             prob_data.x_drone = prob_data.x_static_obs.bottomRows(prob_data.num_static_obs - prob_data.unify_obs);
@@ -139,10 +141,11 @@ void neigbhoringAgents(probData &prob_data, int VERBOSE)
             prob_data.b_drone = prob_data.b_static_obs.bottomRows(prob_data.num_static_obs - prob_data.unify_obs);
             prob_data.c_drone = prob_data.c_static_obs.bottomRows(prob_data.num_static_obs - prob_data.unify_obs);
             
-            prob_data.A_drone = prob_data.A_static_obs.bottomRows((prob_data.num_static_obs - prob_data.unify_obs)*prob_data.num); 
+            prob_data.A_drone.num_blocks = prob_data.num_static_obs - prob_data.unify_obs;
         }
         prob_data.num_drone = prob_data.a_drone.rows();
         prob_data.num_static_obs = prob_data.unify_obs;
+        prob_data.A_static_obs.num_blocks = prob_data.num_static_obs;
 
         if(prob_data.num_static_obs!=0){
             Eigen :: ArrayXXf temp;
@@ -163,9 +166,6 @@ void neigbhoringAgents(probData &prob_data, int VERBOSE)
 
             temp = prob_data.c_static_obs.topRows(prob_data.num_static_obs);
             prob_data.c_static_obs = temp;
-
-            temp = prob_data.A_static_obs.topRows(prob_data.num_static_obs*prob_data.num);
-            prob_data.A_static_obs = temp;
         }
 
     }
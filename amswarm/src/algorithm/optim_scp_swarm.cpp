@@ -17,6 +17,10 @@ typedef Eigen::Map<Eigen::Matrix<double,Eigen::Dynamic,
 
 typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> MatrixXdRow;
 
+// Trust region bound of the first linearization, which has no previous solution to stay close to.
+// Finite so that qpOASES keeps the rows as (inactive) constraints through a hot start
+static const double SCP_TRUST_OPEN = 1e6;
+
 float binomialCoeff(float n, float k)
 {
 	if (k == 0 || k == n)
@@ -202,48 +206,191 @@ five_var computeBernstein(Eigen :: ArrayXXf tot_time, float t_fin, int num)
 	return PPP;
 }
 
-int computeXYZ(probData &prob_data, int VERBOSE){
-	
-	int tries = 0;
-	prob_data.qp_fail = 1;
-	
-	// @ INEQUALITY MATRICES
-	Eigen :: ArrayXXf A_pos_ineq = block_diag(block_diag(stack(prob_data.P, -prob_data.P, 'v'), stack(prob_data.P, -prob_data.P, 'v')), stack(prob_data.P, -prob_data.P, 'v'));
-	Eigen :: ArrayXXf A_vel_ineq = block_diag(block_diag(stack(prob_data.Pdot, -prob_data.Pdot, 'v'), stack(prob_data.Pdot, -prob_data.Pdot, 'v')), stack(prob_data.Pdot, -prob_data.Pdot, 'v'));
-	Eigen :: ArrayXXf A_acc_ineq = block_diag(block_diag(stack(prob_data.Pddot, -prob_data.Pddot, 'v'), stack(prob_data.Pddot, -prob_data.Pddot, 'v')), stack(prob_data.Pddot, -prob_data.Pddot, 'v'));
-
-	Eigen :: ArrayXXf b_x_ineq = stack(prob_data.x_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), -prob_data.x_min * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), 'v');
-	Eigen :: ArrayXXf b_y_ineq = stack(prob_data.y_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), -prob_data.y_min * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), 'v');
-	Eigen :: ArrayXXf b_z_ineq = stack(prob_data.z_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), -prob_data.z_min * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), 'v');
-	Eigen :: ArrayXXf b_pos_ineq = stack(stack(b_x_ineq, b_y_ineq, 'v'), b_z_ineq,'v'); 
-
-	Eigen :: ArrayXXf b_vx_ineq = stack(prob_data.vel_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), prob_data.vel_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), 'v');
-	Eigen :: ArrayXXf b_vy_ineq = stack(prob_data.vel_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), prob_data.vel_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), 'v');
-	Eigen :: ArrayXXf b_vz_ineq = stack(prob_data.vel_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), prob_data.vel_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), 'v');
-	Eigen :: ArrayXXf b_vel_ineq = stack(stack(b_vx_ineq, b_vy_ineq, 'v'), b_vz_ineq, 'v');
-
-	Eigen :: ArrayXXf b_ax_ineq = stack(prob_data.acc_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), prob_data.acc_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), 'v');
-	Eigen :: ArrayXXf b_ay_ineq = stack(prob_data.acc_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), prob_data.acc_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), 'v');
-	Eigen :: ArrayXXf b_az_ineq = stack(prob_data.acc_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), prob_data.acc_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), 'v');
-	
-	
+void assembleConstraints(probData &prob_data)
+{
+	// Everything of the QP that does not depend on the obstacles, built once per optimizer
+	scpWorkspace &ws = prob_data.ws;
+	int num = prob_data.num, nvar = prob_data.nvar;
+
+	float z_acc_min = -prob_data.acc_max;
 	if(prob_data.use_thrust_values){
 		prob_data.acc_max = (-(2*prob_data.gravity) + sqrt(pow(2*prob_data.gravity,2) - 4*3*(pow(prob_data.gravity,2) - pow(1.5*prob_data.gravity,2))))/6.0; 
-		float z_acc_min = prob_data.f_min - prob_data.gravity;
-		
-		b_ax_ineq = stack(prob_data.acc_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), prob_data.acc_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), 'v');
-		b_ay_ineq = stack(prob_data.acc_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), prob_data.acc_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), 'v');
-		b_az_ineq = stack(prob_data.acc_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), -z_acc_min * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), 'v');
-		
+		z_acc_min = prob_data.f_min - prob_data.gravity;
+	}
+
+	// @ INEQUALITY MATRICES, [basis; -basis] per axis for pos, vel and acc
+	const Eigen :: ArrayXXf *basis[3] = {&prob_data.P, &prob_data.Pdot, &prob_data.Pddot};
+	float upper[3][3] = {{prob_data.x_max, prob_data.y_max, prob_data.z_max},
+						{prob_data.vel_max, prob_data.vel_max, prob_data.vel_max},
+						{prob_data.acc_max, prob_data.acc_max, prob_data.acc_max}};
+	float lower[3][3] = {{prob_data.x_min, prob_data.y_min, prob_data.z_min},
+						{-prob_data.vel_max, -prob_data.vel_max, -prob_data.vel_max},
+						{-prob_data.acc_max, -prob_data.acc_max, z_acc_min}};
+
+	ws.A_bound.setZero(18*num, 3*nvar);
+	ws.b_bound.resize(18*num);
+	for(int k = 0; k < 3; k++){
+		for(int i = 0; i < 3; i++){
+			int row = 2*num*(3*k + i);
+			ws.A_bound.block(row, i*nvar, num, nvar) = basis[k]->cast<double>().matrix();
+			ws.A_bound.block(row + num, i*nvar, num, nvar) = -basis[k]->cast<double>().matrix();
+			ws.b_bound.segment(row, num).setConstant(upper[k][i]);
+			ws.b_bound.segment(row + num, num).setConstant(-lower[k][i]);
+		}
+	}
+
+	// @ EQUALITY MATRICES, initial pos, vel and acc per axis
+	ws.A_eq.setZero(9, 3*nvar);
+	for(int i = 0; i < 3; i++){
+		ws.A_eq.block(3*i, i*nvar, 1, nvar) = prob_data.P.row(0).cast<double>().matrix();
+		ws.A_eq.block(3*i + 1, i*nvar, 1, nvar) = prob_data.Pdot.row(0).cast<double>().matrix();
+		ws.A_eq.block(3*i + 2, i*nvar, 1, nvar) = prob_data.Pddot.row(0).cast<double>().matrix();
+	}
+	ws.b_eq.resize(9);
+
+	// @ COST
+	ws.cost = (prob_data.weight_goal*prob_data.cost_goal + prob_data.weight_smoothness*prob_data.cost_smoothness).cast<double>().matrix();
+	ws.lincost = (-prob_data.weight_goal * prob_data.lincost_goal).col(0).cast<double>().matrix();
+
+	// Forces reserveQP to copy the new blocks in
+	ws.Q.resize(0, 0);
+	ws.A_ineq.resize(0, 0);
+	ws.num_trust = 0;
+	ws.new_layout = true;
+}
+
+void reserveQP(probData &prob_data, int num_coll_rows, int scp_iter)
+{
+	// Sizes the buffers for num_coll_rows collision rows and prob_data.num_slack slacks, plus the
+	// trust region rows when there is more than one linearization. Those are kept on every
+	// linearization (loose on the first) so that the layout only follows the collision rows.
+	// The constant blocks are only copied in when the shape changes, the caller fills the
+	// collision rows and the trust region bounds
+	scpWorkspace &ws = prob_data.ws;
+	int nvar = 3*prob_data.nvar, num_slack = prob_data.num_slack;
+	int num_trust = (prob_data.scp_max_iter > 1 && prob_data.trust_region > 0) ? 2*nvar : 0;
+	int num_bound = ws.A_bound.rows(), num_ineq = num_bound + num_coll_rows + num_slack + num_trust;
+
+	bool same_layout = ws.Q.rows() == nvar + num_slack && ws.A_ineq.rows() == num_ineq && ws.num_trust == num_trust;
+	if(!same_layout){
+		ws.new_layout = true;
+		ws.Q.setZero(nvar + num_slack, nvar + num_slack);
+		ws.Q.topLeftCorner(nvar, nvar) = ws.cost;
+		ws.q.resize(nvar + num_slack);
+		ws.q.head(nvar) = ws.lincost;
+
+		ws.A_eq.conservativeResize(Eigen :: NoChange, nvar + num_slack);
+		ws.A_eq.rightCols(num_slack).setZero();
+
+		ws.A_ineq.setZero(num_ineq, nvar + num_slack);
+		ws.A_ineq.topLeftCorner(num_bound, nvar) = ws.A_bound;
+		ws.A_ineq.block(num_bound + num_coll_rows, nvar, num_slack, num_slack).diagonal().setConstant(-1.0);
+		ws.A_ineq.block(num_ineq - num_trust, 0, num_trust/2, nvar).diagonal().setConstant(1.0);
+		ws.A_ineq.block(num_ineq - num_trust/2, 0, num_trust/2, nvar).diagonal().setConstant(-1.0);
+		ws.b_ineq.setZero(num_ineq);
+		ws.b_ineq.head(num_bound) = ws.b_bound;
+		ws.num_trust = num_trust;
+	}
+	ws.Q.bottomRightCorner(num_slack, num_slack).diagonal().setConstant(prob_data.weight_quad_slack);
+	ws.q.tail(num_slack).setConstant(prob_data.weight_lin_slack);
+
+	if(prob_data.solver == "qpoases" || prob_data.solver == "admm"){
+		// Multipliers of the previous solve, one sample ahead for the receding horizon on a new MPC
+		// step and in place for a re-linearization. Collision and slack rows only while their layout
+		// is unchanged, trust region rows only for a re-linearization (they are loose on a new step)
+		int num = prob_data.num, num_eq = ws.A_eq.rows(), shift = scp_iter == 0 ? 1 : 0;
+		ws.dual_map.resize(num_eq + num_ineq);
+		for(int i = 0; i < num_eq; i++)
+			ws.dual_map[i] = i;
+		for(int i = 0; i < num_bound + num_coll_rows; i++){
+			if(i >= num_bound && !same_layout)
+				ws.dual_map[num_eq + i] = -1;
+			else
+				ws.dual_map[num_eq + i] = num_eq + i + (i % num < num - 1 ? shift : 0);
+		}
+		for(int i = num_bound + num_coll_rows; i < num_ineq - num_trust; i++)
+			ws.dual_map[num_eq + i] = same_layout ? num_eq + i : -1;
+		for(int i = num_ineq - num_trust; i < num_ineq; i++)
+			ws.dual_map[num_eq + i] = same_layout && scp_iter > 0 ? num_eq + i : -1;
+	}
+}
+
+// Sparse copy of M with its nonzeros and every entry of rows [row, row + num_rows) in the first
+// num_cols columns, so that later values of those rows fit the pattern
+static void sparsePattern(const Eigen :: MatrixXd &M, int row, int num_rows, int num_cols, Eigen :: SparseMatrix<double> &S)
+{
+	std :: vector<Eigen :: Triplet<double>> triplets;
+	for(int j = 0; j < M.cols(); j++)
+		for(int i = 0; i < M.rows(); i++)
+			if(M(i, j) != 0.0 || (i >= row && i < row + num_rows && j < num_cols))
+				triplets.emplace_back(i, j, M(i, j));
+	S.resize(M.rows(), M.cols());
+	S.setFromTriplets(triplets.begin(), triplets.end());
+}
+
+// Copies rows [row, row + num_rows) of M into the entries S already has there
+static void refreshRows(const Eigen :: MatrixXd &M, int row, int num_rows, Eigen :: SparseMatrix<double> &S)
+{
+	for(int j = 0; j < S.outerSize(); j++)
+		for(Eigen :: SparseMatrix<double> :: InnerIterator it(S, j); it; ++it)
+			if(it.row() >= row && it.row() < row + num_rows)
+				it.valueRef() = M(it.row(), j);
+}
+
+void updateSparseQP(probData &prob_data, int num_coll_rows, bool penalty)
+{
+	// Brings the "admm" copies of the QP up to date with the dense buffers, keeping their pattern
+	// unless reserveQP changed the layout, then hands the soft rows of "penalty" to SparseQP
+	scpWorkspace &ws = prob_data.ws;
+	int nvar = 3*prob_data.nvar, num_bound = ws.A_bound.rows();
+	if(ws.new_layout){
+		sparsePattern(ws.Q, 0, 0, 0, ws.Q_sp);
+		sparsePattern(ws.A_eq, 0, 0, 0, ws.A_eq_sp);
+		sparsePattern(ws.A_ineq, num_bound, num_coll_rows, nvar, ws.A_ineq_sp);
+		ws.new_layout = false;
+	}
+	else{
+		refreshRows(ws.Q, nvar, prob_data.num_slack, ws.Q_sp);
+		refreshRows(ws.A_ineq, num_bound, num_coll_rows, ws.A_ineq_sp);
 	}
 
-	Eigen :: ArrayXXf b_acc_ineq = stack(stack(b_ax_ineq, b_ay_ineq, 'v'), b_az_ineq, 'v');
+	if(penalty){
+		ws.A_pen = prob_data.A_coll.cast<double>().matrix();
+		ws.b_pen = prob_data.b_coll.col(0).cast<double>().matrix();
+		if(ws.A_pen_sp.rows() == ws.A_pen.rows() && ws.A_pen_sp.cols() == ws.A_pen.cols())
+			refreshRows(ws.A_pen, 0, ws.A_pen.rows(), ws.A_pen_sp);
+		else
+			sparsePattern(ws.A_pen, 0, ws.A_pen.rows(), ws.A_pen.cols(), ws.A_pen_sp);
+	}
+	else{
+		ws.A_pen_sp.resize(0, ws.Q.cols());
+		ws.b_pen.resize(0);
+	}
+	prob_data.sparse_qp->penalize(ws.A_pen_sp, ws.b_pen, prob_data.weight_lin_slack, prob_data.weight_quad_slack);
+}
+
+// Worst violation of the ellipsoidal collision constraints along prob_data.x, y, z, positive when
+// the trajectory enters an obstacle
+float collisionViolation(probData &prob_data)
+{
+	if(prob_data.num_static_obs == 0)
+		return 0.0;
+
+	float del = (abs(prob_data.world - 2.0001)/(prob_data.world - 2.0001) + 1)/2;
+	Eigen :: ArrayXXf val = pow((-prob_data.x_static_obs).rowwise() + prob_data.x.transpose().row(0), 2)/pow(prob_data.a_static_obs, 2)
+							+ pow((-prob_data.y_static_obs).rowwise() + prob_data.y.transpose().row(0), 2)/pow(prob_data.b_static_obs, 2)
+							+ del * pow((-prob_data.z_static_obs).rowwise() + prob_data.z.transpose().row(0), 2)/pow(prob_data.c_static_obs, 2);
+
+	return 1.0 - val.minCoeff();
+}
 
-	Eigen :: ArrayXXf A_slack_ineq, b_slack_ineq;
-	// @ EQUALITY MATRICES
-	prob_data.A_eq = block_diag(block_diag(stack(prob_data.P.row(0), stack(prob_data.Pdot.row(0), prob_data.Pddot.row(0), 'v'), 'v'), stack(prob_data.P.row(0), stack(prob_data.Pdot.row(0), prob_data.Pddot.row(0), 'v'), 'v')), stack(prob_data.P.row(0), stack(prob_data.Pdot.row(0), prob_data.Pddot.row(0), 'v'), 'v'));
-	prob_data.b_eq = Eigen :: ArrayXXf(9, 1);
-	prob_data.b_eq << prob_data.x_init, prob_data.vx_init, prob_data.ax_init,
+int computeXYZ(probData &prob_data, int VERBOSE){
+	
+	prob_data.qp_fail = 1;
+	prob_data.num_slack = 0;
+	
+	// @ EQUALITY RHS, the rest of the QP is kept in prob_data.ws
+	prob_data.ws.b_eq << prob_data.x_init, prob_data.vx_init, prob_data.ax_init,
 					prob_data.y_init, prob_data.vy_init, prob_data.ay_init,
 					prob_data.z_init, prob_data.vz_init, prob_data.az_init;
 
@@ -276,126 +423,164 @@ int computeXYZ(probData &prob_data, int VERBOSE){
 	prob_data.colliding_step = 1000;
 	prob_data.weight_lin_slack = prob_data.weight_lin_slack_og;
 	prob_data.weight_quad_slack = prob_data.weight_quad_slack_og;
-	
-	while(tries < 1 && prob_data.qp_fail){		
+
+	// @ SCP, re-linearize the collision constraints about the last solution until the cost and
+	// the collision violation stop changing. Every linearization refills the same QP buffers
+	Eigen :: ArrayXXf sol, sol_prev;
+	float cost = 0.0, viol = 0.0;
+	int iter = 0;
+	while(iter < prob_data.scp_max_iter){
 		
-		Eigen :: ArrayXXf temp_cost, temp_lincost;
+		int num_coll_rows = 0;
 
 		if(prob_data.num_static_obs != 0){
 			
-			// STACK ALL INEQUALITIES
-			if(tries == 0){
-
-				if(!prob_data.on_demand)
-					continuousCA(prob_data, VERBOSE);
-				else{
+			if(!prob_data.on_demand)
+				continuousCA(prob_data, VERBOSE);
+			else{
+				// The colliding step and its obstacles are picked once per MPC step
+				if(iter == 0)
 					prob_data.colliding_step = collidingStep(prob_data, VERBOSE);
-					
-					if(prob_data.colliding_step == 1000){
-						prob_data.num_static_obs = 0;
-						prob_data.num_drone = 0;
-						continue;
-					}
-					else {
-						ondemandCA(prob_data, VERBOSE);
-					}
-				}
 				
-				prob_data.slack = Eigen :: ArrayXXf :: Zero(prob_data.num*prob_data.num_static_obs, 1);
-				prob_data.A_eq = block_diag(prob_data.A_eq, Eigen::ArrayXXf::Zero(prob_data.num*prob_data.num_static_obs, prob_data.num*prob_data.num_static_obs));
-				A_pos_ineq = block_diag(A_pos_ineq, Eigen::ArrayXXf::Zero(prob_data.num*prob_data.num_static_obs, prob_data.num*prob_data.num_static_obs));
-				A_vel_ineq = block_diag(A_vel_ineq, Eigen::ArrayXXf::Zero(prob_data.num*prob_data.num_static_obs, prob_data.num*prob_data.num_static_obs));
-				A_acc_ineq = block_diag(A_acc_ineq, Eigen::ArrayXXf::Zero(prob_data.num*prob_data.num_static_obs, prob_data.num*prob_data.num_static_obs));
-				A_slack_ineq = stack(Eigen::ArrayXXf::Zero(prob_data.num*prob_data.num_static_obs, 3*prob_data.nvar), -Eigen::MatrixXf::Identity(prob_data.num*prob_data.num_static_obs, prob_data.num*prob_data.num_static_obs), 'h');
-
-				b_pos_ineq = stack(b_pos_ineq, Eigen::ArrayXXf::Zero(prob_data.num*prob_data.num_static_obs, 1),'v');
-				b_vel_ineq = stack(b_vel_ineq, Eigen::ArrayXXf::Zero(prob_data.num*prob_data.num_static_obs, 1),'v');
-				b_acc_ineq = stack(b_acc_ineq, Eigen::ArrayXXf::Zero(prob_data.num*prob_data.num_static_obs, 1),'v');
-				b_slack_ineq = Eigen :: ArrayXXf :: Zero(A_slack_ineq.rows(), 1); 
-
-				prob_data.b_eq = stack(prob_data.b_eq, Eigen::ArrayXXf::Zero(prob_data.num*prob_data.num_static_obs, 1),'v');
+				if(prob_data.colliding_step == 1000){
+					prob_data.num_static_obs = 0;
+					prob_data.num_drone = 0;
+				}
+				else {
+					ondemandCA(prob_data, VERBOSE);
+				}
 			}
 
-			prob_data.A_ineq = stack(stack(stack(A_pos_ineq, A_vel_ineq, 'v'), stack(A_acc_ineq, prob_data.A_coll, 'v'), 'v'), A_slack_ineq, 'v');
-			prob_data.b_ineq = stack(stack(stack(b_pos_ineq, b_vel_ineq, 'v'), stack(b_acc_ineq, prob_data.b_coll, 'v'), 'v'), b_slack_ineq, 'v');
-
-			
-			temp_cost = block_diag(prob_data.weight_goal*prob_data.cost_goal + prob_data.weight_smoothness*prob_data.cost_smoothness, prob_data.weight_quad_slack*prob_data.cost_slack);
-			temp_lincost = stack(-prob_data.weight_goal * prob_data.lincost_goal, prob_data.weight_lin_slack * Eigen::ArrayXXf::Ones(prob_data.num*prob_data.num_static_obs, 1), 'v');
+			// "penalty" hands A_coll to SparseQP as soft rows instead
+			if(prob_data.num_static_obs != 0 && prob_data.slack_mode != "penalty")
+				num_coll_rows = prob_data.A_coll.rows();
 		}
-		else{
-			prob_data.A_ineq = stack(stack(A_pos_ineq, A_vel_ineq, 'v'), A_acc_ineq, 'v');
-			prob_data.b_ineq = stack(stack(b_pos_ineq, b_vel_ineq, 'v'), b_acc_ineq, 'v');
-
-			temp_cost = prob_data.weight_goal*prob_data.cost_goal + prob_data.weight_smoothness*prob_data.cost_smoothness;
-			temp_lincost = -prob_data.weight_goal * prob_data.lincost_goal;
+		if(iter == 0)
+			prob_data.slack = Eigen :: ArrayXXf :: Zero(prob_data.num_slack, 1);
+
+		// @ Collision rows and trust region, the only rows rewritten between solves
+		reserveQP(prob_data, num_coll_rows, iter);
+		scpWorkspace &ws = prob_data.ws;
+		if(num_coll_rows != 0){
+			ws.A_ineq.middleRows(ws.A_bound.rows(), num_coll_rows) = prob_data.A_coll.cast<double>().matrix();
+			ws.b_ineq.segment(ws.A_bound.rows(), num_coll_rows) = prob_data.b_coll.col(0).cast<double>().matrix();
+		}
+		if(ws.num_trust != 0 && iter == 0)
+			ws.b_ineq.tail(ws.num_trust).setConstant(SCP_TRUST_OPEN);
+		else if(ws.num_trust != 0){
+			// Bernstein positions stay in the hull of their coefficients, so boxing the coefficients
+			// bounds the position change along the whole trajectory
+			Eigen :: VectorXd coeff_prev = sol_prev.topRows(3*prob_data.nvar).col(0).cast<double>().matrix();
+			ws.b_ineq.tail(ws.num_trust) << (coeff_prev.array() + prob_data.trust_region).matrix(), 
+											(prob_data.trust_region - coeff_prev.array()).matrix();
 		}
 		
 		// SOLVE QP
-		Eigen::QuadProgDense solver_xyz(temp_cost.rows(), prob_data.A_eq.rows(), prob_data.A_ineq.rows());
+		if(prob_data.solver == "admm"){
+			updateSparseQP(prob_data, num_coll_rows, prob_data.num_static_obs != 0 && prob_data.slack_mode == "penalty");
+			prob_data.sparse_qp->solve(ws.Q_sp, ws.q, ws.A_eq_sp, ws.b_eq, ws.A_ineq_sp, ws.b_ineq, ws.dual_map);
 
-		solver_xyz.solve((temp_cost).cast<double>().matrix(), temp_lincost.cast<double>().matrix(), 
-						prob_data.A_eq.cast<double>().matrix(), prob_data.b_eq.cast<double>().matrix(),
-						prob_data.A_ineq.cast<double>().matrix(), prob_data.b_ineq.cast<double>().matrix());
+			sol = prob_data.sparse_qp->result().cast<float>();
+			prob_data.qp_fail = prob_data.sparse_qp->fail();
+		}
+		else if(prob_data.solver == "qpoases" && HotQP :: fits(ws.Q.rows(), ws.A_eq.rows() + ws.A_ineq.rows())){
+			prob_data.hot_qp->solve(ws.Q, ws.q, ws.A_eq, ws.b_eq, ws.A_ineq, ws.b_ineq, ws.dual_map);
 
-		
-		Eigen :: ArrayXXf sol = solver_xyz.result().cast<float>();
-		Eigen :: ArrayXXf sol_xy = sol.topRows(2*prob_data.nvar);
-		Eigen :: ArrayXXf sol_xyz = sol.topRows(3*prob_data.nvar);
+			sol = prob_data.hot_qp->result().cast<float>();
+			prob_data.qp_fail = prob_data.hot_qp->fail();
+			prob_data.qp_changes.push_back(prob_data.hot_qp->changes());
+		}
+		else{
+			Eigen::QuadProgDense solver_xyz(ws.Q.rows(), ws.A_eq.rows(), ws.A_ineq.rows());
+
+			solver_xyz.solve(ws.Q, ws.q, ws.A_eq, ws.b_eq, ws.A_ineq, ws.b_ineq);
+
+			sol = solver_xyz.result().cast<float>();
+			prob_data.qp_fail = solver_xyz.fail();
+			// -1 marks a QP too large for the static qpOASES arrays
+			if(prob_data.solver == "qpoases")
+				prob_data.qp_changes.push_back(-1);
+		}
 
-		Eigen :: ArrayXXf sol_x = sol_xy.topRows(prob_data.nvar);
-		Eigen :: ArrayXXf sol_y = sol_xy.bottomRows(prob_data.nvar);
-		Eigen :: ArrayXXf sol_z = sol_xyz.bottomRows(prob_data.nvar);
+		iter++;
 
-		if(prob_data.num_static_obs!=0)
-			prob_data.slack = sol.bottomRows(prob_data.num*prob_data.num_static_obs);
+		if(prob_data.qp_fail){
+			// A failed re-linearization keeps the previous solution
+			if(iter > 1){
+				sol = sol_prev;
+				prob_data.qp_fail = 0;
+			}
+			break;
+		}
+
+		Eigen :: ArrayXXf sol_x = sol.topRows(prob_data.nvar);
+		Eigen :: ArrayXXf sol_y = sol.middleRows(prob_data.nvar, prob_data.nvar);
+		Eigen :: ArrayXXf sol_z = sol.middleRows(2*prob_data.nvar, prob_data.nvar);
 
 		prob_data.x = prob_data.P.matrix() * sol_x.matrix();
 		prob_data.y = prob_data.P.matrix() * sol_y.matrix();
 		prob_data.z = prob_data.P.matrix() * sol_z.matrix();
 
-		prob_data.xdot = prob_data.Pdot.matrix() * sol_x.matrix();
-		prob_data.ydot = prob_data.Pdot.matrix() * sol_y.matrix();
-		prob_data.zdot = prob_data.Pdot.matrix() * sol_z.matrix();
+		// Without obstacles the QP is the exact problem
+		if(prob_data.num_static_obs == 0 || iter == prob_data.scp_max_iter)
+			break;
 
-		prob_data.xddot = prob_data.Pddot.matrix() * sol_x.matrix();
-		prob_data.yddot = prob_data.Pddot.matrix() * sol_y.matrix();
-		prob_data.zddot = prob_data.Pddot.matrix() * sol_z.matrix();
+		Eigen :: VectorXd coeff = sol.topRows(3*prob_data.nvar).col(0).cast<double>().matrix();
+		float cost_prev = cost, viol_prev = viol;
+		cost = 0.5 * coeff.dot(ws.cost * coeff) + ws.lincost.dot(coeff);
+		viol = collisionViolation(prob_data);
+		if(iter > 1 && std :: abs(cost - cost_prev) <= prob_data.scp_tol_cost * (1.0 + std :: abs(cost_prev)) 
+			&& std :: abs(viol - viol_prev) <= prob_data.scp_tol_coll)
+			break;
 
-		prob_data.xdddot = prob_data.Pdddot.matrix() * sol_x.matrix();
-		prob_data.ydddot = prob_data.Pdddot.matrix() * sol_y.matrix();
-		prob_data.zdddot = prob_data.Pdddot.matrix() * sol_z.matrix();
-
-		prob_data.xddddot = prob_data.Pddddot.matrix() * sol_x.matrix();
-		prob_data.yddddot = prob_data.Pddddot.matrix() * sol_y.matrix();
-		prob_data.zddddot = prob_data.Pddddot.matrix() * sol_z.matrix();
-		
-		prob_data.x_up = prob_data.P_up.matrix() * sol_x.matrix();
-		prob_data.y_up = prob_data.P_up.matrix() * sol_y.matrix();
-		prob_data.z_up = prob_data.P_up.matrix() * sol_z.matrix();
+		sol_prev = sol;
+	}
+	prob_data.scp_iters.push_back(iter);
 
-		prob_data.xdot_up = prob_data.Pdot_up.matrix() * sol_x.matrix();
-		prob_data.ydot_up = prob_data.Pdot_up.matrix() * sol_y.matrix();
-		prob_data.zdot_up = prob_data.Pdot_up.matrix() * sol_z.matrix();
+	Eigen :: ArrayXXf sol_x = sol.topRows(prob_data.nvar);
+	Eigen :: ArrayXXf sol_y = sol.middleRows(prob_data.nvar, prob_data.nvar);
+	Eigen :: ArrayXXf sol_z = sol.middleRows(2*prob_data.nvar, prob_data.nvar);
 
-		prob_data.xddot_up = prob_data.Pddot_up.matrix() * sol_x.matrix();
-		prob_data.yddot_up = prob_data.Pddot_up.matrix() * sol_y.matrix();
-		prob_data.zddot_up = prob_data.Pddot_up.matrix() * sol_z.matrix();
+	if(prob_data.num_static_obs!=0){
+		if(prob_data.num_slack != 0)
+			prob_data.slack = sol.bottomRows(prob_data.num_slack);
+		else
+			prob_data.slack = maximum(0.0, (prob_data.A_coll.matrix() * sol.matrix()).array() - prob_data.b_coll);
+	}
 
-		prob_data.qp_fail = solver_xyz.fail();
-		tries++;
+	prob_data.x = prob_data.P.matrix() * sol_x.matrix();
+	prob_data.y = prob_data.P.matrix() * sol_y.matrix();
+	prob_data.z = prob_data.P.matrix() * sol_z.matrix();
 
-		// prob_data.weight_lin_slack *= 0.01;
-		// prob_data.weight_quad_slack *= 0.01;
+	prob_data.xdot = prob_data.Pdot.matrix() * sol_x.matrix();
+	prob_data.ydot = prob_data.Pdot.matrix() * sol_y.matrix();
+	prob_data.zdot = prob_data.Pdot.matrix() * sol_z.matrix();
 
-		// if(prob_data.weight_lin_slack < 1.0)
-		// 	prob_data.weight_lin_slack = 1.0;
+	prob_data.xddot = prob_data.Pddot.matrix() * sol_x.matrix();
+	prob_data.yddot = prob_data.Pddot.matrix() * sol_y.matrix();
+	prob_data.zddot = prob_data.Pddot.matrix() * sol_z.matrix();
 
-		// if(prob_data.weight_quad_slack < 1.0)
-		// 	prob_data.weight_quad_slack = 1.0;
+	prob_data.xdddot = prob_data.Pdddot.matrix() * sol_x.matrix();
+	prob_data.ydddot = prob_data.Pdddot.matrix() * sol_y.matrix();
+	prob_data.zdddot = prob_data.Pdddot.matrix() * sol_z.matrix();
 
-	}
+	prob_data.xddddot = prob_data.Pddddot.matrix() * sol_x.matrix();
+	prob_data.yddddot = prob_data.Pddddot.matrix() * sol_y.matrix();
+	prob_data.zddddot = prob_data.Pddddot.matrix() * sol_z.matrix();
 	
+	prob_data.x_up = prob_data.P_up.matrix() * sol_x.matrix();
+	prob_data.y_up = prob_data.P_up.matrix() * sol_y.matrix();
+	prob_data.z_up = prob_data.P_up.matrix() * sol_z.matrix();
+
+	prob_data.xdot_up = prob_data.Pdot_up.matrix() * sol_x.matrix();
+	prob_data.ydot_up = prob_data.Pdot_up.matrix() * sol_y.matrix();
+	prob_data.zdot_up = prob_data.Pdot_up.matrix() * sol_z.matrix();
+
+	prob_data.xddot_up = prob_data.Pddot_up.matrix() * sol_x.matrix();
+	prob_data.yddot_up = prob_data.Pddot_up.matrix() * sol_y.matrix();
+	prob_data.zddot_up = prob_data.Pddot_up.matrix() * sol_z.matrix();
+
+	return prob_data.qp_fail;
 }
 
 
@@ -502,12 +687,34 @@ void neigbhoringAgents(probData &prob_data, int VERBOSE)
 }
 
 
+// Slack columns of the collision rows A_f, one slack per (obstacle, step) row for "step", one per obstacle
+// for "obstacle" and none for "penalty", where the violations are charged inside SparseQP instead
+Eigen :: ArrayXXf addCollisionSlack(probData &prob_data, Eigen :: ArrayXXf A_f)
+{
+	if(prob_data.slack_mode == "penalty")
+		prob_data.num_slack = 0;
+	else if(prob_data.slack_mode == "obstacle")
+		prob_data.num_slack = prob_data.num_static_obs;
+	else
+		prob_data.num_slack = A_f.rows();
+
+	if(prob_data.num_slack == 0)
+		return A_f;
+
+	Eigen :: ArrayXXf A_slack = Eigen :: ArrayXXf :: Zero(A_f.rows(), prob_data.num_slack);
+	if(prob_data.slack_mode == "obstacle"){
+		for(int i = 0; i < prob_data.num_static_obs; i++)
+			A_slack.block(i*prob_data.num, i, prob_data.num, 1) = -1.0;
+	}
+	else
+		A_slack.matrix() = -Eigen :: MatrixXf :: Identity(A_f.rows(), A_f.rows());
+
+	return stack(A_f, A_slack, 'h');
+}
+
 //  这个函数实现了连续碰撞避免约束， 函数划分为两种情况， 二维和三维
 void continuousCA(probData &prob_data, int VERBOSE){
 	// COLLISION AVOIDANCE CONSTRAINTS
-	prob_data.cost_slack = Eigen :: ArrayXXf(prob_data.num*prob_data.num_static_obs, prob_data.num*prob_data.num_static_obs);
-	prob_data.cost_slack.matrix().setIdentity();
-
 	if(prob_data.world == 2){
 		Eigen :: ArrayXXf A_f, temp_x, temp_y;
 		
@@ -534,7 +741,7 @@ void continuousCA(probData &prob_data, int VERBOSE){
 		
 		A_f = stack(prob_data.A_obs.colwise() * temp_A_fx.col(0), prob_data.A_obs.colwise() * temp_A_fy.col(0), 'h');
 		
-		Eigen :: ArrayXXf A_coll = stack(A_f, -Eigen::MatrixXf::Identity(A_f.rows(), A_f.rows()), 'h');
+		Eigen :: ArrayXXf A_coll = addCollisionSlack(prob_data, A_f);
 		
 		Eigen :: ArrayXXf temp_b_coll = pow((-prob_data.x_static_obs).rowwise() + prob_data.x.transpose().row(0), 2)/pow(prob_data.a_static_obs, 2) + pow((-prob_data.y_static_obs).rowwise() + prob_data.y.transpose().row(0), 2)/pow(prob_data.b_static_obs, 2) - 1.0;
 		Eigen :: ArrayXXf b_coll = reshape(temp_b_coll.transpose(), prob_data.num_static_obs*prob_data.num, 1) + temp_A_fx*temp_x + temp_A_fy*temp_y;
@@ -572,7 +779,7 @@ void continuousCA(probData &prob_data, int VERBOSE){
 		
 		A_f = stack(stack(prob_data.A_obs.colwise() * temp_A_fx.col(0), prob_data.A_obs.colwise() * temp_A_fy.col(0), 'h'), prob_data.A_obs.colwise() * temp_A_fz.col(0), 'h');
 		
-		Eigen :: ArrayXXf A_coll = stack(A_f, -Eigen::MatrixXf::Identity(A_f.rows(), A_f.rows()), 'h');
+		Eigen :: ArrayXXf A_coll = addCollisionSlack(prob_data, A_f);
 		
 		Eigen :: ArrayXXf temp_b_coll = pow((-prob_data.x_static_obs).rowwise() + prob_data.x.transpose().row(0), 2)/pow(prob_data.a_static_obs, 2) 
 									+ pow((-prob_data.y_static_obs).rowwise() + prob_data.y.transpose().row(0), 2)/pow(prob_data.b_static_obs, 2)
@@ -650,9 +857,6 @@ int collidingStep(probData &prob_data, int VERBOSE){
 }
 void ondemandCA(probData &prob_data, int VERBOSE){		
 	
-	prob_data.cost_slack = Eigen :: ArrayXXf(prob_data.num*prob_data.num_static_obs, prob_data.num*prob_data.num_static_obs);
-	prob_data.cost_slack.matrix().setIdentity();
-
 	if(prob_data.world == 2){
 		Eigen :: ArrayXXf A_f, temp_x, temp_y;
 		
@@ -689,7 +893,7 @@ void ondemandCA(probData &prob_data, int VERBOSE){
 			}
 		}
 		
-		Eigen :: ArrayXXf A_coll = stack(A_f, -Eigen::MatrixXf::Identity(A_f.rows(), A_f.rows()), 'h');
+		Eigen :: ArrayXXf A_coll = addCollisionSlack(prob_data, A_f);
 		
 		prob_data.A_coll = A_coll;
 		prob_data.b_coll = b_coll;
@@ -738,7 +942,7 @@ void ondemandCA(probData &prob_data, int VERBOSE){
 			}
 		}
 		
-		Eigen :: ArrayXXf A_coll = stack(A_f, -Eigen::MatrixXf::Identity(A_f.rows(), A_f.rows()), 'h');
+		Eigen :: ArrayXXf A_coll = addCollisionSlack(prob_data, A_f);
 		
 		prob_data.A_coll = A_coll;
 		prob_data.b_coll = b_coll;
@@ -822,6 +1026,38 @@ void initializeOptimizer(probData &prob_data, int VERBOSE){
 	prob_data.f_max = params["f_max"].as<float>() * prob_data.gravity;
 
 	prob_data.solver = params["solver"].as<std::string>();
+	if(prob_data.solver != "quadprog" && prob_data.solver != "admm" && prob_data.solver != "qpoases"){
+		ROS_WARN_STREAM("Unknown solver " << prob_data.solver << ", using quadprog");
+		prob_data.solver = "quadprog";
+	}
+	prob_data.qp_settings.max_iter = params["admm_max_iter"].as<int>();
+	prob_data.qp_settings.rho = params["admm_rho"].as<double>();
+	prob_data.qp_settings.eps_abs = params["admm_eps_abs"].as<double>();
+	prob_data.qp_settings.eps_rel = params["admm_eps_rel"].as<double>();
+	prob_data.hot_qp = std :: make_shared<HotQP>(params["qpoases_max_nwsr"].as<int>());
+	prob_data.sparse_qp = std :: make_shared<SparseQP>(prob_data.qp_settings);
+	prob_data.qp_changes.clear();
+
+	prob_data.slack_mode = params["slack_mode"].as<std::string>();
+	if(prob_data.slack_mode != "step" && prob_data.slack_mode != "obstacle" && prob_data.slack_mode != "penalty"){
+		ROS_WARN_STREAM("Unknown slack_mode " << prob_data.slack_mode << ", using step");
+		prob_data.slack_mode = "step";
+	}
+	if(prob_data.slack_mode == "penalty" && prob_data.solver != "admm"){
+		ROS_WARN_STREAM("slack_mode penalty needs the admm solver, using obstacle");
+		prob_data.slack_mode = "obstacle";
+	}
+	// With one slack per step two obstacles already overflow the qpOASES arrays (num = 30), such QPs would all run on quadprog
+	if(prob_data.slack_mode == "step" && prob_data.solver == "qpoases"){
+		ROS_WARN_STREAM("slack_mode step does not fit the qpoases solver, using obstacle");
+		prob_data.slack_mode = "obstacle";
+	}
+
+	prob_data.scp_max_iter = std :: max(params["scp_max_iter"].as<int>(), 1);
+	prob_data.trust_region = params["scp_trust_region"].as<float>();
+	prob_data.scp_tol_cost = params["scp_tol_cost"].as<float>();
+	prob_data.scp_tol_coll = params["scp_tol_coll"].as<float>();
+	prob_data.scp_iters.clear();
 	prob_data.mpc_step = 0;
 
 	// @ Initial State
@@ -921,6 +1157,8 @@ void initializeOptimizer(probData &prob_data, int VERBOSE){
 	else	
 		ROS_ERROR_STREAM("Invalid order_smoothness value");
 
+	assembleConstraints(prob_data);
+
 
 	prob_data.num_drone = 0;
 	prob_data.num_static_obs = 0;
@@ -946,12 +1184,8 @@ void deployAgent(probData &prob_data, int VERBOSE){
 			prob_data.num_static_obs = 0;
 	}
 	
-	// @ Solve xyz
-	// if(prob_data.solver=="quadprog")
-		computeXYZ(prob_data, VERBOSE);
-	
-	// else
-	// 	computeXYZ2(prob_data, VERBOSE);
+	// @ Solve xyz, the QP backend is picked by prob_data.solver
+	computeXYZ(prob_data, VERBOSE);
 
 	
 	prob_data.smoothness.push_back(sqrt(pow(prob_data.ax_init, 2) + pow(prob_data.ay_init, 2) + pow(prob_data.az_init, 2)));
@@ -73,6 +73,10 @@ void initializeOptimizer(probData &prob_data, int VERBOSE){
 	prob_data.rho_ineq_max = params["rho_ineq_max"].as<float>();
 
 	prob_data.axis_wise = params["axis_wise"].as<bool>();
+	prob_data.trig_free = params["trig_free"].as<bool>();
+	prob_data.warm_start = params["warm_start"].as<bool>();
+	prob_data.warm_start_decay = params["warm_start_decay"].as<float>();
+	initTelemetry(prob_data.telemetry, params["telemetry_capacity"].as<int>());
 	prob_data.jerk_snap_constraints = params["jerk_snap_constraints"].as<bool>();
 	if(!prob_data.axis_wise){
 		prob_data.vel_max = params["vel_max"].as<float>();
@@ -123,40 +127,20 @@ void initializeOptimizer(probData &prob_data, int VERBOSE){
 	prob_data.y_ref = Eigen :: ArrayXXf :: Ones(prob_data.kappa, 1) * prob_data.y_goal;
 	prob_data.z_ref = Eigen :: ArrayXXf :: Ones(prob_data.kappa, 1) * prob_data.z_goal;
 	
-	// @ Compute Bernstein P, Pdot, Pddot,... matrix
-	Eigen :: ArrayXf tot_time = Eigen :: ArrayXf(prob_data.num);
-	Eigen :: ArrayXf tot_time_up = Eigen :: ArrayXf(prob_data.num_up);
-	
-	tot_time.setLinSpaced(prob_data.num, 0.0, prob_data.t_plan);
-	tot_time_up.setLinSpaced(prob_data.num_up, 0.0, prob_data.t_plan);
-
-	five_var PPP = computeBernstein(tot_time, prob_data.t_plan, prob_data.num);
-	prob_data.nvar = PPP.a.cols();
-	prob_data.P = PPP.a;
-	prob_data.Pdot = PPP.b;
-	prob_data.Pddot = PPP.c;
-	prob_data.Pdddot = PPP.d;
-	prob_data.Pddddot = PPP.e;
-
-	five_var PPP_up = computeBernstein(tot_time_up, prob_data.t_plan, prob_data.num_up);
-	prob_data.P_up = PPP_up.a;
-	prob_data.Pdot_up = PPP_up.b;
-	prob_data.Pddot_up = PPP_up.c;
-	prob_data.Pdddot_up = PPP_up.d;
-	prob_data.Pddddot_up = PPP_up.e;
-
-	
-	// @ Position Constraints
-	prob_data.A_ineq = stack(prob_data.P, -prob_data.P, 'v');
+	// @ Bernstein P, Pdot, Pddot,... matrix and the constant costs, computed once per horizon for all agents
+	prob_data.basis = getBasis(prob_data.num, prob_data.num_up, prob_data.t_plan, prob_data.kappa, params["order_smoothness"].as<int>(), 
+								prob_data.axis_wise, params["basis_cache_dir"].as<std :: string>());
+	const basisCache &basis = *prob_data.basis;
+	prob_data.nvar = basis.P.cols();
+	prob_data.fixed_basis = prob_data.num == FIXED_NUM && prob_data.kappa == FIXED_KAPPA && prob_data.nvar == 11;
 
+	// @ Position Constraints, A_ineq and the other constant matrices are read from basis
 	prob_data.b_x_ineq = stack(prob_data.x_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), -prob_data.x_min * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), 'v');
 	prob_data.b_y_ineq = stack(prob_data.y_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), -prob_data.y_min * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), 'v');
 	prob_data.b_z_ineq = stack(prob_data.z_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), -prob_data.z_min * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), 'v');
 
 	
 	// @ Initial Conditions
-	prob_data.A_eq = stack(prob_data.P.row(0), stack(prob_data.Pdot.row(0), prob_data.Pddot.row(0), 'v'), 'v');
-
 	prob_data.b_x_eq = Eigen :: ArrayXXf(3, 1);
 	prob_data.b_y_eq = Eigen :: ArrayXXf(3, 1);
 	prob_data.b_z_eq = Eigen :: ArrayXXf(3, 1);
@@ -166,30 +150,36 @@ void initializeOptimizer(probData &prob_data, int VERBOSE){
 	prob_data.b_z_eq << prob_data.z_init, prob_data.vz_init, prob_data.az_init;
 
 	
+	prob_data.num_iters = 0;
+
+	// @ Collision Avoidance Constraint Matrices, every block is P
+	initRepeatedBlock(prob_data.A_static_obs, basis.P, basis.gram_P, prob_data.num_static_obs);
+	initRepeatedBlock(prob_data.A_drone, basis.P, basis.gram_P, prob_data.num_drone);
+
 	// @ Static Obstacle Avoidance Constraints
 	if(prob_data.num_static_obs!=0){
-		prob_data.A_static_obs = prob_data.P;
-		for(int i = 0; i < prob_data.num_static_obs - 1; i++) prob_data.A_static_obs = stack(prob_data.A_static_obs, prob_data.P, 'v');
-		
 		prob_data.alpha_static_obs = Eigen :: ArrayXXf :: Zero(prob_data.num_static_obs, prob_data.num);
+		prob_data.dir_x_static_obs = cos(prob_data.alpha_static_obs);
+		prob_data.dir_y_static_obs = sin(prob_data.alpha_static_obs);
 		prob_data.d_static_obs = Eigen :: ArrayXXf :: Ones(prob_data.num_static_obs, prob_data.num);
 		prob_data.d_static_obs_old = prob_data.d_static_obs;
 
-		prob_data.x_static_obs = (Eigen :: ArrayXXf :: Ones(prob_data.num_static_obs, prob_data.num)).colwise() * x_static_obs; 
-		prob_data.y_static_obs = (Eigen :: ArrayXXf :: Ones(prob_data.num_static_obs, prob_data.num)).colwise() * y_static_obs;
-		prob_data.z_static_obs = (Eigen :: ArrayXXf :: Ones(prob_data.num_static_obs, prob_data.num)).colwise() * z_static_obs;
-
-		prob_data.a_static_obs = (Eigen :: ArrayXXf :: Ones(prob_data.num_static_obs, prob_data.num)).colwise() * a_static_obs + prob_data.buffer + params["a_drone"].as<float>();
-		prob_data.b_static_obs = (Eigen :: ArrayXXf :: Ones(prob_data.num_static_obs, prob_data.num)).colwise() * b_static_obs + prob_data.buffer + params["b_drone"].as<float>();
-		prob_data.c_static_obs = (Eigen :: ArrayXXf :: Ones(prob_data.num_static_obs, prob_data.num)).colwise() * c_static_obs + prob_data.buffer + params["c_drone"].as<float>();
-
-		prob_data.x_static_obs_og = prob_data.x_static_obs;
-		prob_data.y_static_obs_og = prob_data.y_static_obs;
-		prob_data.z_static_obs_og = prob_data.z_static_obs;
-
-		prob_data.a_static_obs_og = prob_data.a_static_obs;
-		prob_data.b_static_obs_og = prob_data.b_static_obs;
-		prob_data.c_static_obs_og = prob_data.c_static_obs;
+		// One record per obstacle, initObstacles() builds the num_static_obs x num arrays of the candidates
+		prob_data.x_static_obs_og = x_static_obs;
+		prob_data.y_static_obs_og = y_static_obs;
+		prob_data.z_static_obs_og = z_static_obs;
+
+		prob_data.a_static_obs_og = a_static_obs + prob_data.buffer + params["a_drone"].as<float>();
+		prob_data.b_static_obs_og = b_static_obs + prob_data.buffer + params["b_drone"].as<float>();
+		prob_data.c_static_obs_og = c_static_obs + prob_data.buffer + params["c_drone"].as<float>();
+
+		// Footprints inflated by prox_obs, initObstacles() only tests the ones near the prediction
+		Eigen :: ArrayXXf boxes(prob_data.num_static_obs, 4);
+		boxes.col(0) = prob_data.x_static_obs_og - prob_data.a_static_obs_og - prob_data.prox_obs;
+		boxes.col(1) = prob_data.y_static_obs_og - prob_data.b_static_obs_og - prob_data.prox_obs;
+		boxes.col(2) = prob_data.x_static_obs_og + prob_data.a_static_obs_og + prob_data.prox_obs;
+		boxes.col(3) = prob_data.y_static_obs_og + prob_data.b_static_obs_og + prob_data.prox_obs;
+		buildBVH(prob_data.obs_bvh, boxes);
 	}
 	
 	prob_data.lx_drone = params["a_drone"].as<float>();
@@ -206,11 +196,11 @@ void initializeOptimizer(probData &prob_data, int VERBOSE){
 	
 		prob_data.alpha_drone = Eigen :: ArrayXXf :: Zero(prob_data.num_drone, prob_data.num);
 		prob_data.beta_drone = Eigen :: ArrayXXf :: Ones(prob_data.num_drone, prob_data.num) * M_PI_2;
+		prob_data.dir_x_drone = cos(prob_data.alpha_drone) * sin(prob_data.beta_drone);
+		prob_data.dir_y_drone = sin(prob_data.alpha_drone) * sin(prob_data.beta_drone);
+		prob_data.dir_z_drone = cos(prob_data.beta_drone);
 		prob_data.d_drone = Eigen :: ArrayXXf :: Ones(prob_data.num_drone, prob_data.num);
 		prob_data.d_drone_old = prob_data.d_drone;
-
-		prob_data.A_drone = prob_data.P;    
-		for(int i = 0; i < prob_data.num_drone - 1; i++) prob_data.A_drone = stack(prob_data.A_drone, prob_data.P, 'v');
 	}
 	else{
 		ROS_WARN_STREAM("Only one drone in environment");
@@ -220,36 +210,44 @@ void initializeOptimizer(probData &prob_data, int VERBOSE){
 		// @ Velocity Constraints
 		prob_data.alpha_vel = Eigen :: ArrayXXf :: Zero(prob_data.num, 1);
 		prob_data.beta_vel = Eigen :: ArrayXXf :: Ones(prob_data.num, 1) * M_PI_2;
+		prob_data.dir_x_vel = cos(prob_data.alpha_vel) * sin(prob_data.beta_vel);
+		prob_data.dir_y_vel = sin(prob_data.alpha_vel) * sin(prob_data.beta_vel);
+		prob_data.dir_z_vel = cos(prob_data.beta_vel);
 		prob_data.d_vel = Eigen :: ArrayXXf :: Ones(prob_data.num, 1) * prob_data.vel_max * 0;
 		
 		// @ Acceleration Constraints
 		prob_data.alpha_acc = Eigen :: ArrayXXf :: Zero(prob_data.num, 1);
 		prob_data.beta_acc = Eigen :: ArrayXXf :: Ones(prob_data.num, 1) * M_PI_2;
+		prob_data.dir_x_acc = cos(prob_data.alpha_acc) * sin(prob_data.beta_acc);
+		prob_data.dir_y_acc = sin(prob_data.alpha_acc) * sin(prob_data.beta_acc);
+		prob_data.dir_z_acc = cos(prob_data.beta_acc);
 		prob_data.d_acc = Eigen :: ArrayXXf :: Ones(prob_data.num, 1) * prob_data.acc_max * 0;
 		
 		
 		// @ Jerk Constraints
 		prob_data.alpha_jerk = Eigen :: ArrayXXf :: Zero(prob_data.num, 1);
 		prob_data.beta_jerk = Eigen :: ArrayXXf :: Ones(prob_data.num, 1) * M_PI_2;
+		prob_data.dir_x_jerk = cos(prob_data.alpha_jerk) * sin(prob_data.beta_jerk);
+		prob_data.dir_y_jerk = sin(prob_data.alpha_jerk) * sin(prob_data.beta_jerk);
+		prob_data.dir_z_jerk = cos(prob_data.beta_jerk);
 		prob_data.d_jerk = Eigen :: ArrayXXf :: Ones(prob_data.num, 1) * prob_data.jerk_max * 0;
 		
 		
 		// @ Snap Constraints
 		prob_data.alpha_snap = Eigen :: ArrayXXf :: Zero(prob_data.num, 1);
 		prob_data.beta_snap = Eigen :: ArrayXXf :: Ones(prob_data.num, 1) * M_PI_2;
+		prob_data.dir_x_snap = cos(prob_data.alpha_snap) * sin(prob_data.beta_snap);
+		prob_data.dir_y_snap = sin(prob_data.alpha_snap) * sin(prob_data.beta_snap);
+		prob_data.dir_z_snap = cos(prob_data.beta_snap);
 		prob_data.d_snap = Eigen :: ArrayXXf :: Ones(prob_data.num, 1) * prob_data.snap_max * 0;
 	}
 	else{
 		// @ Velocity Constraints
-		prob_data.A_v_ineq = stack(prob_data.Pdot, -prob_data.Pdot, 'v');
-
 		prob_data.b_vx_ineq = stack(prob_data.vel_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), prob_data.vel_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), 'v');
 		prob_data.b_vy_ineq = stack(prob_data.vel_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), prob_data.vel_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), 'v');
 		prob_data.b_vz_ineq = stack(prob_data.vel_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), prob_data.vel_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), 'v');
 
 		// @ Acceleration Constraints
-		prob_data.A_a_ineq = stack(prob_data.Pddot, -prob_data.Pddot, 'v');
-
 		if(!prob_data.use_thrust_values && prob_data.world == 2){
 			prob_data.b_ax_ineq = stack(prob_data.acc_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), prob_data.acc_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), 'v');
 			prob_data.b_ay_ineq = stack(prob_data.acc_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), prob_data.acc_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), 'v');
@@ -272,49 +270,19 @@ void initializeOptimizer(probData &prob_data, int VERBOSE){
 			
 		}
 		// @ Jerk Constraints
-		prob_data.A_j_ineq = stack(prob_data.Pdddot, -prob_data.Pdddot, 'v');
-
 		prob_data.b_jx_ineq = stack(prob_data.jerk_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), prob_data.jerk_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), 'v');
 		prob_data.b_jy_ineq = stack(prob_data.jerk_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), prob_data.jerk_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), 'v');
 		prob_data.b_jz_ineq = stack(prob_data.jerk_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), prob_data.jerk_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), 'v');
 
 		// @ Snap Constraints
-		prob_data.A_s_ineq = stack(prob_data.Pddddot, -prob_data.Pddddot, 'v');
-
 		prob_data.b_sx_ineq = stack(prob_data.snap_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), prob_data.snap_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), 'v');
 		prob_data.b_sy_ineq = stack(prob_data.snap_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), prob_data.snap_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), 'v');
 		prob_data.b_sz_ineq = stack(prob_data.snap_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), prob_data.snap_max * Eigen :: ArrayXXf :: Ones(prob_data.num, 1), 'v');
 	}
 	
-	// @ Constant Costs
-	prob_data.cost_ineq = prob_data.A_ineq.transpose().matrix() * prob_data.A_ineq.matrix();
-	if(prob_data.params["order_smoothness"].as<int>() == 4)
-		prob_data.cost_smoothness = prob_data.Pddddot.transpose().matrix() * prob_data.Pddddot.matrix();
-	else if(prob_data.params["order_smoothness"].as<int>() == 3)
-		prob_data.cost_smoothness = prob_data.Pdddot.transpose().matrix() * prob_data.Pdddot.matrix();
-	else if(prob_data.params["order_smoothness"].as<int>() == 2)
-		prob_data.cost_smoothness = prob_data.Pddot.transpose().matrix() * prob_data.Pddot.matrix();
-	else	
-		ROS_ERROR_STREAM("Invalid order_smoothness value");
-
-	
-	prob_data.cost_goal = prob_data.P.bottomRows(prob_data.kappa).transpose().matrix() * prob_data.P.bottomRows(prob_data.kappa).matrix();    
-	prob_data.I = Eigen :: ArrayXXf(prob_data.nvar + prob_data.A_eq.rows(), prob_data.nvar + prob_data.A_eq.rows());
+	prob_data.I = Eigen :: ArrayXXf(prob_data.nvar + basis.A_eq.rows(), prob_data.nvar + basis.A_eq.rows());
 	prob_data.I.matrix().setIdentity();
 
-	if(!prob_data.axis_wise){
-		prob_data.cost_vel = prob_data.Pdot.transpose().matrix() * prob_data.Pdot.matrix();
-		prob_data.cost_acc = prob_data.Pddot.transpose().matrix() * prob_data.Pddot.matrix();
-		prob_data.cost_jerk = prob_data.Pdddot.transpose().matrix() * prob_data.Pdddot.matrix();
-		prob_data.cost_snap = prob_data.Pddddot.transpose().matrix() * prob_data.Pddddot.matrix();
-	}
-	else{
-		prob_data.cost_vel = prob_data.A_v_ineq.transpose().matrix() * prob_data.A_v_ineq.matrix();
-		prob_data.cost_acc = prob_data.A_a_ineq.transpose().matrix() * prob_data.A_a_ineq.matrix();
-		prob_data.cost_jerk = prob_data.A_j_ineq.transpose().matrix() * prob_data.A_j_ineq.matrix();
-		prob_data.cost_snap = prob_data.A_s_ineq.transpose().matrix() * prob_data.A_s_ineq.matrix();
-	}
-	
 	prob_data.x = prob_data.x_init * Eigen :: ArrayXXf :: Ones(prob_data.num, 1);
 	prob_data.xdot = Eigen :: ArrayXXf :: Zero(prob_data.num, 1);
 	prob_data.xddot = Eigen :: ArrayXXf :: Zero(prob_data.num, 1);
@@ -333,8 +301,12 @@ void initializeOptimizer(probData &prob_data, int VERBOSE){
 	prob_data.zdddot = Eigen :: ArrayXXf :: Zero(prob_data.num, 1);
 	prob_data.zddddot = Eigen :: ArrayXXf :: Zero(prob_data.num, 1);
 
+	// @ Workspace for the largest neighbourhood, every other agent and obstacle
+	reserveWorkspace(prob_data, prob_data.num_drone + prob_data.num_static_obs);
+
 	prob_data.num_drone = 0;
 	prob_data.num_static_obs = 0;
+	prob_data.num_allocs = 0;
 
 	
 }
@@ -348,6 +320,9 @@ void deployAgent(probData &prob_data, int VERBOSE){
 	}
 	// @ Initialize alpha betas ds
 	if(prob_data.mpc_step > 0){
+		// Pin the board buffer read during this step
+		prob_data.board_epoch = prob_data.board->epoch;
+
 		// @ Neighboring agents and obstacles -- don't change the order 
 		if(!prob_data.free_space)
 			initObstacles(prob_data, VERBOSE);
@@ -363,6 +338,9 @@ void deployAgent(probData &prob_data, int VERBOSE){
 	
 
 	// @ Solve xyz
+	size_t num_allocs = threadAllocCount();
+	auto start = std :: chrono :: high_resolution_clock :: now();
+	prob_data.step_telemetry = stepTelemetry();
 	if(prob_data.axis_wise){
 		if(prob_data.world == 2)
 			computeXYAxis(prob_data, VERBOSE);
@@ -375,6 +353,10 @@ void deployAgent(probData &prob_data, int VERBOSE){
 		else if(prob_data.world == 3)
 			computeXYZ(prob_data, VERBOSE);
 	}
+	prob_data.num_allocs = threadAllocCount() - num_allocs;
+	
+	prob_data.step_telemetry.time_total = std :: chrono :: duration<float>(std :: chrono :: high_resolution_clock :: now() - start).count();
+	recordTelemetry(prob_data);
 
 	prob_data.smoothness.push_back(sqrt(pow(prob_data.ax_init, 2) + pow(prob_data.ay_init, 2) + pow(prob_data.az_init, 2)));
 	prob_data.arc_length.push_back(sqrt(pow(prob_data.x_init - prob_data.x(1), 2) + pow(prob_data.y_init - prob_data.y(1), 2) + pow(prob_data.z_init - prob_data.z(1), 2)));
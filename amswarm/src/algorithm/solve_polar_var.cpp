@@ -1,96 +1,225 @@
 #include "algorithm/amswarm/solve_polar_var.hpp"
+#include "algorithm/amswarm/fast_trig.hpp"
 
-void initAlpha(probData &prob_data, int VERBOSE){
-    Eigen :: ArrayXXf ws_alpha_static_obs, wc_alpha_static_obs,
-                        ws_alpha_drone, wc_alpha_drone,
-                        ws_alpha_vel, wc_alpha_vel,
-                        ws_alpha_acc, wc_alpha_acc,
-                        ws_alpha_jerk, wc_alpha_jerk,
-                        ws_alpha_snap, wc_alpha_snap;
-    Eigen :: ArrayXXf c1_d, c2_d;
+// Fused polar kernels: for every (neighbour, timestep) the angle(s), their sin/cos and the
+// projected d are computed in one pass straight into prob_data, without Eigen temporaries.
+// Arrays are num_obs x num (column major), so the inner simd loop runs over the neighbours.
+// With trig_free the angles are skipped and only the unit directions are formed (sqrt/divide)
 
-    // @ Static Obstacles
-    if(prob_data.num_static_obs!=0){
-        ws_alpha_static_obs = (-prob_data.y_static_obs).rowwise() + prob_data.y.transpose().row(0);
-        wc_alpha_static_obs = (-prob_data.x_static_obs).rowwise() + prob_data.x.transpose().row(0);
-        prob_data.alpha_static_obs = arctan2(ws_alpha_static_obs * prob_data.a_static_obs, wc_alpha_static_obs * prob_data.b_static_obs);
+static inline float unitDir(float y, float x, float &s, float &c)
+{
+    // sin/cos of atan2(y, x) from the vector itself, (0, 1) at the origin like atan2(0, 0) = 0
+    float r = std :: sqrt(x*x + y*y);
+    float inv = 1.0f / std :: fmax(r, FLT_MIN);
+    c = r > 0.0f ? x * inv : 1.0f;
+    s = y * inv;
+    return r;
+}
 
-        c1_d = pow(prob_data.a_static_obs, 2) * pow(cos(prob_data.alpha_static_obs), 2) + pow(prob_data.b_static_obs, 2) * pow(sin(prob_data.alpha_static_obs), 2);
-        c2_d = prob_data.a_static_obs * wc_alpha_static_obs * cos(prob_data.alpha_static_obs) + prob_data.b_static_obs * ws_alpha_static_obs * sin(prob_data.alpha_static_obs);
+static inline float angleDir(float y, float x, float &s, float &c)
+{
+    float angle = fastAtan2(y, x);
+    fastSinCos(angle, s, c);
+    return angle;
+}
 
-        // prob_data.d_static_obs = (c2_d/c1_d).max(1.0);
-        if(prob_data.d_static_obs_old.rows() != prob_data.num_static_obs){
-            prob_data.d_static_obs_old = Eigen :: ArrayXXf :: Ones(prob_data.num_static_obs, prob_data.num);
+static void shiftDistOld(Eigen :: ArrayXXf &d_old, int num_obs, int num)
+{
+    if(d_old.rows() != num_obs){
+        d_old = Eigen :: ArrayXXf :: Ones(num_obs, num);
+    }
+    else{
+        d_old.rightCols(num - 1) = d_old.leftCols(num - 1);
+        d_old.col(0) = 1.0;
+    }
+}
+
+static void polarEllipse(probData &prob_data, const Eigen :: ArrayXXf &x_obs, const Eigen :: ArrayXXf &y_obs,
+                        const Eigen :: ArrayXXf &a_obs, const Eigen :: ArrayXXf &b_obs,
+                        Eigen :: ArrayXXf &alpha, Eigen :: ArrayXXf &dir_x, Eigen :: ArrayXXf &dir_y,
+                        Eigen :: ArrayXXf &d, Eigen :: ArrayXXf &d_old)
+{
+    int num_obs = x_obs.rows();
+    float relax = 1.0 - prob_data.gamma;
+    bool trig_free = prob_data.trig_free;
+
+    alpha.resize(num_obs, prob_data.num);
+    dir_x.resize(num_obs, prob_data.num);
+    dir_y.resize(num_obs, prob_data.num);
+    d.resize(num_obs, prob_data.num);
+    shiftDistOld(d_old, num_obs, prob_data.num);
+
+    for(int t = 0; t < prob_data.num; t++){
+        const float x = prob_data.x(t), y = prob_data.y(t);
+        const float *xo = x_obs.data() + t*num_obs, *yo = y_obs.data() + t*num_obs;
+        const float *a = a_obs.data() + t*num_obs, *b = b_obs.data() + t*num_obs;
+        float *alpha_t = alpha.data() + t*num_obs, *dir_x_t = dir_x.data() + t*num_obs, *dir_y_t = dir_y.data() + t*num_obs;
+        float *d_t = d.data() + t*num_obs, *d_old_t = d_old.data() + t*num_obs;
+
+        #pragma omp simd
+        for(int i = 0; i < num_obs; i++){
+            float wc = x - xo[i], ws = y - yo[i];
+            float sa, ca;
+            if(trig_free) unitDir(ws * a[i], wc * b[i], sa, ca);
+            else alpha_t[i] = angleDir(ws * a[i], wc * b[i], sa, ca);
+
+            float c1 = a[i]*a[i] * ca*ca + b[i]*b[i] * sa*sa;
+            float c2 = a[i] * wc * ca + b[i] * ws * sa;
+
+            dir_x_t[i] = ca;
+            dir_y_t[i] = sa;
+            d_t[i] = std :: fmax(c2/c1, 1.0f + relax * (d_old_t[i] - 1.0f));
+            d_old_t[i] = d_t[i];
         }
-        else{
-            prob_data.d_static_obs_old.rightCols(prob_data.num - 1) = prob_data.d_static_obs_old.leftCols(prob_data.num - 1);
-            prob_data.d_static_obs_old.col(0) = 1.0; 
+    }
+}
+
+static void polarEllipsoid(probData &prob_data, const Eigen :: ArrayXXf &x_obs, const Eigen :: ArrayXXf &y_obs, const Eigen :: ArrayXXf &z_obs,
+                        const Eigen :: ArrayXXf &a_obs, const Eigen :: ArrayXXf &b_obs, const Eigen :: ArrayXXf &c_obs,
+                        Eigen :: ArrayXXf &alpha, Eigen :: ArrayXXf &beta, Eigen :: ArrayXXf &dir_x, Eigen :: ArrayXXf &dir_y, Eigen :: ArrayXXf &dir_z,
+                        Eigen :: ArrayXXf &d, Eigen :: ArrayXXf &d_old)
+{
+    int num_obs = x_obs.rows();
+    float relax = 1.0 - prob_data.gamma;
+    bool trig_free = prob_data.trig_free;
+
+    alpha.resize(num_obs, prob_data.num);
+    beta.resize(num_obs, prob_data.num);
+    dir_x.resize(num_obs, prob_data.num);
+    dir_y.resize(num_obs, prob_data.num);
+    dir_z.resize(num_obs, prob_data.num);
+    d.resize(num_obs, prob_data.num);
+    shiftDistOld(d_old, num_obs, prob_data.num);
+
+    for(int t = 0; t < prob_data.num; t++){
+        const float x = prob_data.x(t), y = prob_data.y(t), z = prob_data.z(t);
+        const float *xo = x_obs.data() + t*num_obs, *yo = y_obs.data() + t*num_obs, *zo = z_obs.data() + t*num_obs;
+        const float *a = a_obs.data() + t*num_obs, *b = b_obs.data() + t*num_obs, *c = c_obs.data() + t*num_obs;
+        float *alpha_t = alpha.data() + t*num_obs, *beta_t = beta.data() + t*num_obs;
+        float *dir_x_t = dir_x.data() + t*num_obs, *dir_y_t = dir_y.data() + t*num_obs, *dir_z_t = dir_z.data() + t*num_obs;
+        float *d_t = d.data() + t*num_obs, *d_old_t = d_old.data() + t*num_obs;
+
+        #pragma omp simd
+        for(int i = 0; i < num_obs; i++){
+            float wc = x - xo[i], ws = y - yo[i], wc_beta = z - zo[i];
+
+            // wc / (a cos(alpha)) = |(b wc, a ws)| / (a b), also avoids 0/0 when alpha = +-pi/2
+            float r = std :: sqrt(ws*ws * a[i]*a[i] + wc*wc * b[i]*b[i]) / (a[i] * b[i]);
+            float sa, ca, sb, cb;
+            if(trig_free){
+                unitDir(ws * a[i], wc * b[i], sa, ca);
+                unitDir(r, wc_beta / c[i], sb, cb);
+            }
+            else{
+                alpha_t[i] = angleDir(ws * a[i], wc * b[i], sa, ca);
+                beta_t[i] = angleDir(r, wc_beta / c[i], sb, cb);
+            }
+
+            float c1 = sb*sb * ca*ca * a[i]*a[i] + sa*sa * sb*sb * b[i]*b[i] + cb*cb * c[i]*c[i];
+            float c2 = wc * sb * ca * a[i] + ws * sa * sb * b[i] + wc_beta * cb * c[i];
+
+            dir_x_t[i] = ca * sb;
+            dir_y_t[i] = sa * sb;
+            dir_z_t[i] = cb;
+            d_t[i] = std :: fmax(c2/c1, 1.0f + relax * (d_old_t[i] - 1.0f));
+            d_old_t[i] = d_t[i];
         }
+    }
+}
 
-        prob_data.d_static_obs = (c2_d/c1_d).max(1.0 + (1.0 - prob_data.gamma) * (prob_data.d_static_obs_old - 1.0));
-        prob_data.d_static_obs_old = prob_data.d_static_obs;
-        
+static void polarBound(const probData &prob_data, const Eigen :: ArrayXXf &wc_alpha, const Eigen :: ArrayXXf &ws_alpha,
+                        Eigen :: ArrayXXf &alpha, Eigen :: ArrayXXf &dir_x, Eigen :: ArrayXXf &dir_y, Eigen :: ArrayXXf &d, float d_max)
+{
+    int n = wc_alpha.size();
+    bool trig_free = prob_data.trig_free;
+    const float *wc = wc_alpha.data(), *ws = ws_alpha.data();
+
+    alpha.resize(wc_alpha.rows(), wc_alpha.cols());
+    dir_x.resize(wc_alpha.rows(), wc_alpha.cols());
+    dir_y.resize(wc_alpha.rows(), wc_alpha.cols());
+    d.resize(wc_alpha.rows(), wc_alpha.cols());
+    float *alpha_i = alpha.data(), *dir_x_i = dir_x.data(), *dir_y_i = dir_y.data(), *d_i = d.data();
+
+    #pragma omp simd
+    for(int i = 0; i < n; i++){
+        float sa, ca;
+        if(trig_free) unitDir(ws[i], wc[i], sa, ca);
+        else alpha_i[i] = angleDir(ws[i], wc[i], sa, ca);
+
+        dir_x_i[i] = ca;
+        dir_y_i[i] = sa;
+        d_i[i] = std :: fmin((wc[i]*ca + ws[i]*sa) / (ca*ca + sa*sa), d_max);
     }
+}
 
-    // @ Inter-Agent Collision Avoidance
-    if(prob_data.num_drone!=0){
-        ws_alpha_drone = (-prob_data.y_drone).rowwise() + prob_data.y.transpose().row(0);
-        wc_alpha_drone = (-prob_data.x_drone).rowwise() + prob_data.x.transpose().row(0);
-        prob_data.alpha_drone = arctan2(ws_alpha_drone * prob_data.a_drone, wc_alpha_drone * prob_data.b_drone);
-
-        c1_d = pow(prob_data.a_drone, 2) * pow(cos(prob_data.alpha_drone), 2) + pow(prob_data.b_drone, 2) * pow(sin(prob_data.alpha_drone), 2);
-        c2_d = prob_data.a_drone * wc_alpha_drone * cos(prob_data.alpha_drone) + prob_data.b_drone * ws_alpha_drone * sin(prob_data.alpha_drone);
-    
-        // prob_data.d_drone = (c2_d/c1_d).max(1.0);
-        if(prob_data.d_drone_old.rows() != prob_data.num_drone){
-            prob_data.d_drone_old = Eigen :: ArrayXXf :: Ones(prob_data.num_drone, prob_data.num);
+static void polarBound(const probData &prob_data, const Eigen :: ArrayXXf &wc_alpha, const Eigen :: ArrayXXf &ws_alpha, const Eigen :: ArrayXXf &wc_beta, float wc_beta_offset,
+                        Eigen :: ArrayXXf &alpha, Eigen :: ArrayXXf &beta, Eigen :: ArrayXXf &dir_x, Eigen :: ArrayXXf &dir_y, Eigen :: ArrayXXf &dir_z,
+                        Eigen :: ArrayXXf &d, float d_min, float d_max)
+{
+    int n = wc_alpha.size();
+    bool trig_free = prob_data.trig_free;
+    const float *wc = wc_alpha.data(), *ws = ws_alpha.data(), *wb = wc_beta.data();
+
+    alpha.resize(wc_alpha.rows(), wc_alpha.cols());
+    beta.resize(wc_alpha.rows(), wc_alpha.cols());
+    dir_x.resize(wc_alpha.rows(), wc_alpha.cols());
+    dir_y.resize(wc_alpha.rows(), wc_alpha.cols());
+    dir_z.resize(wc_alpha.rows(), wc_alpha.cols());
+    d.resize(wc_alpha.rows(), wc_alpha.cols());
+    float *alpha_i = alpha.data(), *beta_i = beta.data(), *d_i = d.data();
+    float *dir_x_i = dir_x.data(), *dir_y_i = dir_y.data(), *dir_z_i = dir_z.data();
+
+    #pragma omp simd
+    for(int i = 0; i < n; i++){
+        float wz = wb[i] + wc_beta_offset;
+        float r = std :: sqrt(wc[i]*wc[i] + ws[i]*ws[i]);
+        float sa, ca, sb, cb;
+        if(trig_free){
+            unitDir(ws[i], wc[i], sa, ca);
+            unitDir(r, wz, sb, cb);
         }
         else{
-            prob_data.d_drone_old.rightCols(prob_data.num - 1) = prob_data.d_drone_old.leftCols(prob_data.num - 1);
-            prob_data.d_drone_old.col(0) = 1.0; 
+            alpha_i[i] = angleDir(ws[i], wc[i], sa, ca);
+            beta_i[i] = angleDir(r, wz, sb, cb);
         }
 
-        prob_data.d_drone = (c2_d/c1_d).max(1.0 + (1.0 - prob_data.gamma) * (prob_data.d_drone_old - 1.0));	
-        prob_data.d_drone_old = prob_data.d_drone;
+        float c1 = sb*sb * ca*ca + sb*sb * sa*sa + cb*cb;
+        float c2 = wc[i] * sb * ca + ws[i] * sb * sa + wz * cb;
+
+        dir_x_i[i] = ca * sb;
+        dir_y_i[i] = sa * sb;
+        dir_z_i[i] = cb;
+        d_i[i] = std :: fmax(std :: fmin(c2/c1, d_max), d_min);
+    }
+}
+
+void initAlpha(probData &prob_data, int VERBOSE){
+
+    // @ Static Obstacles
+    if(prob_data.num_static_obs!=0){
+        polarEllipse(prob_data, prob_data.x_static_obs, prob_data.y_static_obs, prob_data.a_static_obs, prob_data.b_static_obs,
+                    prob_data.alpha_static_obs, prob_data.dir_x_static_obs, prob_data.dir_y_static_obs, prob_data.d_static_obs, prob_data.d_static_obs_old);
+    }
+
+    // @ Inter-Agent Collision Avoidance
+    if(prob_data.num_drone!=0){
+        polarEllipse(prob_data, prob_data.x_drone, prob_data.y_drone, prob_data.a_drone, prob_data.b_drone,
+                    prob_data.alpha_drone, prob_data.dir_x_drone, prob_data.dir_y_drone, prob_data.d_drone, prob_data.d_drone_old);
     }
-    
+
     if(!prob_data.axis_wise){
         // @ Velocity Constraints
-        wc_alpha_vel = prob_data.xdot;				
-        ws_alpha_vel = prob_data.ydot;
-        prob_data.alpha_vel = arctan2(ws_alpha_vel, wc_alpha_vel);
-        c1_d = pow(cos(prob_data.alpha_vel), 2) + pow(sin(prob_data.alpha_vel), 2);
-        c2_d = wc_alpha_vel*cos(prob_data.alpha_vel) + ws_alpha_vel*sin(prob_data.alpha_vel);
-        
-        prob_data.d_vel = (c2_d/c1_d).min(prob_data.vel_max);
-    
+        polarBound(prob_data, prob_data.xdot, prob_data.ydot, prob_data.alpha_vel, prob_data.dir_x_vel, prob_data.dir_y_vel, prob_data.d_vel, prob_data.vel_max);
+
         // @ Acceleration Constraints
-        wc_alpha_acc = prob_data.xddot;				
-        ws_alpha_acc = prob_data.yddot;
-        prob_data.alpha_acc = arctan2(ws_alpha_acc, wc_alpha_acc);
-        c1_d = pow(cos(prob_data.alpha_acc), 2) + pow(sin(prob_data.alpha_acc), 2);
-        c2_d = wc_alpha_acc*cos(prob_data.alpha_acc) + ws_alpha_acc*sin(prob_data.alpha_acc);
-
-        prob_data.d_acc = (c2_d/c1_d).min(prob_data.acc_max);
-        
+        polarBound(prob_data, prob_data.xddot, prob_data.yddot, prob_data.alpha_acc, prob_data.dir_x_acc, prob_data.dir_y_acc, prob_data.d_acc, prob_data.acc_max);
+
         if(prob_data.jerk_snap_constraints){
             // @ Jerk Constraints
-            wc_alpha_jerk = prob_data.xdddot;				
-            ws_alpha_jerk = prob_data.ydddot;
-            prob_data.alpha_jerk = arctan2(ws_alpha_jerk, wc_alpha_jerk);
-            c1_d = pow(cos(prob_data.alpha_jerk), 2) + pow(sin(prob_data.alpha_jerk), 2);
-            c2_d = wc_alpha_jerk*cos(prob_data.alpha_jerk) + ws_alpha_jerk*sin(prob_data.alpha_jerk);
-
-            prob_data.d_jerk = (c2_d/c1_d).min(prob_data.jerk_max);
+            polarBound(prob_data, prob_data.xdddot, prob_data.ydddot, prob_data.alpha_jerk, prob_data.dir_x_jerk, prob_data.dir_y_jerk, prob_data.d_jerk, prob_data.jerk_max);
 
             // @ Snap Constraints
-            wc_alpha_snap = prob_data.xddddot;				
-            ws_alpha_snap = prob_data.yddddot;
-            prob_data.alpha_snap = arctan2(ws_alpha_snap, wc_alpha_snap);
-            c1_d = pow(cos(prob_data.alpha_snap), 2) + pow(sin(prob_data.alpha_snap), 2);
-            c2_d = wc_alpha_snap*cos(prob_data.alpha_snap) + ws_alpha_snap*sin(prob_data.alpha_snap);
-            
-            prob_data.d_snap = (c2_d/c1_d).min(prob_data.snap_max);
+            polarBound(prob_data, prob_data.xddddot, prob_data.yddddot, prob_data.alpha_snap, prob_data.dir_x_snap, prob_data.dir_y_snap, prob_data.d_snap, prob_data.snap_max);
         }
     }
 }
@@ -98,147 +227,42 @@ void initAlpha(probData &prob_data, int VERBOSE){
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 void initAlphaBeta(probData &prob_data, int VERBOSE)
 {
-    Eigen :: ArrayXXf ws_alpha_static_obs, wc_alpha_static_obs,
-                        ws_alpha_drone, wc_alpha_drone,
-                        ws_alpha_vel, wc_alpha_vel,
-                        ws_alpha_acc, wc_alpha_acc,
-                        ws_alpha_jerk, wc_alpha_jerk,
-                        ws_alpha_snap, wc_alpha_snap,
-                        ws_beta_drone, wc_beta_drone,
-                        ws_beta_vel, wc_beta_vel,
-                        ws_beta_acc, wc_beta_acc,
-                        ws_beta_jerk, wc_beta_jerk,
-                        ws_beta_snap, wc_beta_snap;
-    Eigen :: ArrayXXf c1_d, c2_d;
-
-    
     // @ Static Obstacles
     if(prob_data.num_static_obs!=0){
-        ws_alpha_static_obs = (-prob_data.y_static_obs).rowwise() + prob_data.y.transpose().row(0);
-        wc_alpha_static_obs = (-prob_data.x_static_obs).rowwise() + prob_data.x.transpose().row(0);
-        prob_data.alpha_static_obs = arctan2(ws_alpha_static_obs * prob_data.a_static_obs, wc_alpha_static_obs * prob_data.b_static_obs);
-
-        c1_d = pow(prob_data.a_static_obs, 2) * pow(cos(prob_data.alpha_static_obs), 2) + pow(prob_data.b_static_obs, 2) * pow(sin(prob_data.alpha_static_obs), 2);
-        c2_d = prob_data.a_static_obs * wc_alpha_static_obs * cos(prob_data.alpha_static_obs) + prob_data.b_static_obs * ws_alpha_static_obs * sin(prob_data.alpha_static_obs);
-
-        if(prob_data.d_static_obs_old.rows() != prob_data.num_static_obs){
-            prob_data.d_static_obs_old = Eigen :: ArrayXXf :: Ones(prob_data.num_static_obs, prob_data.num);
-        }
-        else{
-            prob_data.d_static_obs_old.rightCols(prob_data.num - 1) = prob_data.d_static_obs_old.leftCols(prob_data.num - 1);
-            prob_data.d_static_obs_old.col(0) = 1.0; 
-        }
-
-        prob_data.d_static_obs = (c2_d/c1_d).max(1.0 + (1.0 - prob_data.gamma) * (prob_data.d_static_obs_old - 1.0));
-        prob_data.d_static_obs_old = prob_data.d_static_obs;
+        polarEllipse(prob_data, prob_data.x_static_obs, prob_data.y_static_obs, prob_data.a_static_obs, prob_data.b_static_obs,
+                    prob_data.alpha_static_obs, prob_data.dir_x_static_obs, prob_data.dir_y_static_obs, prob_data.d_static_obs, prob_data.d_static_obs_old);
     }
 
-    
     // @ Inter-Agent Collision Avoidance
     if(prob_data.num_drone!=0){
-        
-        ws_alpha_drone = (-prob_data.y_drone).rowwise() + prob_data.y.transpose().row(0);
-        wc_alpha_drone = (-prob_data.x_drone).rowwise() + prob_data.x.transpose().row(0);
-        prob_data.alpha_drone = arctan2(ws_alpha_drone * prob_data.a_drone, wc_alpha_drone * prob_data.b_drone);
-
-        wc_beta_drone = (-prob_data.z_drone).rowwise() + prob_data.z.transpose().row(0);			
-
-        prob_data.beta_drone = Eigen :: ArrayXXf :: Zero(prob_data.num_drone, prob_data.num);
-        for(int i = 0; i < wc_beta_drone.rows()*wc_beta_drone.cols(); i++){
-            prob_data.beta_drone(i) = atan2(wc_alpha_drone(i) / prob_data.a_drone(i) / cos(prob_data.alpha_drone(i)), wc_beta_drone(i) / prob_data.c_drone(i));
-        }
-        
-        c1_d = (pow(sin(prob_data.beta_drone), 2) * pow(cos(prob_data.alpha_drone), 2)) * pow(prob_data.a_drone, 2) + (pow(sin(prob_data.alpha_drone), 2) * pow(sin(prob_data.beta_drone), 2)) * pow(prob_data.b_drone, 2) + pow(cos(prob_data.beta_drone), 2) * pow(prob_data.c_drone, 2);
-        c2_d = (wc_alpha_drone * sin(prob_data.beta_drone) * cos(prob_data.alpha_drone)) * prob_data.a_drone + (ws_alpha_drone * sin(prob_data.alpha_drone) * sin(prob_data.beta_drone)) * prob_data.b_drone + (wc_beta_drone * cos(prob_data.beta_drone)) * prob_data.c_drone;
-    
-        if(prob_data.d_drone_old.rows() != prob_data.num_drone){
-            prob_data.d_drone_old = Eigen :: ArrayXXf :: Ones(prob_data.num_drone, prob_data.num);
-        }
-        else{
-            prob_data.d_drone_old.rightCols(prob_data.num - 1) = prob_data.d_drone_old.leftCols(prob_data.num - 1);
-            prob_data.d_drone_old.col(0) = 1.0; 
-        }
-
-        prob_data.d_drone = (c2_d/c1_d).max(1.0 + (1.0 - prob_data.gamma) * (prob_data.d_drone_old - 1.0));	
-        prob_data.d_drone_old = prob_data.d_drone;
+        polarEllipsoid(prob_data, prob_data.x_drone, prob_data.y_drone, prob_data.z_drone, prob_data.a_drone, prob_data.b_drone, prob_data.c_drone,
+                    prob_data.alpha_drone, prob_data.beta_drone, prob_data.dir_x_drone, prob_data.dir_y_drone, prob_data.dir_z_drone, prob_data.d_drone, prob_data.d_drone_old);
     }
-    
+
     if(!prob_data.axis_wise){
         // @ Velocity Constraints
-        wc_alpha_vel = prob_data.xdot;				
-        ws_alpha_vel = prob_data.ydot;
-        prob_data.alpha_vel = arctan2(ws_alpha_vel, wc_alpha_vel);
-
-        wc_beta_vel = prob_data.zdot;
-        for(int i = 0; i < prob_data.beta_vel.rows(); i++){
-            prob_data.beta_vel(i) = atan2(wc_alpha_vel(i)/cos(prob_data.alpha_vel(i)), wc_beta_vel(i));
-        }
-        c1_d = pow(sin(prob_data.beta_vel), 2) * pow(cos(prob_data.alpha_vel), 2) + pow(sin(prob_data.beta_vel), 2) * pow(sin(prob_data.alpha_vel), 2) + pow(cos(prob_data.beta_vel), 2);
-        c2_d = wc_alpha_vel * sin(prob_data.beta_vel) * cos(prob_data.alpha_vel) + ws_alpha_vel * sin(prob_data.beta_vel) * sin(prob_data.alpha_vel) + wc_beta_vel * cos(prob_data.beta_vel);
-
-        prob_data.d_vel =(c2_d/c1_d).min(prob_data.vel_max);
-        
+        polarBound(prob_data, prob_data.xdot, prob_data.ydot, prob_data.zdot, 0.0,
+                    prob_data.alpha_vel, prob_data.beta_vel, prob_data.dir_x_vel, prob_data.dir_y_vel, prob_data.dir_z_vel, prob_data.d_vel, -FLT_MAX, prob_data.vel_max);
 
         // @ Acceleration Constraints
         if(!prob_data.use_thrust_values){
-            wc_alpha_acc = prob_data.xddot;				
-            ws_alpha_acc = prob_data.yddot;
-            prob_data.alpha_acc = arctan2(ws_alpha_acc, wc_alpha_acc);
-
-            wc_beta_acc = prob_data.zddot;
-            for(int i = 0; i < prob_data.beta_acc.rows(); i++){
-                prob_data.beta_acc(i) = atan2(wc_alpha_acc(i)/cos(prob_data.alpha_acc(i)), wc_beta_acc(i));
-            }
-            c1_d = pow(sin(prob_data.beta_acc), 2) * pow(cos(prob_data.alpha_acc), 2) + pow(sin(prob_data.beta_acc), 2) * pow(sin(prob_data.alpha_acc), 2) + pow(cos(prob_data.beta_acc), 2);
-            c2_d = wc_alpha_acc * sin(prob_data.beta_acc) * cos(prob_data.alpha_acc) + ws_alpha_acc * sin(prob_data.beta_acc) * sin(prob_data.alpha_acc) + wc_beta_acc * cos(prob_data.beta_acc);
-
-            prob_data.d_acc =(c2_d/c1_d).min(prob_data.acc_max);
+            polarBound(prob_data, prob_data.xddot, prob_data.yddot, prob_data.zddot, 0.0,
+                    prob_data.alpha_acc, prob_data.beta_acc, prob_data.dir_x_acc, prob_data.dir_y_acc, prob_data.dir_z_acc, prob_data.d_acc, -FLT_MAX, prob_data.acc_max);
         }
         else{
-            wc_alpha_acc = prob_data.xddot;				
-            ws_alpha_acc = prob_data.yddot;
-            prob_data.alpha_acc = arctan2(ws_alpha_acc, wc_alpha_acc);
-
-            wc_beta_acc = prob_data.zddot + prob_data.gravity;
-            for(int i = 0; i < prob_data.beta_acc.rows(); i++){
-                prob_data.beta_acc(i) = atan2(wc_alpha_acc(i)/cos(prob_data.alpha_acc(i)), wc_beta_acc(i));
-            }
-            c1_d = pow(sin(prob_data.beta_acc), 2) * pow(cos(prob_data.alpha_acc), 2) + pow(sin(prob_data.beta_acc), 2) * pow(sin(prob_data.alpha_acc), 2) + pow(cos(prob_data.beta_acc), 2);
-            c2_d = wc_alpha_acc * sin(prob_data.beta_acc) * cos(prob_data.alpha_acc) + ws_alpha_acc * sin(prob_data.beta_acc) * sin(prob_data.alpha_acc) + wc_beta_acc * cos(prob_data.beta_acc);
-
-            prob_data.d_acc = ((c2_d/c1_d).min(prob_data.f_max)).max(prob_data.f_min);
+            polarBound(prob_data, prob_data.xddot, prob_data.yddot, prob_data.zddot, prob_data.gravity,
+                    prob_data.alpha_acc, prob_data.beta_acc, prob_data.dir_x_acc, prob_data.dir_y_acc, prob_data.dir_z_acc, prob_data.d_acc, prob_data.f_min, prob_data.f_max);
         }
 
         if(prob_data.jerk_snap_constraints){
             // @ Jerk Constraints
-            wc_alpha_jerk = prob_data.xdddot;				
-            ws_alpha_jerk = prob_data.ydddot;
-            prob_data.alpha_jerk = arctan2(ws_alpha_jerk, wc_alpha_jerk);
-
-            wc_beta_jerk = prob_data.zdddot;
-            for(int i = 0; i < prob_data.beta_jerk.rows(); i++){
-                prob_data.beta_jerk(i) = atan2(wc_alpha_jerk(i)/cos(prob_data.alpha_jerk(i)), wc_beta_jerk(i));
-            }
-            c1_d = pow(sin(prob_data.beta_jerk), 2) * pow(cos(prob_data.alpha_jerk), 2) + pow(sin(prob_data.beta_jerk), 2) * pow(sin(prob_data.alpha_jerk), 2) + pow(cos(prob_data.beta_jerk), 2);
-            c2_d = wc_alpha_jerk * sin(prob_data.beta_jerk) * cos(prob_data.alpha_jerk) + ws_alpha_jerk * sin(prob_data.beta_jerk) * sin(prob_data.alpha_jerk) + wc_beta_jerk * cos(prob_data.beta_jerk);
-
-            prob_data.d_jerk =(c2_d/c1_d).min(prob_data.jerk_max);
-
+            polarBound(prob_data, prob_data.xdddot, prob_data.ydddot, prob_data.zdddot, 0.0,
+                    prob_data.alpha_jerk, prob_data.beta_jerk, prob_data.dir_x_jerk, prob_data.dir_y_jerk, prob_data.dir_z_jerk, prob_data.d_jerk, -FLT_MAX, prob_data.jerk_max);
 
             // @ Snap Constraints
-            wc_alpha_snap = prob_data.xddddot;				
-            ws_alpha_snap = prob_data.yddddot;
-            prob_data.alpha_snap = arctan2(ws_alpha_snap, wc_alpha_snap);
-
-            wc_beta_snap = prob_data.zddddot;
-            for(int i = 0; i < prob_data.beta_snap.rows(); i++){
-                prob_data.beta_snap(i) = atan2(wc_alpha_snap(i)/cos(prob_data.alpha_snap(i)), wc_beta_snap(i));
-            }
-            c1_d = pow(sin(prob_data.beta_snap), 2) * pow(cos(prob_data.alpha_snap), 2) + pow(sin(prob_data.beta_snap), 2) * pow(sin(prob_data.alpha_snap), 2) + pow(cos(prob_data.beta_snap), 2);
-            c2_d = wc_alpha_snap * sin(prob_data.beta_snap) * cos(prob_data.alpha_snap) + ws_alpha_snap * sin(prob_data.beta_snap) * sin(prob_data.alpha_snap) + wc_beta_snap * cos(prob_data.beta_snap);
-
-            prob_data.d_snap = (c2_d/c1_d).min(prob_data.snap_max);  
+            polarBound(prob_data, prob_data.xddddot, prob_data.yddddot, prob_data.zddddot, 0.0,
+                    prob_data.alpha_snap, prob_data.beta_snap, prob_data.dir_x_snap, prob_data.dir_y_snap, prob_data.dir_z_snap, prob_data.d_snap, -FLT_MAX, prob_data.snap_max);
         }
     }
-    
+
 }
\ No newline at end of file
@@ -1,264 +1,427 @@
 #include "algorithm/amswarm/solve_position_var.hpp"
 #include "algorithm/amswarm/solve_polar_var.hpp"
+#include <algorithm>
 
-void computeXYAxis(probData &prob_data, int VERBOSE)
+Eigen :: Array<float, 9, 1> kktKey(probData &prob_data, bool static_obs)
+{
+    // Everything that scales a Gram matrix in the objective
+    Eigen :: Array<float, 9, 1> key;
+    key << prob_data.weight_goal, prob_data.weight_smoothness,
+            prob_data.rho_vel, prob_data.rho_acc, prob_data.rho_ineq,
+            prob_data.rho_jerk, prob_data.rho_snap, prob_data.rho_drone,
+            static_obs ? prob_data.rho_static_obs : 0.0f;
+    return key;
+}
+
+void solveKKT(kktCache &cache, const Eigen :: Array<float, 9, 1> &key, const Eigen :: Ref<const Eigen :: MatrixXf> &objective, const Eigen :: Ref<const Eigen :: MatrixXf> &A_eq, 
+                const Eigen :: Ref<const Eigen :: MatrixXf> &lincost, const Eigen :: Ref<const Eigen :: MatrixXf> &b_eq, Eigen :: Ref<Eigen :: MatrixXf> sol)
+{
+    // Q x + A^T nu = -q, A x = b is solved through the Schur complement of Q
+    //  nu = (A Q^-1 A^T)^-1 (A Q^-1 (-q) - b),  x = Q^-1 (-q) - Q^-1 A^T nu
+    // Each column of lincost/b_eq is an independent right hand side
+    if(objective.rows() == 11 && A_eq.rows() == 3 && lincost.cols() <= 3){
+        solveKKT11(cache, key, objective, A_eq, lincost, b_eq, sol);
+        return;
+    }
+
+    if(!cache.valid || (cache.key != key).any()){
+        cache.cost_fact.compute(objective);
+        cache.cost_inv_eq = cache.cost_fact.solve(A_eq.transpose());
+        cache.schur_fact.compute(A_eq * cache.cost_inv_eq);
+        cache.key = key;
+        cache.valid = true;
+    }
+    
+    sol = cache.cost_fact.solve(-lincost);
+    Eigen :: MatrixXf nu = cache.schur_fact.solve(A_eq * sol - b_eq);
+    sol.noalias() -= cache.cost_inv_eq * nu;
+}
+
+void solveKKT11(kktCache &cache, const Eigen :: Array<float, 9, 1> &key, const Eigen :: Ref<const Eigen :: MatrixXf> &objective, const Eigen :: Ref<const Eigen :: MatrixXf> &A_eq, 
+                const Eigen :: Ref<const Eigen :: MatrixXf> &lincost, const Eigen :: Ref<const Eigen :: MatrixXf> &b_eq, Eigen :: Ref<Eigen :: MatrixXf> sol)
 {
-                            
-    Eigen :: ArrayXXf cost_xy, cost_xy_inv;
-    Eigen :: ArrayXXf objective_xy, lincost_x, lincost_y;
-    Eigen :: ArrayXXf cost_drone, cost_static_obs;
-    Eigen :: ArrayXXf temp_x_static_obs, temp_y_static_obs;
-    Eigen :: ArrayXXf temp_x_drone, temp_y_drone;
-    Eigen :: ArrayXXf sol_x, sol_y, primal_sol_x, primal_sol_y;
-    Eigen :: ArrayXXf res_x_static_obs, res_y_static_obs,
-                        res_x_drone, res_y_drone,
-                        res_vx_ineq, res_vy_ineq,
-                        res_ax_ineq, res_ay_ineq,
-                        res_jx_ineq, res_jy_ineq,
-                        res_sx_ineq, res_sy_ineq,
-                        res_x_ineq, res_y_ineq;
+    // solveKKT with fixed size operands, the 11x11 algebra is unrolled and stays off the heap
+    Eigen :: Matrix<float, 3, 11> A = A_eq;
     
+    if(!cache.valid || (cache.key != key).any()){
+        cache.cost_fact_11.compute(Matrix11f(objective));
+        cache.cost_inv_eq_11 = cache.cost_fact_11.solve(A.transpose());
+        cache.schur_fact_11.compute(A * cache.cost_inv_eq_11);
+        cache.key = key;
+        cache.valid = true;
+    }
+
+    Matrix11Xf x = cache.cost_fact_11.solve(-Matrix11Xf(lincost));
+    Matrix3Xf nu = cache.schur_fact_11.solve(A * x - Matrix3Xf(b_eq));
+    x.noalias() -= cache.cost_inv_eq_11 * nu;
+    sol = x;
+}
+
+Eigen :: ArrayXXf solveKKT(kktCache &cache, const Eigen :: Array<float, 9, 1> &key, const Eigen :: ArrayXXf &objective, const Eigen :: ArrayXXf &A_eq, const Eigen :: ArrayXXf &lincost, const Eigen :: ArrayXXf &b_eq)
+{
+    Eigen :: MatrixXf sol(objective.rows(), lincost.cols());
+    solveKKT(cache, key, objective.matrix(), A_eq.matrix(), lincost.matrix(), b_eq.matrix(), sol);
+    return sol;
+}
+
+// @ Basis and trajectory arrays seen through sizes known at compile time. Num, Kappa and Nvar are
+// Eigen :: Dynamic on the generic path and the shipped horizon on the specialized one (see computeXYZ)
+template<int Rows, int Cols = 1>
+static Eigen :: Map<const Eigen :: Matrix<float, Rows, Cols>> sized(const Eigen :: ArrayXXf &a)
+{
+    return Eigen :: Map<const Eigen :: Matrix<float, Rows, Cols>>(a.data(), a.rows(), a.cols());
+}
+
+template<int Rows, int Cols = 1>
+static Eigen :: Map<Eigen :: Matrix<float, Rows, Cols>> sized(Eigen :: ArrayXXf &a)
+{
+    return Eigen :: Map<Eigen :: Matrix<float, Rows, Cols>>(a.data(), a.rows(), a.cols());
+}
+
+static constexpr int stacked(int rows)
+{
+    // Rows of [P; -P]
+    return rows == Eigen :: Dynamic ? Eigen :: Dynamic : 2*rows;
+}
+
+template<typename Lhs, typename Rhs>
+static auto times(const Lhs &lhs, const Rhs &rhs)
+{
+    // Coefficient-based product inlined at the call when the sizes are fixed, Eigen's blocked kernels otherwise
+    if constexpr(Lhs :: SizeAtCompileTime != Eigen :: Dynamic)
+        return lhs.lazyProduct(rhs);
+    else
+        return lhs * rhs;
+}
+
+static void beginWorkspace(probData &prob_data)
+{
+    // Sizes the workspace for this step's neighbours/obstacles, whose costs are P^T P repeated once per block
+    amWorkspace &ws = prob_data.ws;
+
+    ws.num_drone_rows = prob_data.num_drone!=0 ? prob_data.A_drone.num_blocks * prob_data.num : 0;
+    ws.num_static_obs_rows = prob_data.num_static_obs!=0 ? prob_data.A_static_obs.num_blocks * prob_data.num : 0;
+    reserveWorkspace(prob_data, std :: max(ws.num_drone_rows, ws.num_static_obs_rows)/prob_data.num);
+
+    if(prob_data.num_drone!=0) ws.cost_drone.matrix().noalias() = prob_data.A_drone.num_blocks * *prob_data.A_drone.gram;
+    if(prob_data.num_static_obs!=0) ws.cost_static_obs.matrix().noalias() = prob_data.A_static_obs.num_blocks * *prob_data.A_static_obs.gram;
+
+    // @ Neighbours and obstacles changed, cached factorizations are stale
+    prob_data.kkt_xy.valid = false;
+    prob_data.kkt_z.valid = false;
+}
+
+static void assembleCollision(probData &prob_data, int num_axes)
+{
+    // Obstacle and neighbour terms of objective/lincost, static obstacles only constrain xy
+    amWorkspace &ws = prob_data.ws;
+    Eigen :: Map<Eigen :: VectorXf> b_x_drone(ws.temp_x.data(), ws.num_drone_rows), b_y_drone(ws.temp_y.data(), ws.num_drone_rows), b_z_drone(ws.temp_z.data(), ws.num_drone_rows);
+    Eigen :: Map<Eigen :: VectorXf> b_x_static_obs(ws.temp_x.data(), ws.num_static_obs_rows), b_y_static_obs(ws.temp_y.data(), ws.num_static_obs_rows);
+
+    if(prob_data.num_static_obs!=0){
+        ws.temp_x.leftCols(prob_data.num_static_obs) = (prob_data.x_static_obs + prob_data.d_static_obs * prob_data.dir_x_static_obs * prob_data.a_static_obs).transpose();
+        ws.temp_y.leftCols(prob_data.num_static_obs) = (prob_data.y_static_obs + prob_data.d_static_obs * prob_data.dir_y_static_obs * prob_data.b_static_obs).transpose();
+
+        ws.objective_xy += prob_data.rho_static_obs * ws.cost_static_obs;
+        subRepeatedTransposeTimes(prob_data.A_static_obs, prob_data.rho_static_obs, b_x_static_obs, ws.lincost.col(0).matrix());
+        subRepeatedTransposeTimes(prob_data.A_static_obs, prob_data.rho_static_obs, b_y_static_obs, ws.lincost.col(1).matrix());
+
+    }
+
+    if(prob_data.num_drone!=0){
+
+        ws.temp_x.leftCols(prob_data.num_drone) = (prob_data.x_drone + prob_data.d_drone * prob_data.dir_x_drone * prob_data.a_drone).transpose();
+        ws.temp_y.leftCols(prob_data.num_drone) = (prob_data.y_drone + prob_data.d_drone * prob_data.dir_y_drone * prob_data.b_drone).transpose();
+
+        ws.objective_xy += prob_data.rho_drone * ws.cost_drone;
+
+        subRepeatedTransposeTimes(prob_data.A_drone, prob_data.rho_drone, b_x_drone, ws.lincost.col(0).matrix());
+        subRepeatedTransposeTimes(prob_data.A_drone, prob_data.rho_drone, b_y_drone, ws.lincost.col(1).matrix());
+
+        if(num_axes == 3){
+            ws.temp_z.leftCols(prob_data.num_drone) = (prob_data.z_drone + prob_data.d_drone * prob_data.dir_z_drone * prob_data.c_drone).transpose();
+            ws.objective_z += prob_data.rho_drone * ws.cost_drone;
+            subRepeatedTransposeTimes(prob_data.A_drone, prob_data.rho_drone, b_z_drone, ws.lincost.col(2).matrix());
+        }
+    }
+}
+
+static int updateCollision(probData &prob_data, int num_axes)
+{
+    // Obstacle and neighbour residuals, multipliers and penalties. Returns the number of converged families
+    amWorkspace &ws = prob_data.ws;
+    float thresold = prob_data.thresold;
+    int break_flag = 0;
+    Eigen :: Map<Eigen :: VectorXf> b_x_drone(ws.temp_x.data(), ws.num_drone_rows), b_y_drone(ws.temp_y.data(), ws.num_drone_rows), b_z_drone(ws.temp_z.data(), ws.num_drone_rows);
+    Eigen :: Map<Eigen :: VectorXf> b_x_static_obs(ws.temp_x.data(), ws.num_static_obs_rows), b_y_static_obs(ws.temp_y.data(), ws.num_static_obs_rows);
+
+    if(prob_data.num_static_obs!=0){
+
+        ws.temp_x.leftCols(prob_data.num_static_obs) = ((-prob_data.x_static_obs).rowwise() + prob_data.x.transpose().row(0) - prob_data.a_static_obs * prob_data.d_static_obs * prob_data.dir_x_static_obs).transpose();
+        ws.temp_y.leftCols(prob_data.num_static_obs) = ((-prob_data.y_static_obs).rowwise() + prob_data.y.transpose().row(0) - prob_data.b_static_obs * prob_data.d_static_obs * prob_data.dir_y_static_obs).transpose();
+
+        subRepeatedTransposeTimes(prob_data.A_static_obs, prob_data.rho_static_obs, b_x_static_obs, prob_data.lamda_x.matrix());
+        subRepeatedTransposeTimes(prob_data.A_static_obs, prob_data.rho_static_obs, b_y_static_obs, prob_data.lamda_y.matrix());
+
+        prob_data.res_x_static_obs_norm = b_x_static_obs.norm();
+        prob_data.res_y_static_obs_norm = b_y_static_obs.norm();
+
+        if(prob_data.res_x_static_obs_norm > thresold || prob_data.res_y_static_obs_norm > thresold){
+            prob_data.rho_static_obs *= prob_data.delta_static_obs;
+            if(prob_data.rho_static_obs > prob_data.rho_static_obs_max) prob_data.rho_static_obs = prob_data.rho_static_obs_max;
+        }
+        else break_flag++;
+    }
+    else{
+        prob_data.res_x_static_obs_norm = 0;
+        prob_data.res_y_static_obs_norm = 0;
+        break_flag++;
+    }
+
+    if(prob_data.num_drone!=0){
+
+        ws.temp_x.leftCols(prob_data.num_drone) = ((-prob_data.x_drone).rowwise() + prob_data.x.transpose().row(0) - prob_data.a_drone * prob_data.d_drone * prob_data.dir_x_drone).transpose();
+        ws.temp_y.leftCols(prob_data.num_drone) = ((-prob_data.y_drone).rowwise() + prob_data.y.transpose().row(0) - prob_data.b_drone * prob_data.d_drone * prob_data.dir_y_drone).transpose();
+
+        if(num_axes == 3){
+            ws.temp_z.leftCols(prob_data.num_drone) = ((-prob_data.z_drone).rowwise() + prob_data.z.transpose().row(0) - prob_data.c_drone * prob_data.d_drone * prob_data.dir_z_drone).transpose();
+            subRepeatedTransposeTimes(prob_data.A_drone, prob_data.rho_drone, b_z_drone, prob_data.lamda_z.matrix());
+            prob_data.res_z_drone_norm = b_z_drone.norm();
+        }
+        else
+            prob_data.res_z_drone_norm = 0;
+
+        subRepeatedTransposeTimes(prob_data.A_drone, prob_data.rho_drone, b_x_drone, prob_data.lamda_x.matrix());
+        subRepeatedTransposeTimes(prob_data.A_drone, prob_data.rho_drone, b_y_drone, prob_data.lamda_y.matrix());
+
+        prob_data.res_x_drone_norm = b_x_drone.norm();
+        prob_data.res_y_drone_norm = b_y_drone.norm();
+
+        if(prob_data.res_x_drone_norm > thresold || prob_data.res_y_drone_norm > thresold || prob_data.res_z_drone_norm > thresold){
+            prob_data.rho_drone *= prob_data.delta_drone;
+            if(prob_data.rho_drone > prob_data.rho_drone_max) prob_data.rho_drone = prob_data.rho_drone_max;
+        }
+        else break_flag++;
+    }
+    else{
+        prob_data.res_x_drone_norm = 0;
+        prob_data.res_y_drone_norm = 0;
+        prob_data.res_z_drone_norm = 0;
+        break_flag++;
+    }
+    return break_flag;
+}
+
+static void solveKKTAxes(probData &prob_data, int num_axes)
+{
+    amWorkspace &ws = prob_data.ws;
+    const basisCache &basis = *prob_data.basis;
+    if(num_axes == 2){
+        solveKKT(prob_data.kkt_xy, kktKey(prob_data, true), ws.objective_xy.matrix(), basis.A_eq.matrix(),
+                    ws.lincost.leftCols(2).matrix(), ws.b_eq.leftCols(2).matrix(), ws.sol.leftCols(2).matrix());
+    }
+    else if(prob_data.num_static_obs!=0){
+        solveKKT(prob_data.kkt_xy, kktKey(prob_data, true), ws.objective_xy.matrix(), basis.A_eq.matrix(),
+                    ws.lincost.leftCols(2).matrix(), ws.b_eq.leftCols(2).matrix(), ws.sol.leftCols(2).matrix());
+        solveKKT(prob_data.kkt_z, kktKey(prob_data, false), ws.objective_z.matrix(), basis.A_eq.matrix(),
+                    ws.lincost.col(2).matrix(), ws.b_eq.col(2).matrix(), ws.sol.col(2).matrix());
+    }
+    else{
+        // objective_xy and objective_z coincide, one factorization serves all three axes
+        solveKKT(prob_data.kkt_xy, kktKey(prob_data, false), ws.objective_xy.matrix(), basis.A_eq.matrix(),
+                    ws.lincost.matrix(), ws.b_eq.matrix(), ws.sol.matrix());
+    }
+}
+
+template<int Num = Eigen :: Dynamic, int Nvar = Eigen :: Dynamic>
+static void evalAxis(probData &prob_data, int axis, Eigen :: ArrayXXf &p, Eigen :: ArrayXXf &pdot, Eigen :: ArrayXXf &pddot, Eigen :: ArrayXXf &pdddot,
+                        Eigen :: ArrayXXf &pddddot, Eigen :: ArrayXXf &p_up, Eigen :: ArrayXXf &pdot_up, Eigen :: ArrayXXf &pddot_up)
+{
+    // Samples of one axis of the trajectory from its column of ws.sol
+    const basisCache &basis = *prob_data.basis;
+    auto primal_sol = sized<Nvar, Eigen :: Dynamic>(prob_data.ws.sol).col(axis);
+
+    p.matrix().noalias() = times(sized<Num, Nvar>(basis.P), primal_sol);
+    pdot.matrix().noalias() = times(sized<Num, Nvar>(basis.Pdot), primal_sol);
+    pddot.matrix().noalias() = times(sized<Num, Nvar>(basis.Pddot), primal_sol);
+    pdddot.matrix().noalias() = times(sized<Num, Nvar>(basis.Pdddot), primal_sol);
+    pddddot.matrix().noalias() = times(sized<Num, Nvar>(basis.Pddddot), primal_sol);
+
+    p_up.matrix().noalias() = times(sized<Eigen :: Dynamic, Nvar>(basis.P_up), primal_sol);
+    pdot_up.matrix().noalias() = times(sized<Eigen :: Dynamic, Nvar>(basis.Pdot_up), primal_sol);
+    pddot_up.matrix().noalias() = times(sized<Eigen :: Dynamic, Nvar>(basis.Pddot_up), primal_sol);
+}
+
+static void holdZ(probData &prob_data)
+{
+    // @ Planar worlds keep z at its initial value
+    prob_data.z.setConstant(prob_data.num, 1, prob_data.z_init);
+    prob_data.zdot.setZero(prob_data.num, 1);
+    prob_data.zddot.setZero(prob_data.num, 1);
+    prob_data.zdddot.setZero(prob_data.num, 1);
+    prob_data.zddddot.setZero(prob_data.num, 1);
+
+    prob_data.z_up.setConstant(prob_data.num_up, 1, prob_data.z_init);
+    prob_data.zdot_up.setZero(prob_data.num_up, 1);
+    prob_data.zddot_up.setZero(prob_data.num_up, 1);
+}
+
+static void subBoxCost(amWorkspace &ws, int axis, float rho, const Eigen :: ArrayXXf &A, const Eigen :: ArrayXXf &b, const Eigen :: ArrayXXf &s)
+{
+    // lincost -= rho A^T (b - s)
+    ws.ineq_tmp = b - s;
+    ws.lincost.col(axis).matrix().noalias() -= rho * A.transpose().matrix() * ws.ineq_tmp.matrix();
+}
+
+static float updateBox(amWorkspace &ws, int axis, float rho, const Eigen :: ArrayXXf &A, const Eigen :: ArrayXXf &b,
+                        Eigen :: ArrayXXf &s, Eigen :: ArrayXXf &lamda)
+{
+    // s = max(0, b - A x), res = A x - b + s and lamda -= rho A^T res. Returns the norm of res
+    auto res = ws.res_box.col(axis);
+
+    res.matrix().noalias() = A.matrix() * ws.sol.col(axis).matrix();
+    s = (b - res).max(0.0);
+    res += s - b;
+    lamda.matrix().noalias() -= rho * A.transpose().matrix() * res.matrix();
+
+    return res.matrix().norm();
+}
+
+void computeXYAxis(probData &prob_data, int VERBOSE)
+{
+    amWorkspace &ws = prob_data.ws;
+    const basisCache &basis = *prob_data.basis;
+    stepTelemetry &tel = prob_data.step_telemetry;
+
     // @ Set Initial Conidtions for next MPC step
     prob_data.b_x_eq << prob_data.x_init, prob_data.vx_init, prob_data.ax_init;
     prob_data.b_y_eq << prob_data.y_init, prob_data.vy_init, prob_data.ay_init;
 
     float thresold = prob_data.thresold;
 
-    prob_data.rho_static_obs = 1.0;
-    prob_data.rho_drone = 1.0;
-    prob_data.rho_vel = 1.0;
-    prob_data.rho_acc = 1.0;
-    prob_data.rho_jerk = 1.0;
-    prob_data.rho_snap = 1.0;
-    prob_data.rho_ineq = 1.0;
-    
-    
+    bool warm_start = prob_data.warm_start && prob_data.mpc_step > 0;
+
+    if(!warm_start){
+        prob_data.rho_static_obs = 1.0;
+        prob_data.rho_drone = 1.0;
+        prob_data.rho_vel = 1.0;
+        prob_data.rho_acc = 1.0;
+        prob_data.rho_jerk = 1.0;
+        prob_data.rho_snap = 1.0;
+        prob_data.rho_ineq = 1.0;
+
+
         // @ Lagrange Multiplier
-    prob_data.lamda_x = Eigen :: ArrayXXf :: Ones(prob_data.nvar, 1) *0;
-    prob_data.lamda_y = Eigen :: ArrayXXf :: Ones(prob_data.nvar, 1) *0;
-    
-    // @ Position Constraints
-    prob_data.s_x_ineq = Eigen :: ArrayXXf :: Ones(2*prob_data.num, 1) *0;
-    prob_data.s_y_ineq = Eigen :: ArrayXXf :: Ones(2*prob_data.num, 1) *0;
+        prob_data.lamda_x.setZero(prob_data.nvar, 1);
+        prob_data.lamda_y.setZero(prob_data.nvar, 1);
 
-    // @ Velocity Constraints
-    prob_data.s_vx_ineq = Eigen :: ArrayXXf :: Ones(2*prob_data.num, 1) *0;
-    prob_data.s_vy_ineq = Eigen :: ArrayXXf :: Ones(2*prob_data.num, 1) *0;
-    
-    // @ Acceleration Constraints
-    prob_data.s_ax_ineq = Eigen :: ArrayXXf :: Ones(2*prob_data.num, 1) *0;
-    prob_data.s_ay_ineq = Eigen :: ArrayXXf :: Ones(2*prob_data.num, 1) *0;
+        // @ Position Constraints
+        prob_data.s_x_ineq.setZero(2*prob_data.num, 1);
+        prob_data.s_y_ineq.setZero(2*prob_data.num, 1);
 
-    // @ Jerk Constraints
-    prob_data.s_jx_ineq = Eigen :: ArrayXXf :: Ones(2*prob_data.num, 1) *0;
-    prob_data.s_jy_ineq = Eigen :: ArrayXXf :: Ones(2*prob_data.num, 1) *0;
-    
-    // @ Snap Constraints
-    prob_data.s_sx_ineq = Eigen :: ArrayXXf :: Ones(2*prob_data.num, 1) *0;
-    prob_data.s_sy_ineq = Eigen :: ArrayXXf :: Ones(2*prob_data.num, 1) *0;
-    
+        // @ Velocity Constraints
+        prob_data.s_vx_ineq.setZero(2*prob_data.num, 1);
+        prob_data.s_vy_ineq.setZero(2*prob_data.num, 1);
+
+        // @ Acceleration Constraints
+        prob_data.s_ax_ineq.setZero(2*prob_data.num, 1);
+        prob_data.s_ay_ineq.setZero(2*prob_data.num, 1);
+
+        // @ Jerk Constraints
+        prob_data.s_jx_ineq.setZero(2*prob_data.num, 1);
+        prob_data.s_jy_ineq.setZero(2*prob_data.num, 1);
+
+        // @ Snap Constraints
+        prob_data.s_sx_ineq.setZero(2*prob_data.num, 1);
+        prob_data.s_sy_ineq.setZero(2*prob_data.num, 1);
+    }
+
+    beginWorkspace(prob_data);
+
+    if(warm_start)
+        warmStartADMM(prob_data);
+
+    ws.b_eq.col(0) = prob_data.b_x_eq;
+    ws.b_eq.col(1) = prob_data.b_y_eq;
+    holdZ(prob_data);
 
-    if(prob_data.num_drone!=0)cost_drone = prob_data.A_drone.transpose().matrix() * prob_data.A_drone.matrix();
-    if(prob_data.num_static_obs!=0)cost_static_obs = prob_data.A_static_obs.transpose().matrix() * prob_data.A_static_obs.matrix();
-    
     int break_flag;
     for(int i = 0; i < prob_data.max_iter; i++){
 
         break_flag = 0;
-        
-        prob_data.B_x_ineq = prob_data.A_ineq.transpose().matrix() * (prob_data.b_x_ineq - prob_data.s_x_ineq).matrix();
-        prob_data.B_y_ineq = prob_data.A_ineq.transpose().matrix() * (prob_data.b_y_ineq - prob_data.s_y_ineq).matrix();
+        prob_data.num_iters = i + 1;
 
-        prob_data.B_vx_ineq = prob_data.A_v_ineq.transpose().matrix() * (prob_data.b_vx_ineq - prob_data.s_vx_ineq).matrix();
-        prob_data.B_vy_ineq = prob_data.A_v_ineq.transpose().matrix() * (prob_data.b_vy_ineq - prob_data.s_vy_ineq).matrix();
-    
-        prob_data.B_ax_ineq = prob_data.A_a_ineq.transpose().matrix() * (prob_data.b_ax_ineq - prob_data.s_ax_ineq).matrix();
-        prob_data.B_ay_ineq = prob_data.A_a_ineq.transpose().matrix() * (prob_data.b_ay_ineq - prob_data.s_ay_ineq).matrix();
-        
-        objective_xy = prob_data.weight_goal * prob_data.cost_goal 
-                + prob_data.weight_smoothness * prob_data.cost_smoothness 
-                + prob_data.rho_vel * prob_data.cost_vel 
-                + prob_data.rho_acc * prob_data.cost_acc 
-                + prob_data.rho_ineq * prob_data.cost_ineq;
-
-
-        lincost_x = -prob_data.lamda_x
-                    -prob_data.weight_goal * (prob_data.P.bottomRows(prob_data.kappa).transpose().matrix() * prob_data.x_ref.matrix()).array()
-                    -prob_data.rho_vel * prob_data.B_vx_ineq
-                    -prob_data.rho_acc * prob_data.B_ax_ineq
-                    -prob_data.rho_ineq * prob_data.B_x_ineq;
-
-        lincost_y = -prob_data.lamda_y
-                    -prob_data.weight_goal * (prob_data.P.bottomRows(prob_data.kappa).transpose().matrix() * prob_data.y_ref.matrix()).array()
-                    -prob_data.rho_vel * prob_data.B_vy_ineq
-                    -prob_data.rho_acc * prob_data.B_ay_ineq
-                    -prob_data.rho_ineq * prob_data.B_y_ineq;
-        
-    
-        if(prob_data.jerk_snap_constraints){
-            prob_data.B_jx_ineq = prob_data.A_j_ineq.transpose().matrix() * (prob_data.b_jx_ineq - prob_data.s_jx_ineq).matrix();
-            prob_data.B_jy_ineq = prob_data.A_j_ineq.transpose().matrix() * (prob_data.b_jy_ineq - prob_data.s_jy_ineq).matrix();
+        ws.objective_xy = prob_data.weight_goal * basis.cost_goal
+                + prob_data.weight_smoothness * basis.cost_smoothness
+                + prob_data.rho_vel * basis.cost_vel
+                + prob_data.rho_acc * basis.cost_acc
+                + prob_data.rho_ineq * basis.cost_ineq;
 
-            prob_data.B_sx_ineq = prob_data.A_s_ineq.transpose().matrix() * (prob_data.b_sx_ineq - prob_data.s_sx_ineq).matrix();
-            prob_data.B_sy_ineq = prob_data.A_s_ineq.transpose().matrix() * (prob_data.b_sy_ineq - prob_data.s_sy_ineq).matrix();
-        
-            objective_xy += prob_data.rho_jerk * prob_data.cost_jerk
-                + prob_data.rho_snap * prob_data.cost_snap;
-            
-
-            lincost_x += -prob_data.rho_jerk * prob_data.B_jx_ineq 
-                    -prob_data.rho_snap * prob_data.B_sx_ineq;
-            lincost_y += -prob_data.rho_jerk * prob_data.B_jy_ineq
-                    -prob_data.rho_snap * prob_data.B_sy_ineq;
-        }
-        
-        // @ Check for obstacles
-        if(prob_data.num_static_obs!=0){
-            temp_x_static_obs =  prob_data.x_static_obs + prob_data.d_static_obs * cos(prob_data.alpha_static_obs) * prob_data.a_static_obs;
-            temp_y_static_obs =  prob_data.y_static_obs + prob_data.d_static_obs * sin(prob_data.alpha_static_obs) * prob_data.b_static_obs;
+        ws.lincost.col(0) = -prob_data.lamda_x;
+        ws.lincost.col(1) = -prob_data.lamda_y;
 
-            prob_data.b_x_static_obs = reshape(temp_x_static_obs.transpose(), prob_data.num*prob_data.num_static_obs, 1);
-            prob_data.b_y_static_obs = reshape(temp_y_static_obs.transpose(), prob_data.num*prob_data.num_static_obs, 1);
-        
-            objective_xy += prob_data.rho_static_obs * cost_static_obs;
-            lincost_x += -prob_data.rho_static_obs * (prob_data.A_static_obs.transpose().matrix() * prob_data.b_x_static_obs.matrix()).array();
-            lincost_y += -prob_data.rho_static_obs * (prob_data.A_static_obs.transpose().matrix() * prob_data.b_y_static_obs.matrix()).array();
+        ws.lincost.col(0).matrix().noalias() -= prob_data.weight_goal * basis.P.bottomRows(prob_data.kappa).transpose().matrix() * prob_data.x_ref.matrix();
+        ws.lincost.col(1).matrix().noalias() -= prob_data.weight_goal * basis.P.bottomRows(prob_data.kappa).transpose().matrix() * prob_data.y_ref.matrix();
 
-        }
-        
-        if(prob_data.num_drone!=0){
-            
-            temp_x_drone =  prob_data.x_drone + prob_data.d_drone * cos(prob_data.alpha_drone) * prob_data.a_drone;
-            temp_y_drone =  prob_data.y_drone + prob_data.d_drone * sin(prob_data.alpha_drone) * prob_data.b_drone;
+        subBoxCost(ws, 0, prob_data.rho_vel, basis.A_v_ineq, prob_data.b_vx_ineq, prob_data.s_vx_ineq);
+        subBoxCost(ws, 0, prob_data.rho_acc, basis.A_a_ineq, prob_data.b_ax_ineq, prob_data.s_ax_ineq);
+        subBoxCost(ws, 0, prob_data.rho_ineq, basis.A_ineq, prob_data.b_x_ineq, prob_data.s_x_ineq);
 
-            prob_data.b_x_drone = reshape(temp_x_drone.transpose(), prob_data.num*prob_data.num_drone, 1);
-            prob_data.b_y_drone = reshape(temp_y_drone.transpose(), prob_data.num*prob_data.num_drone, 1);
-        
-            objective_xy += prob_data.rho_drone * cost_drone;
-            
-            lincost_x += -prob_data.rho_drone * (prob_data.A_drone.transpose().matrix() * prob_data.b_x_drone.matrix()).array();
-            lincost_y += -prob_data.rho_drone * (prob_data.A_drone.transpose().matrix() * prob_data.b_y_drone.matrix()).array();			
-        }
+        subBoxCost(ws, 1, prob_data.rho_vel, basis.A_v_ineq, prob_data.b_vy_ineq, prob_data.s_vy_ineq);
+        subBoxCost(ws, 1, prob_data.rho_acc, basis.A_a_ineq, prob_data.b_ay_ineq, prob_data.s_ay_ineq);
+        subBoxCost(ws, 1, prob_data.rho_ineq, basis.A_ineq, prob_data.b_y_ineq, prob_data.s_y_ineq);
 
-        // @ Solve set of linear equations
-        cost_xy = stack(stack(objective_xy, prob_data.A_eq.transpose(), 'h'), 
-                            stack(prob_data.A_eq, Eigen::ArrayXXf::Zero(prob_data.A_eq.rows(), prob_data.A_eq.rows()), 'h'), 'v');
-        cost_xy_inv = (cost_xy.matrix()).householderQr().solve(prob_data.I.matrix());
-
-        
-        sol_x = cost_xy_inv.matrix() * stack(-lincost_x, prob_data.b_x_eq, 'v').matrix();
-        sol_y = cost_xy_inv.matrix() * stack(-lincost_y, prob_data.b_y_eq, 'v').matrix(); 
-
-        primal_sol_x = sol_x.topRows(prob_data.nvar);
-        primal_sol_y = sol_y.topRows(prob_data.nvar);
-
-        prob_data.x = prob_data.P.matrix() * primal_sol_x.matrix();
-        prob_data.xdot = prob_data.Pdot.matrix() * primal_sol_x.matrix();
-        prob_data.xddot = prob_data.Pddot.matrix() * primal_sol_x.matrix();
-        prob_data.xdddot = prob_data.Pdddot.matrix() * primal_sol_x.matrix();
-        prob_data.xddddot = prob_data.Pddddot.matrix() * primal_sol_x.matrix();
-
-        prob_data.y = prob_data.P.matrix() * primal_sol_y.matrix();
-        prob_data.ydot = prob_data.Pdot.matrix() * primal_sol_y.matrix();
-        prob_data.yddot = prob_data.Pddot.matrix() * primal_sol_y.matrix();
-        prob_data.ydddot = prob_data.Pdddot.matrix() * primal_sol_y.matrix();
-        prob_data.yddddot = prob_data.Pddddot.matrix() * primal_sol_y.matrix();	
-
-        prob_data.z = prob_data.z_init * Eigen :: ArrayXXf :: Ones(prob_data.num, 1);
-        prob_data.zdot = Eigen :: ArrayXXf :: Zero(prob_data.num, 1);
-        prob_data.zddot = Eigen :: ArrayXXf :: Zero(prob_data.num, 1);
-        prob_data.zdddot = Eigen :: ArrayXXf :: Zero(prob_data.num, 1);
-        prob_data.zddddot = Eigen :: ArrayXXf :: Zero(prob_data.num, 1);
-
-        //////
-        prob_data.x_up = prob_data.P_up.matrix() * primal_sol_x.matrix();
-        prob_data.y_up = prob_data.P_up.matrix() * primal_sol_y.matrix();
-        prob_data.z_up = prob_data.z_init * Eigen :: ArrayXXf :: Ones(prob_data.num, 1);
-
-        prob_data.xdot_up = prob_data.Pdot_up.matrix() * primal_sol_x.matrix();
-        prob_data.ydot_up = prob_data.Pdot_up.matrix() * primal_sol_y.matrix();
-        prob_data.zdot_up = Eigen :: ArrayXXf :: Zero(prob_data.num_up, 1);
-
-        prob_data.xddot_up = prob_data.Pddot_up.matrix() * primal_sol_x.matrix();
-        prob_data.yddot_up = prob_data.Pddot_up.matrix() * primal_sol_y.matrix();
-        prob_data.zddot_up = Eigen :: ArrayXXf :: Zero(prob_data.num_up, 1);
-        /////
-        
-        
-        // @ Residual and Lagrange Update
-        initAlpha(prob_data, VERBOSE);
+        if(prob_data.jerk_snap_constraints){
+            ws.objective_xy += prob_data.rho_jerk * basis.cost_jerk
+                + prob_data.rho_snap * basis.cost_snap;
 
-        // Position
-        prob_data.s_x_ineq = ((-prob_data.A_ineq.matrix() * primal_sol_x.matrix()).array() + prob_data.b_x_ineq).max(0.0);
-        prob_data.s_y_ineq = ((-prob_data.A_ineq.matrix() * primal_sol_y.matrix()).array() + prob_data.b_y_ineq).max(0.0);
+            subBoxCost(ws, 0, prob_data.rho_jerk, basis.A_j_ineq, prob_data.b_jx_ineq, prob_data.s_jx_ineq);
+            subBoxCost(ws, 0, prob_data.rho_snap, basis.A_s_ineq, prob_data.b_sx_ineq, prob_data.s_sx_ineq);
 
-        res_x_ineq = (prob_data.A_ineq.matrix() * primal_sol_x.matrix()).array() - prob_data.b_x_ineq + prob_data.s_x_ineq;
-        res_y_ineq = (prob_data.A_ineq.matrix() * primal_sol_y.matrix()).array() - prob_data.b_y_ineq + prob_data.s_y_ineq;
+            subBoxCost(ws, 1, prob_data.rho_jerk, basis.A_j_ineq, prob_data.b_jy_ineq, prob_data.s_jy_ineq);
+            subBoxCost(ws, 1, prob_data.rho_snap, basis.A_s_ineq, prob_data.b_sy_ineq, prob_data.s_sy_ineq);
+        }
 
+        // @ Check for obstacles
+        assembleCollision(prob_data, 2);
 
-        // Velocity
-        prob_data.s_vx_ineq = ((-prob_data.A_v_ineq.matrix() * primal_sol_x.matrix()).array() + prob_data.b_vx_ineq).max(0.0);
-        prob_data.s_vy_ineq = ((-prob_data.A_v_ineq.matrix() * primal_sol_y.matrix()).array() + prob_data.b_vy_ineq).max(0.0);
-        
-        res_vx_ineq = (prob_data.A_v_ineq.matrix() * primal_sol_x.matrix()).array() - prob_data.b_vx_ineq + prob_data.s_vx_ineq;
-        res_vy_ineq = (prob_data.A_v_ineq.matrix() * primal_sol_y.matrix()).array() - prob_data.b_vy_ineq + prob_data.s_vy_ineq;
-        
+        // @ Solve set of linear equations
+        auto tic = std :: chrono :: high_resolution_clock :: now();
+        solveKKTAxes(prob_data, 2);
+        auto toc = std :: chrono :: high_resolution_clock :: now();
+        tel.time_solve += std :: chrono :: duration<float>(toc - tic).count();
+
+        // Trajectories from the solve, counted with the residuals
+        tic = std :: chrono :: high_resolution_clock :: now();
+        evalAxis(prob_data, 0, prob_data.x, prob_data.xdot, prob_data.xddot, prob_data.xdddot, prob_data.xddddot, prob_data.x_up, prob_data.xdot_up, prob_data.xddot_up);
+        evalAxis(prob_data, 1, prob_data.y, prob_data.ydot, prob_data.yddot, prob_data.ydddot, prob_data.yddddot, prob_data.y_up, prob_data.ydot_up, prob_data.yddot_up);
+        toc = std :: chrono :: high_resolution_clock :: now();
+        tel.time_residual += std :: chrono :: duration<float>(toc - tic).count();
 
-        // Acceleration
-        prob_data.s_ax_ineq = ((-prob_data.A_a_ineq.matrix() * primal_sol_x.matrix()).array() + prob_data.b_ax_ineq).max(0.0);
-        prob_data.s_ay_ineq = ((-prob_data.A_a_ineq.matrix() * primal_sol_y.matrix()).array() + prob_data.b_ay_ineq).max(0.0);
-        
-        
-        res_ax_ineq = (prob_data.A_a_ineq.matrix() * primal_sol_x.matrix()).array() - prob_data.b_ax_ineq + prob_data.s_ax_ineq;
-        res_ay_ineq = (prob_data.A_a_ineq.matrix() * primal_sol_y.matrix()).array() - prob_data.b_ay_ineq + prob_data.s_ay_ineq;
-        
+        // @ Residual and Lagrange Update
+        initAlpha(prob_data, VERBOSE);
+        tic = std :: chrono :: high_resolution_clock :: now();
+        tel.time_polar += std :: chrono :: duration<float>(tic - toc).count();
 
-        prob_data.lamda_x = prob_data.lamda_x 
-                -prob_data.rho_vel * (prob_data.A_v_ineq.transpose().matrix() * res_vx_ineq.matrix()).array()
-                -prob_data.rho_acc * (prob_data.A_a_ineq.transpose().matrix() * res_ax_ineq.matrix()).array()
-                -prob_data.rho_ineq * (prob_data.A_ineq.transpose().matrix() * res_x_ineq.matrix()).array();
+        // Position, velocity and acceleration
+        prob_data.res_x_ineq_norm = updateBox(ws, 0, prob_data.rho_ineq, basis.A_ineq, prob_data.b_x_ineq, prob_data.s_x_ineq, prob_data.lamda_x);
+        prob_data.res_y_ineq_norm = updateBox(ws, 1, prob_data.rho_ineq, basis.A_ineq, prob_data.b_y_ineq, prob_data.s_y_ineq, prob_data.lamda_y);
 
+        prob_data.res_x_vel_norm = updateBox(ws, 0, prob_data.rho_vel, basis.A_v_ineq, prob_data.b_vx_ineq, prob_data.s_vx_ineq, prob_data.lamda_x);
+        prob_data.res_y_vel_norm = updateBox(ws, 1, prob_data.rho_vel, basis.A_v_ineq, prob_data.b_vy_ineq, prob_data.s_vy_ineq, prob_data.lamda_y);
 
-        prob_data.lamda_y = prob_data.lamda_y 
-                -prob_data.rho_vel * (prob_data.A_v_ineq.transpose().matrix() * res_vy_ineq.matrix()).array()
-                -prob_data.rho_acc * (prob_data.A_a_ineq.transpose().matrix() * res_ay_ineq.matrix()).array()
-                -prob_data.rho_ineq * (prob_data.A_ineq.transpose().matrix() * res_y_ineq.matrix()).array();
-        
-        
+        prob_data.res_x_acc_norm = updateBox(ws, 0, prob_data.rho_acc, basis.A_a_ineq, prob_data.b_ax_ineq, prob_data.s_ax_ineq, prob_data.lamda_x);
+        prob_data.res_y_acc_norm = updateBox(ws, 1, prob_data.rho_acc, basis.A_a_ineq, prob_data.b_ay_ineq, prob_data.s_ay_ineq, prob_data.lamda_y);
 
         if(prob_data.jerk_snap_constraints){
             // Jerk
-            prob_data.s_jx_ineq = ((-prob_data.A_j_ineq.matrix() * primal_sol_x.matrix()).array() + prob_data.b_jx_ineq).max(0.0);
-            prob_data.s_jy_ineq = ((-prob_data.A_j_ineq.matrix() * primal_sol_y.matrix()).array() + prob_data.b_jy_ineq).max(0.0);
-            
-            res_jx_ineq = (prob_data.A_j_ineq.matrix() * primal_sol_x.matrix()).array() - prob_data.b_jx_ineq + prob_data.s_jx_ineq;
-            res_jy_ineq = (prob_data.A_j_ineq.matrix() * primal_sol_y.matrix()).array() - prob_data.b_jy_ineq + prob_data.s_jy_ineq;
+            prob_data.res_x_jerk_norm = updateBox(ws, 0, prob_data.rho_jerk, basis.A_j_ineq, prob_data.b_jx_ineq, prob_data.s_jx_ineq, prob_data.lamda_x);
+            prob_data.res_y_jerk_norm = updateBox(ws, 1, prob_data.rho_jerk, basis.A_j_ineq, prob_data.b_jy_ineq, prob_data.s_jy_ineq, prob_data.lamda_y);
 
             // Snap
-            prob_data.s_sx_ineq = ((-prob_data.A_s_ineq.matrix() * primal_sol_x.matrix()).array() + prob_data.b_sx_ineq).max(0.0);
-            prob_data.s_sy_ineq = ((-prob_data.A_s_ineq.matrix() * primal_sol_y.matrix()).array() + prob_data.b_sy_ineq).max(0.0);
-            
-
-            res_sx_ineq = (prob_data.A_s_ineq.matrix() * primal_sol_x.matrix()).array() - prob_data.b_sx_ineq + prob_data.s_sx_ineq;
-            res_sy_ineq = (prob_data.A_s_ineq.matrix() * primal_sol_y.matrix()).array() - prob_data.b_sy_ineq + prob_data.s_sy_ineq;
-            
-
-            prob_data.lamda_x = prob_data.lamda_x 
-                            -prob_data.rho_jerk * (prob_data.A_j_ineq.transpose().matrix() * res_jx_ineq.matrix()).array()
-                            -prob_data.rho_snap * (prob_data.A_s_ineq.transpose().matrix() * res_sx_ineq.matrix()).array();
-            
-            prob_data.lamda_y = prob_data.lamda_y 
-                            -prob_data.rho_jerk * (prob_data.A_j_ineq.transpose().matrix() * res_jy_ineq.matrix()).array()
-                            -prob_data.rho_snap * (prob_data.A_s_ineq.transpose().matrix() * res_sy_ineq.matrix()).array();
-
-
-            prob_data.res_x_jerk_norm = res_jx_ineq.matrix().norm();
-            prob_data.res_y_jerk_norm = res_jy_ineq.matrix().norm();
-            
-
-            prob_data.res_x_snap_norm = res_sx_ineq.matrix().norm();
-            prob_data.res_y_snap_norm = res_sy_ineq.matrix().norm();
-            
+            prob_data.res_x_snap_norm = updateBox(ws, 0, prob_data.rho_snap, basis.A_s_ineq, prob_data.b_sx_ineq, prob_data.s_sx_ineq, prob_data.lamda_x);
+            prob_data.res_y_snap_norm = updateBox(ws, 1, prob_data.rho_snap, basis.A_s_ineq, prob_data.b_sy_ineq, prob_data.s_sy_ineq, prob_data.lamda_y);
+
             if(prob_data.res_x_jerk_norm > thresold || prob_data.res_y_jerk_norm > thresold){;
                 prob_data.rho_jerk *= prob_data.delta_jerk;
                 if(prob_data.rho_jerk > prob_data.rho_jerk_max) prob_data.rho_jerk = prob_data.rho_jerk_max;
@@ -282,66 +445,8 @@ void computeXYAxis(probData &prob_data, int VERBOSE)
             break_flag += 2;
         }
 
-        if(prob_data.num_static_obs!=0){
-            
-            res_x_static_obs = reshape(((-prob_data.x_static_obs).rowwise() + prob_data.x.transpose().row(0) - prob_data.a_static_obs * prob_data.d_static_obs * cos(prob_data.alpha_static_obs)).transpose(), prob_data.num_static_obs*prob_data.num, 1);
-            res_y_static_obs = reshape(((-prob_data.y_static_obs).rowwise() + prob_data.y.transpose().row(0) - prob_data.b_static_obs * prob_data.d_static_obs * sin(prob_data.alpha_static_obs)).transpose(), prob_data.num_static_obs*prob_data.num, 1);
-        
-            prob_data.lamda_x = prob_data.lamda_x -prob_data.rho_static_obs * (prob_data.A_static_obs.transpose().matrix() * res_x_static_obs.matrix()).array();
-            prob_data.lamda_y = prob_data.lamda_y -prob_data.rho_static_obs * (prob_data.A_static_obs.transpose().matrix() * res_y_static_obs.matrix()).array();
-        
-            prob_data.res_x_static_obs_norm = res_x_static_obs.matrix().norm();
-            prob_data.res_y_static_obs_norm = res_y_static_obs.matrix().norm();
-        
-            if(prob_data.res_x_static_obs_norm > thresold || prob_data.res_y_static_obs_norm > thresold){
-                prob_data.rho_static_obs *= prob_data.delta_static_obs;
-                if(prob_data.rho_static_obs > prob_data.rho_static_obs_max) prob_data.rho_static_obs = prob_data.rho_static_obs_max;
-            }
-            else break_flag++;
-        }
-        else{
-            prob_data.res_x_static_obs_norm = 0;
-            prob_data.res_y_static_obs_norm = 0;
-            break_flag++;
-        }
-
-        if(prob_data.num_drone!=0){
-            
-            res_x_drone = reshape(((-prob_data.x_drone).rowwise() + prob_data.x.transpose().row(0) - prob_data.a_drone * prob_data.d_drone * cos(prob_data.alpha_drone)).transpose(), prob_data.num_drone*prob_data.num, 1);
-            res_y_drone = reshape(((-prob_data.y_drone).rowwise() + prob_data.y.transpose().row(0) - prob_data.b_drone * prob_data.d_drone * sin(prob_data.alpha_drone)).transpose(), prob_data.num_drone*prob_data.num, 1);
-            
-        
-            prob_data.lamda_x = prob_data.lamda_x -prob_data.rho_drone * (prob_data.A_drone.transpose().matrix() * res_x_drone.matrix()).array();
-            prob_data.lamda_y = prob_data.lamda_y -prob_data.rho_drone * (prob_data.A_drone.transpose().matrix() * res_y_drone.matrix()).array();
-        
-            prob_data.res_x_drone_norm = res_x_drone.matrix().norm();
-            prob_data.res_y_drone_norm = res_y_drone.matrix().norm();
-
-            if(prob_data.res_x_drone_norm > thresold || prob_data.res_y_drone_norm > thresold){
-                prob_data.rho_drone *= prob_data.delta_drone;
-                if(prob_data.rho_drone > prob_data.rho_drone_max) prob_data.rho_drone = prob_data.rho_drone_max;
-            }
-            else break_flag++;
-        }
-        else{
-            prob_data.res_x_drone_norm = 0;
-            prob_data.res_y_drone_norm = 0;
-            prob_data.res_z_drone_norm = 0;
-            break_flag++;
-        }
-        
-        prob_data.res_x_ineq_norm = res_x_ineq.matrix().norm();
-        prob_data.res_y_ineq_norm = res_y_ineq.matrix().norm();
+        break_flag += updateCollision(prob_data, 2);
 
-        prob_data.res_x_vel_norm = res_vx_ineq.matrix().norm();
-        prob_data.res_y_vel_norm = res_vy_ineq.matrix().norm();
-        
-
-        prob_data.res_x_acc_norm = res_ax_ineq.matrix().norm();
-        prob_data.res_y_acc_norm = res_ay_ineq.matrix().norm();
-        
-        
-        
         if(prob_data.res_x_ineq_norm > thresold || prob_data.res_y_ineq_norm > thresold){;
                 prob_data.rho_ineq *= prob_data.delta_ineq;
                 if(prob_data.rho_ineq > prob_data.rho_ineq_max) prob_data.rho_ineq = prob_data.rho_ineq_max;
@@ -357,251 +462,166 @@ void computeXYAxis(probData &prob_data, int VERBOSE)
                 if(prob_data.rho_acc > prob_data.rho_acc_max) prob_data.rho_acc = prob_data.rho_acc_max;
         }
         else break_flag++;
-        
+
+        toc = std :: chrono :: high_resolution_clock :: now();
+        tel.time_residual += std :: chrono :: duration<float>(toc - tic).count();
 
         if(break_flag == 7)
-            break;	
+            break;
     }
-    
-    if(break_flag != 7){
-            prob_data.weight_goal *= prob_data.delta_aggressive;
-            prob_data.weight_smoothness *= prob_data.delta_aggressive;
-        }
-    else{
-        prob_data.weight_goal = prob_data.weight_goal_og;
-        prob_data.weight_smoothness = prob_data.weight_smoothness_og;
-
-        if(prob_data.weight_goal > prob_data.weight_goal_og)
-            prob_data.weight_goal = prob_data.weight_goal_og;
 
-        if(prob_data.weight_goal > prob_data.weight_smoothness_og)
-            prob_data.weight_smoothness = prob_data.weight_smoothness_og;
-    }
+    endXYZ(prob_data, break_flag);
 }
 
 void computeXY(probData &prob_data, int VERBOSE)
 {
-                            
-    Eigen :: ArrayXXf cost_xy, cost_xy_inv;
-    Eigen :: ArrayXXf objective_xy, lincost_x, lincost_y;
-    Eigen :: ArrayXXf cost_drone, cost_static_obs;
-    Eigen :: ArrayXXf temp_x_static_obs, temp_y_static_obs;
-    Eigen :: ArrayXXf temp_x_drone, temp_y_drone;
-    Eigen :: ArrayXXf sol_x, sol_y, primal_sol_x, primal_sol_y;
-    Eigen :: ArrayXXf res_x_static_obs, res_y_static_obs,
-                        res_x_drone, res_y_drone,
-                        res_x_vel, res_y_vel,
-                        res_x_acc, res_y_acc,
-                        res_x_jerk, res_y_jerk,
-                        res_x_snap, res_y_snap,
-                        res_x_ineq, res_y_ineq;
-    
+    amWorkspace &ws = prob_data.ws;
+    const basisCache &basis = *prob_data.basis;
+    stepTelemetry &tel = prob_data.step_telemetry;
+
     // @ Set Initial Conidtions for next MPC step
     prob_data.b_x_eq << prob_data.x_init, prob_data.vx_init, prob_data.ax_init;
     prob_data.b_y_eq << prob_data.y_init, prob_data.vy_init, prob_data.ay_init;
 
     float thresold = prob_data.thresold;
 
-    prob_data.rho_static_obs = 1.0;
-    prob_data.rho_drone = 1.0;
-    prob_data.rho_vel = 1.0;
-    prob_data.rho_acc = 1.0;
-    prob_data.rho_jerk = 1.0;
-    prob_data.rho_snap = 1.0;
-    prob_data.rho_ineq = 1.0;
-    
-    
-    // @ Lagrange Multiplier
-    prob_data.lamda_x = Eigen :: ArrayXXf :: Ones(prob_data.nvar, 1) *0;
-    prob_data.lamda_y = Eigen :: ArrayXXf :: Ones(prob_data.nvar, 1) *0;
+    bool warm_start = prob_data.warm_start && prob_data.mpc_step > 0;
+
+    if(!warm_start){
+        prob_data.rho_static_obs = 1.0;
+        prob_data.rho_drone = 1.0;
+        prob_data.rho_vel = 1.0;
+        prob_data.rho_acc = 1.0;
+        prob_data.rho_jerk = 1.0;
+        prob_data.rho_snap = 1.0;
+        prob_data.rho_ineq = 1.0;
+
+
+        // @ Lagrange Multiplier
+        prob_data.lamda_x.setZero(prob_data.nvar, 1);
+        prob_data.lamda_y.setZero(prob_data.nvar, 1);
+
+        // @ Position Constraints
+        prob_data.s_x_ineq.setZero(2*prob_data.num, 1);
+        prob_data.s_y_ineq.setZero(2*prob_data.num, 1);
+    }
+
+    beginWorkspace(prob_data);
+
+    if(warm_start)
+        warmStartADMM(prob_data);
+
+    ws.b_eq.col(0) = prob_data.b_x_eq;
+    ws.b_eq.col(1) = prob_data.b_y_eq;
+    holdZ(prob_data);
 
-    // @ Position Constraints
-    prob_data.s_x_ineq = Eigen :: ArrayXXf :: Ones(2*prob_data.num, 1) *0;
-    prob_data.s_y_ineq = Eigen :: ArrayXXf :: Ones(2*prob_data.num, 1) *0;
 
-    
-    if(prob_data.num_drone!=0)cost_drone = prob_data.A_drone.transpose().matrix() * prob_data.A_drone.matrix();
-    if(prob_data.num_static_obs!=0)cost_static_obs = prob_data.A_static_obs.transpose().matrix() * prob_data.A_static_obs.matrix();
-    
-    
     int break_flag;
     for(int i = 0; i < prob_data.max_iter; i++){
 
         break_flag = 0;
+        prob_data.num_iters = i + 1;
 
-        prob_data.b_x_vel = prob_data.d_vel * cos(prob_data.alpha_vel);
-        prob_data.b_y_vel = prob_data.d_vel * sin(prob_data.alpha_vel);
+        prob_data.b_x_vel = prob_data.d_vel * prob_data.dir_x_vel;
+        prob_data.b_y_vel = prob_data.d_vel * prob_data.dir_y_vel;
 
-        prob_data.b_x_acc = prob_data.d_acc * cos(prob_data.alpha_acc);
-        prob_data.b_y_acc = prob_data.d_acc * sin(prob_data.alpha_acc);
-        
-        prob_data.B_x_ineq = prob_data.A_ineq.transpose().matrix() * (prob_data.b_x_ineq - prob_data.s_x_ineq).matrix();
-        prob_data.B_y_ineq = prob_data.A_ineq.transpose().matrix() * (prob_data.b_y_ineq - prob_data.s_y_ineq).matrix();
-        
-        
-        objective_xy = prob_data.weight_goal * prob_data.cost_goal 
-                + prob_data.weight_smoothness * prob_data.cost_smoothness 
-                + prob_data.rho_vel * prob_data.cost_vel 
-                + prob_data.rho_acc * prob_data.cost_acc 
-                + prob_data.rho_ineq * prob_data.cost_ineq;
-        
-        lincost_x = -prob_data.lamda_x
-                    -prob_data.weight_goal * (prob_data.P.bottomRows(prob_data.kappa).transpose().matrix() * prob_data.x_ref.matrix()).array()
-                    -prob_data.rho_vel * (prob_data.Pdot.transpose().matrix() * prob_data.b_x_vel.matrix()).array()
-                    -prob_data.rho_acc * (prob_data.Pddot.transpose().matrix() * prob_data.b_x_acc.matrix()).array()
-                    -prob_data.rho_ineq * prob_data.B_x_ineq;
-
-        lincost_y = -prob_data.lamda_y
-                    -prob_data.weight_goal * (prob_data.P.bottomRows(prob_data.kappa).transpose().matrix() * prob_data.y_ref.matrix()).array()
-                    -prob_data.rho_vel * (prob_data.Pdot.transpose().matrix() * prob_data.b_y_vel.matrix()).array()
-                    -prob_data.rho_acc * (prob_data.Pddot.transpose().matrix() * prob_data.b_y_acc.matrix()).array()
-                    -prob_data.rho_ineq * prob_data.B_y_ineq;
-        
+        prob_data.b_x_acc = prob_data.d_acc * prob_data.dir_x_acc;
+        prob_data.b_y_acc = prob_data.d_acc * prob_data.dir_y_acc;
 
-        // jerk-snap
-        if(prob_data.jerk_snap_constraints){
-            prob_data.b_x_jerk = prob_data.d_jerk * cos(prob_data.alpha_jerk);
-            prob_data.b_y_jerk = prob_data.d_jerk * sin(prob_data.alpha_jerk);
-
-            prob_data.b_x_snap = prob_data.d_snap * cos(prob_data.alpha_snap);
-            prob_data.b_y_snap = prob_data.d_snap * sin(prob_data.alpha_snap);
-            
-            objective_xy += prob_data.rho_jerk * prob_data.cost_jerk
-                + prob_data.rho_snap * prob_data.cost_snap;
-            
-            lincost_x += -prob_data.rho_jerk * (prob_data.Pdddot.transpose().matrix() * prob_data.b_x_jerk.matrix()).array()
-                    -prob_data.rho_snap * (prob_data.Pddddot.transpose().matrix() * prob_data.b_x_snap.matrix()).array();
-
-            lincost_y += -prob_data.rho_jerk * (prob_data.Pdddot.transpose().matrix() * prob_data.b_y_jerk.matrix()).array()
-                    -prob_data.rho_snap * (prob_data.Pddddot.transpose().matrix() * prob_data.b_y_snap.matrix()).array();
-        }			
+        ws.objective_xy = prob_data.weight_goal * basis.cost_goal
+                + prob_data.weight_smoothness * basis.cost_smoothness
+                + prob_data.rho_vel * basis.cost_vel
+                + prob_data.rho_acc * basis.cost_acc
+                + prob_data.rho_ineq * basis.cost_ineq;
 
-        
-        // @ Check for obstacles
-        if(prob_data.num_static_obs!=0){
-            temp_x_static_obs =  prob_data.x_static_obs + prob_data.d_static_obs * cos(prob_data.alpha_static_obs) * prob_data.a_static_obs;
-            temp_y_static_obs =  prob_data.y_static_obs + prob_data.d_static_obs * sin(prob_data.alpha_static_obs) * prob_data.b_static_obs;
+        ws.lincost.col(0) = -prob_data.lamda_x;
+        ws.lincost.col(1) = -prob_data.lamda_y;
 
-            prob_data.b_x_static_obs = reshape(temp_x_static_obs.transpose(), prob_data.num*prob_data.num_static_obs, 1);
-            prob_data.b_y_static_obs = reshape(temp_y_static_obs.transpose(), prob_data.num*prob_data.num_static_obs, 1);
-        
-            objective_xy += prob_data.rho_static_obs * cost_static_obs;
-            lincost_x += -prob_data.rho_static_obs * (prob_data.A_static_obs.transpose().matrix() * prob_data.b_x_static_obs.matrix()).array();
-            lincost_y += -prob_data.rho_static_obs * (prob_data.A_static_obs.transpose().matrix() * prob_data.b_y_static_obs.matrix()).array();
+        ws.lincost.col(0).matrix().noalias() -= prob_data.weight_goal * basis.P.bottomRows(prob_data.kappa).transpose().matrix() * prob_data.x_ref.matrix();
+        ws.lincost.col(0).matrix().noalias() -= prob_data.rho_vel * basis.Pdot.transpose().matrix() * prob_data.b_x_vel.matrix();
+        ws.lincost.col(0).matrix().noalias() -= prob_data.rho_acc * basis.Pddot.transpose().matrix() * prob_data.b_x_acc.matrix();
+        subBoxCost(ws, 0, prob_data.rho_ineq, basis.A_ineq, prob_data.b_x_ineq, prob_data.s_x_ineq);
 
-        }
-        
-        // drones
-        if(prob_data.num_drone!=0){
-            
-            temp_x_drone =  prob_data.x_drone + prob_data.d_drone * cos(prob_data.alpha_drone) * prob_data.a_drone;
-            temp_y_drone =  prob_data.y_drone + prob_data.d_drone * sin(prob_data.alpha_drone) * prob_data.b_drone;
-
-            prob_data.b_x_drone = reshape(temp_x_drone.transpose(), prob_data.num*prob_data.num_drone, 1);
-            prob_data.b_y_drone = reshape(temp_y_drone.transpose(), prob_data.num*prob_data.num_drone, 1);
-            
-            objective_xy += prob_data.rho_drone * cost_drone;
-            
-            
-            lincost_x += -prob_data.rho_drone * (prob_data.A_drone.transpose().matrix() * prob_data.b_x_drone.matrix()).array();
-            lincost_y += -prob_data.rho_drone * (prob_data.A_drone.transpose().matrix() * prob_data.b_y_drone.matrix()).array();			
-        }
+        ws.lincost.col(1).matrix().noalias() -= prob_data.weight_goal * basis.P.bottomRows(prob_data.kappa).transpose().matrix() * prob_data.y_ref.matrix();
+        ws.lincost.col(1).matrix().noalias() -= prob_data.rho_vel * basis.Pdot.transpose().matrix() * prob_data.b_y_vel.matrix();
+        ws.lincost.col(1).matrix().noalias() -= prob_data.rho_acc * basis.Pddot.transpose().matrix() * prob_data.b_y_acc.matrix();
+        subBoxCost(ws, 1, prob_data.rho_ineq, basis.A_ineq, prob_data.b_y_ineq, prob_data.s_y_ineq);
 
-        // @ Solve set of linear equations
-        cost_xy = stack(stack(objective_xy, prob_data.A_eq.transpose(), 'h'), 
-                            stack(prob_data.A_eq, Eigen::ArrayXXf::Zero(prob_data.A_eq.rows(), prob_data.A_eq.rows()), 'h'), 'v');
-        cost_xy_inv = (cost_xy.matrix()).householderQr().solve(prob_data.I.matrix());
 
-        
-        sol_x = cost_xy_inv.matrix() * stack(-lincost_x, prob_data.b_x_eq, 'v').matrix();
-        sol_y = cost_xy_inv.matrix() * stack(-lincost_y, prob_data.b_y_eq, 'v').matrix(); 
+        // jerk-snap
+        if(prob_data.jerk_snap_constraints){
+            prob_data.b_x_jerk = prob_data.d_jerk * prob_data.dir_x_jerk;
+            prob_data.b_y_jerk = prob_data.d_jerk * prob_data.dir_y_jerk;
 
-        
+            prob_data.b_x_snap = prob_data.d_snap * prob_data.dir_x_snap;
+            prob_data.b_y_snap = prob_data.d_snap * prob_data.dir_y_snap;
 
-        prob_data.z = prob_data.z_init * Eigen :: ArrayXXf :: Ones(prob_data.num, 1);
-        prob_data.zdot = Eigen :: ArrayXXf :: Zero(prob_data.num, 1);
-        prob_data.zddot = Eigen :: ArrayXXf :: Zero(prob_data.num, 1);
-        prob_data.zdddot = Eigen :: ArrayXXf :: Zero(prob_data.num, 1);
-        prob_data.zddddot = Eigen :: ArrayXXf :: Zero(prob_data.num, 1);
-                    
-        primal_sol_x = sol_x.topRows(prob_data.nvar);
-        primal_sol_y = sol_y.topRows(prob_data.nvar);
-
-        prob_data.x = prob_data.P.matrix() * primal_sol_x.matrix();
-        prob_data.y = prob_data.P.matrix() * primal_sol_y.matrix();
-        
-        prob_data.xdot = prob_data.Pdot.matrix() * primal_sol_x.matrix();
-        prob_data.ydot = prob_data.Pdot.matrix() * primal_sol_y.matrix();
-        
-        prob_data.xddot = prob_data.Pddot.matrix() * primal_sol_x.matrix();
-        prob_data.yddot = prob_data.Pddot.matrix() * primal_sol_y.matrix();
+            ws.objective_xy += prob_data.rho_jerk * basis.cost_jerk
+                + prob_data.rho_snap * basis.cost_snap;
 
-        prob_data.xdddot = prob_data.Pdddot.matrix() * primal_sol_x.matrix();
-        prob_data.ydddot = prob_data.Pdddot.matrix() * primal_sol_y.matrix();
+            ws.lincost.col(0).matrix().noalias() -= prob_data.rho_jerk * basis.Pdddot.transpose().matrix() * prob_data.b_x_jerk.matrix();
+            ws.lincost.col(0).matrix().noalias() -= prob_data.rho_snap * basis.Pddddot.transpose().matrix() * prob_data.b_x_snap.matrix();
 
-        prob_data.xddddot = prob_data.Pddddot.matrix() * primal_sol_x.matrix();
-        prob_data.yddddot = prob_data.Pddddot.matrix() * primal_sol_y.matrix();	
-        
-        prob_data.x_up = prob_data.P_up.matrix() * primal_sol_x.matrix();
-        prob_data.y_up = prob_data.P_up.matrix() * primal_sol_y.matrix();
-        prob_data.z_up = prob_data.z_init * Eigen :: ArrayXXf :: Ones(prob_data.num_up, 1);
+            ws.lincost.col(1).matrix().noalias() -= prob_data.rho_jerk * basis.Pdddot.transpose().matrix() * prob_data.b_y_jerk.matrix();
+            ws.lincost.col(1).matrix().noalias() -= prob_data.rho_snap * basis.Pddddot.transpose().matrix() * prob_data.b_y_snap.matrix();
+        }
 
-        prob_data.xdot_up = prob_data.Pdot_up.matrix() * primal_sol_x.matrix();
-        prob_data.ydot_up = prob_data.Pdot_up.matrix() * primal_sol_y.matrix();
-        prob_data.zdot_up = Eigen :: ArrayXXf :: Zero(prob_data.num_up, 1);
 
-        prob_data.xddot_up = prob_data.Pddot_up.matrix() * primal_sol_x.matrix();
-        prob_data.yddot_up = prob_data.Pddot_up.matrix() * primal_sol_y.matrix();
-        prob_data.zddot_up = Eigen :: ArrayXXf :: Zero(prob_data.num_up, 1);
-        
+        // @ Check for obstacles
+        assembleCollision(prob_data, 2);
+
+        // @ Solve set of linear equations
+        auto tic = std :: chrono :: high_resolution_clock :: now();
+        solveKKTAxes(prob_data, 2);
+        auto toc = std :: chrono :: high_resolution_clock :: now();
+        tel.time_solve += std :: chrono :: duration<float>(toc - tic).count();
+
+        // Trajectories from the solve, counted with the residuals
+        tic = std :: chrono :: high_resolution_clock :: now();
+        evalAxis(prob_data, 0, prob_data.x, prob_data.xdot, prob_data.xddot, prob_data.xdddot, prob_data.xddddot, prob_data.x_up, prob_data.xdot_up, prob_data.xddot_up);
+        evalAxis(prob_data, 1, prob_data.y, prob_data.ydot, prob_data.yddot, prob_data.ydddot, prob_data.yddddot, prob_data.y_up, prob_data.ydot_up, prob_data.yddot_up);
+        toc = std :: chrono :: high_resolution_clock :: now();
+        tel.time_residual += std :: chrono :: duration<float>(toc - tic).count();
+
         // @ Residual and Lagrange Update
         initAlpha(prob_data, VERBOSE);
-        
+        tic = std :: chrono :: high_resolution_clock :: now();
+        tel.time_polar += std :: chrono :: duration<float>(tic - toc).count();
 
-        prob_data.s_x_ineq = ((-prob_data.A_ineq.matrix() * primal_sol_x.matrix()).array() + prob_data.b_x_ineq).max(0.0);
-        prob_data.s_y_ineq = ((-prob_data.A_ineq.matrix() * primal_sol_y.matrix()).array() + prob_data.b_y_ineq).max(0.0);
+        prob_data.res_x_ineq_norm = updateBox(ws, 0, prob_data.rho_ineq, basis.A_ineq, prob_data.b_x_ineq, prob_data.s_x_ineq, prob_data.lamda_x);
+        prob_data.res_y_ineq_norm = updateBox(ws, 1, prob_data.rho_ineq, basis.A_ineq, prob_data.b_y_ineq, prob_data.s_y_ineq, prob_data.lamda_y);
 
-        res_x_ineq = (prob_data.A_ineq.matrix() * primal_sol_x.matrix()).array() - prob_data.b_x_ineq + prob_data.s_x_ineq;
-        res_y_ineq = (prob_data.A_ineq.matrix() * primal_sol_y.matrix()).array() - prob_data.b_y_ineq + prob_data.s_y_ineq;
-        
-        res_x_vel = prob_data.xdot - prob_data.d_vel * cos(prob_data.alpha_vel);
-        res_y_vel = prob_data.ydot - prob_data.d_vel * sin(prob_data.alpha_vel);
-        
-        res_x_acc = prob_data.xddot - prob_data.d_acc * cos(prob_data.alpha_acc);
-        res_y_acc = prob_data.yddot - prob_data.d_acc * sin(prob_data.alpha_acc);
-        
-        
-    
-        prob_data.lamda_x = prob_data.lamda_x 
-                    -prob_data.rho_vel * (prob_data.Pdot.transpose().matrix() * res_x_vel.matrix()).array()
-                    -prob_data.rho_acc * (prob_data.Pddot.transpose().matrix() * res_x_acc.matrix()).array()
-                    -prob_data.rho_ineq * (prob_data.A_ineq.transpose().matrix() * res_x_ineq.matrix()).array();
+        ws.res_vel.col(0) = prob_data.xdot - prob_data.d_vel * prob_data.dir_x_vel;
+        ws.res_vel.col(1) = prob_data.ydot - prob_data.d_vel * prob_data.dir_y_vel;
+
+        ws.res_acc.col(0) = prob_data.xddot - prob_data.d_acc * prob_data.dir_x_acc;
+        ws.res_acc.col(1) = prob_data.yddot - prob_data.d_acc * prob_data.dir_y_acc;
 
-        prob_data.lamda_y = prob_data.lamda_y 
-                    -prob_data.rho_vel * (prob_data.Pdot.transpose().matrix() * res_y_vel.matrix()).array()
-                    -prob_data.rho_acc * (prob_data.Pddot.transpose().matrix() * res_y_acc.matrix()).array()
-                    -prob_data.rho_ineq * (prob_data.A_ineq.transpose().matrix() * res_y_ineq.matrix()).array();
+        prob_data.lamda_x.matrix().noalias() -= prob_data.rho_vel * basis.Pdot.transpose().matrix() * ws.res_vel.col(0).matrix();
+        prob_data.lamda_x.matrix().noalias() -= prob_data.rho_acc * basis.Pddot.transpose().matrix() * ws.res_acc.col(0).matrix();
+
+        prob_data.lamda_y.matrix().noalias() -= prob_data.rho_vel * basis.Pdot.transpose().matrix() * ws.res_vel.col(1).matrix();
+        prob_data.lamda_y.matrix().noalias() -= prob_data.rho_acc * basis.Pddot.transpose().matrix() * ws.res_acc.col(1).matrix();
 
         if(prob_data.jerk_snap_constraints){
-            res_x_jerk = prob_data.xdddot - prob_data.d_jerk * cos(prob_data.alpha_jerk);
-            res_y_jerk = prob_data.ydddot - prob_data.d_jerk * sin(prob_data.alpha_jerk);
-            
-            res_x_snap = prob_data.xddddot - prob_data.d_snap * cos(prob_data.alpha_snap);
-            res_y_snap = prob_data.yddddot - prob_data.d_snap * sin(prob_data.alpha_snap);
-            
+            ws.res_jerk.col(0) = prob_data.xdddot - prob_data.d_jerk * prob_data.dir_x_jerk;
+            ws.res_jerk.col(1) = prob_data.ydddot - prob_data.d_jerk * prob_data.dir_y_jerk;
+
+            ws.res_snap.col(0) = prob_data.xddddot - prob_data.d_snap * prob_data.dir_x_snap;
+            ws.res_snap.col(1) = prob_data.yddddot - prob_data.d_snap * prob_data.dir_y_snap;
 
-            prob_data.lamda_x += -prob_data.rho_jerk * (prob_data.Pdddot.transpose().matrix() * res_x_jerk.matrix()).array()
-                    -prob_data.rho_snap * (prob_data.Pddddot.transpose().matrix() * res_x_snap.matrix()).array();
+            prob_data.lamda_x.matrix().noalias() -= prob_data.rho_jerk * basis.Pdddot.transpose().matrix() * ws.res_jerk.col(0).matrix();
+            prob_data.lamda_x.matrix().noalias() -= prob_data.rho_snap * basis.Pddddot.transpose().matrix() * ws.res_snap.col(0).matrix();
 
-            prob_data.lamda_y += -prob_data.rho_jerk * (prob_data.Pdddot.transpose().matrix() * res_y_jerk.matrix()).array()
-                    -prob_data.rho_snap * (prob_data.Pddddot.transpose().matrix() * res_y_snap.matrix()).array();
+            prob_data.lamda_y.matrix().noalias() -= prob_data.rho_jerk * basis.Pdddot.transpose().matrix() * ws.res_jerk.col(1).matrix();
+            prob_data.lamda_y.matrix().noalias() -= prob_data.rho_snap * basis.Pddddot.transpose().matrix() * ws.res_snap.col(1).matrix();
 
 
-            prob_data.res_x_jerk_norm = res_x_jerk.matrix().norm();
-            prob_data.res_y_jerk_norm = res_y_jerk.matrix().norm();
+            prob_data.res_x_jerk_norm = ws.res_jerk.col(0).matrix().norm();
+            prob_data.res_y_jerk_norm = ws.res_jerk.col(1).matrix().norm();
 
-            prob_data.res_x_snap_norm = res_x_snap.matrix().norm();
-            prob_data.res_y_snap_norm = res_y_snap.matrix().norm();
+            prob_data.res_x_snap_norm = ws.res_snap.col(0).matrix().norm();
+            prob_data.res_y_snap_norm = ws.res_snap.col(1).matrix().norm();
 
             if(prob_data.res_x_jerk_norm > thresold || prob_data.res_y_jerk_norm > thresold){;
                 prob_data.rho_jerk *= prob_data.delta_jerk;
@@ -627,63 +647,14 @@ void computeXY(probData &prob_data, int VERBOSE)
             break_flag += 2;
         }
 
+        break_flag += updateCollision(prob_data, 2);
 
-        if(prob_data.num_static_obs!=0){
-            
-            res_x_static_obs = reshape(((-prob_data.x_static_obs).rowwise() + prob_data.x.transpose().row(0) - prob_data.a_static_obs * prob_data.d_static_obs * cos(prob_data.alpha_static_obs)).transpose(), prob_data.num_static_obs*prob_data.num, 1);
-            res_y_static_obs = reshape(((-prob_data.y_static_obs).rowwise() + prob_data.y.transpose().row(0) - prob_data.b_static_obs * prob_data.d_static_obs * sin(prob_data.alpha_static_obs)).transpose(), prob_data.num_static_obs*prob_data.num, 1);
-        
-            prob_data.lamda_x = prob_data.lamda_x -prob_data.rho_static_obs * (prob_data.A_static_obs.transpose().matrix() * res_x_static_obs.matrix()).array();
-            prob_data.lamda_y = prob_data.lamda_y -prob_data.rho_static_obs * (prob_data.A_static_obs.transpose().matrix() * res_y_static_obs.matrix()).array();
-        
-            prob_data.res_x_static_obs_norm = res_x_static_obs.matrix().norm();
-            prob_data.res_y_static_obs_norm = res_y_static_obs.matrix().norm();
-        
-            if(prob_data.res_x_static_obs_norm > thresold || prob_data.res_y_static_obs_norm > thresold){
-                prob_data.rho_static_obs *= prob_data.delta_static_obs;
-                if(prob_data.rho_static_obs > prob_data.rho_static_obs_max) prob_data.rho_static_obs = prob_data.rho_static_obs_max;
-            }
-            else break_flag++;
-        }
-        else{
-            prob_data.res_x_static_obs_norm = 0;
-            prob_data.res_y_static_obs_norm = 0;
-            break_flag++;
-        }
+        prob_data.res_x_vel_norm = ws.res_vel.col(0).matrix().norm();
+        prob_data.res_y_vel_norm = ws.res_vel.col(1).matrix().norm();
 
-        if(prob_data.num_drone!=0){
-            
-            res_x_drone = reshape(((-prob_data.x_drone).rowwise() + prob_data.x.transpose().row(0) - prob_data.a_drone * prob_data.d_drone * cos(prob_data.alpha_drone)).transpose(), prob_data.num_drone*prob_data.num, 1);
-            res_y_drone = reshape(((-prob_data.y_drone).rowwise() + prob_data.y.transpose().row(0) - prob_data.b_drone * prob_data.d_drone * sin(prob_data.alpha_drone)).transpose(), prob_data.num_drone*prob_data.num, 1);
-                        
-            prob_data.lamda_x = prob_data.lamda_x -prob_data.rho_drone * (prob_data.A_drone.transpose().matrix() * res_x_drone.matrix()).array();
-            prob_data.lamda_y = prob_data.lamda_y -prob_data.rho_drone * (prob_data.A_drone.transpose().matrix() * res_y_drone.matrix()).array();
-        
-            prob_data.res_x_drone_norm = res_x_drone.matrix().norm();
-            prob_data.res_y_drone_norm = res_y_drone.matrix().norm();
+        prob_data.res_x_acc_norm = ws.res_acc.col(0).matrix().norm();
+        prob_data.res_y_acc_norm = ws.res_acc.col(1).matrix().norm();
 
-            if(prob_data.res_x_drone_norm > thresold || prob_data.res_y_drone_norm > thresold){
-                prob_data.rho_drone *= prob_data.delta_drone;
-                if(prob_data.rho_drone > prob_data.rho_drone_max) prob_data.rho_drone = prob_data.rho_drone_max;
-            }
-            else break_flag++;
-        }
-        else{
-            prob_data.res_x_drone_norm = 0;
-            prob_data.res_y_drone_norm = 0;
-            prob_data.res_z_drone_norm = 0;
-            break_flag++;
-        }
-        
-        prob_data.res_x_ineq_norm = res_x_ineq.matrix().norm();
-        prob_data.res_y_ineq_norm = res_y_ineq.matrix().norm();
-
-        prob_data.res_x_vel_norm = res_x_vel.matrix().norm();
-        prob_data.res_y_vel_norm = res_y_vel.matrix().norm();
-
-        prob_data.res_x_acc_norm = res_x_acc.matrix().norm();
-        prob_data.res_y_acc_norm = res_y_acc.matrix().norm();			
-        
         if((prob_data.res_x_ineq_norm > thresold || prob_data.res_y_ineq_norm > thresold) && prob_data.rho_ineq){;
                 prob_data.rho_ineq *= prob_data.delta_ineq;
                 if(prob_data.rho_ineq > prob_data.rho_ineq_max) prob_data.rho_ineq = prob_data.rho_ineq_max;
@@ -693,52 +664,31 @@ void computeXY(probData &prob_data, int VERBOSE)
                 prob_data.rho_vel *= prob_data.delta_vel;
                 if(prob_data.rho_vel > prob_data.rho_vel_max) prob_data.rho_vel = prob_data.rho_vel_max;
         }
-        else break_flag++;
-        if(prob_data.res_x_acc_norm > thresold || prob_data.res_y_acc_norm > thresold){;
-                prob_data.rho_acc *= prob_data.delta_acc;
-                if(prob_data.rho_acc > prob_data.rho_acc_max) prob_data.rho_acc = prob_data.rho_acc_max;
-        }
-        else break_flag++;
-        
-        if(break_flag == 7)
-            break;	
-    }
-    
-    if(break_flag != 7){
-            prob_data.weight_goal *= prob_data.delta_aggressive;
-            prob_data.weight_smoothness *= prob_data.delta_aggressive;
+        else break_flag++;
+        if(prob_data.res_x_acc_norm > thresold || prob_data.res_y_acc_norm > thresold){;
+                prob_data.rho_acc *= prob_data.delta_acc;
+                if(prob_data.rho_acc > prob_data.rho_acc_max) prob_data.rho_acc = prob_data.rho_acc_max;
         }
-    else{
-        prob_data.weight_goal = prob_data.weight_goal_og;
-        prob_data.weight_smoothness = prob_data.weight_smoothness_og;
+        else break_flag++;
 
-        if(prob_data.weight_goal > prob_data.weight_goal_og)
-            prob_data.weight_goal = prob_data.weight_goal_og;
+        toc = std :: chrono :: high_resolution_clock :: now();
+        tel.time_residual += std :: chrono :: duration<float>(toc - tic).count();
 
-        if(prob_data.weight_goal > prob_data.weight_smoothness_og)
-            prob_data.weight_smoothness = prob_data.weight_smoothness_og;
-    }					
+        if(break_flag == 7)
+            break;
+    }
+
+    endXYZ(prob_data, break_flag);
 }
 
 #include "algorithm/amswarm/solve_position_var.hpp"
 
 void computeXYZAxis(probData &prob_data, int VERBOSE)
 {
-                            
-    Eigen :: ArrayXXf cost_xy, cost_z, cost_xy_inv, cost_z_inv;
-    Eigen :: ArrayXXf objective_xy, objective_z, lincost_x, lincost_y, lincost_z;
-    Eigen :: ArrayXXf cost_drone, cost_static_obs;
-    Eigen :: ArrayXXf temp_x_static_obs, temp_y_static_obs;
-    Eigen :: ArrayXXf temp_x_drone, temp_y_drone, temp_z_drone;
-    Eigen :: ArrayXXf sol_x, sol_y, sol_z, primal_sol_x, primal_sol_y, primal_sol_z;
-    Eigen :: ArrayXXf res_x_static_obs, res_y_static_obs,
-                        res_x_drone, res_y_drone, res_z_drone,
-                        res_vx_ineq, res_vy_ineq, res_vz_ineq,
-                        res_ax_ineq, res_ay_ineq, res_az_ineq,
-                        res_jx_ineq, res_jy_ineq, res_jz_ineq,
-                        res_sx_ineq, res_sy_ineq, res_sz_ineq,
-                        res_x_ineq, res_y_ineq, res_z_ineq;
-    
+    amWorkspace &ws = prob_data.ws;
+    const basisCache &basis = *prob_data.basis;
+    stepTelemetry &tel = prob_data.step_telemetry;
+
     // @ Set Initial Conidtions for next MPC step
     prob_data.b_x_eq << prob_data.x_init, prob_data.vx_init, prob_data.ax_init;
     prob_data.b_y_eq << prob_data.y_init, prob_data.vy_init, prob_data.ay_init;
@@ -746,290 +696,152 @@ void computeXYZAxis(probData &prob_data, int VERBOSE)
 
     float thresold = prob_data.thresold;
 
-    prob_data.rho_static_obs = 1.0;
-    prob_data.rho_drone = 1.0;
-    prob_data.rho_vel = 1.0;
-    prob_data.rho_acc = 1.0;
-    prob_data.rho_jerk = 1.0;
-    prob_data.rho_snap = 1.0;
-    prob_data.rho_ineq = 1.0;
-    
-    
-        // @ Lagrange Multiplier
-    prob_data.lamda_x = Eigen :: ArrayXXf :: Ones(prob_data.nvar, 1) *0;
-    prob_data.lamda_y = Eigen :: ArrayXXf :: Ones(prob_data.nvar, 1) *0;
-    prob_data.lamda_z = Eigen :: ArrayXXf :: Ones(prob_data.nvar, 1) *0;
-
-    // @ Position Constraints
-    prob_data.s_x_ineq = Eigen :: ArrayXXf :: Ones(2*prob_data.num, 1) *0;
-    prob_data.s_y_ineq = Eigen :: ArrayXXf :: Ones(2*prob_data.num, 1) *0;
-    prob_data.s_z_ineq = Eigen :: ArrayXXf :: Ones(2*prob_data.num, 1) *0;
-    
-    // @ Velocity Constraints
-    prob_data.s_vx_ineq = Eigen :: ArrayXXf :: Ones(2*prob_data.num, 1) *0;
-    prob_data.s_vy_ineq = Eigen :: ArrayXXf :: Ones(2*prob_data.num, 1) *0;
-    prob_data.s_vz_ineq = Eigen :: ArrayXXf :: Ones(2*prob_data.num, 1) *0;
+    bool warm_start = prob_data.warm_start && prob_data.mpc_step > 0;
+
+    if(!warm_start){
+        prob_data.rho_static_obs = 1.0;
+        prob_data.rho_drone = 1.0;
+        prob_data.rho_vel = 1.0;
+        prob_data.rho_acc = 1.0;
+        prob_data.rho_jerk = 1.0;
+        prob_data.rho_snap = 1.0;
+        prob_data.rho_ineq = 1.0;
+
 
-    // @ Acceleration Constraints
-    prob_data.s_ax_ineq = Eigen :: ArrayXXf :: Ones(2*prob_data.num, 1) *0;
-    prob_data.s_ay_ineq = Eigen :: ArrayXXf :: Ones(2*prob_data.num, 1) *0;
-    prob_data.s_az_ineq = Eigen :: ArrayXXf :: Ones(2*prob_data.num, 1) *0;
+        // @ Lagrange Multiplier
+        prob_data.lamda_x.setZero(prob_data.nvar, 1);
+        prob_data.lamda_y.setZero(prob_data.nvar, 1);
+        prob_data.lamda_z.setZero(prob_data.nvar, 1);
+
+        // @ Position Constraints
+        prob_data.s_x_ineq.setZero(2*prob_data.num, 1);
+        prob_data.s_y_ineq.setZero(2*prob_data.num, 1);
+        prob_data.s_z_ineq.setZero(2*prob_data.num, 1);
+
+        // @ Velocity Constraints
+        prob_data.s_vx_ineq.setZero(2*prob_data.num, 1);
+        prob_data.s_vy_ineq.setZero(2*prob_data.num, 1);
+        prob_data.s_vz_ineq.setZero(2*prob_data.num, 1);
+
+        // @ Acceleration Constraints
+        prob_data.s_ax_ineq.setZero(2*prob_data.num, 1);
+        prob_data.s_ay_ineq.setZero(2*prob_data.num, 1);
+        prob_data.s_az_ineq.setZero(2*prob_data.num, 1);
+
+        // @ Jerk Constraints
+        prob_data.s_jx_ineq.setZero(2*prob_data.num, 1);
+        prob_data.s_jy_ineq.setZero(2*prob_data.num, 1);
+        prob_data.s_jz_ineq.setZero(2*prob_data.num, 1);
+
+        // @ Snap Constraints
+        prob_data.s_sx_ineq.setZero(2*prob_data.num, 1);
+        prob_data.s_sy_ineq.setZero(2*prob_data.num, 1);
+        prob_data.s_sz_ineq.setZero(2*prob_data.num, 1);
+    }
 
-    // @ Jerk Constraints
-    prob_data.s_jx_ineq = Eigen :: ArrayXXf :: Ones(2*prob_data.num, 1) *0;
-    prob_data.s_jy_ineq = Eigen :: ArrayXXf :: Ones(2*prob_data.num, 1) *0;
-    prob_data.s_jz_ineq = Eigen :: ArrayXXf :: Ones(2*prob_data.num, 1) *0;
+    beginWorkspace(prob_data);
 
-    // @ Snap Constraints
-    prob_data.s_sx_ineq = Eigen :: ArrayXXf :: Ones(2*prob_data.num, 1) *0;
-    prob_data.s_sy_ineq = Eigen :: ArrayXXf :: Ones(2*prob_data.num, 1) *0;
-    prob_data.s_sz_ineq = Eigen :: ArrayXXf :: Ones(2*prob_data.num, 1) *0;
+    if(warm_start)
+        warmStartADMM(prob_data);
 
+    ws.b_eq.col(0) = prob_data.b_x_eq;
+    ws.b_eq.col(1) = prob_data.b_y_eq;
+    ws.b_eq.col(2) = prob_data.b_z_eq;
 
-    if(prob_data.num_drone!=0)cost_drone = prob_data.A_drone.transpose().matrix() * prob_data.A_drone.matrix();
-    if(prob_data.num_static_obs!=0)cost_static_obs = prob_data.A_static_obs.transpose().matrix() * prob_data.A_static_obs.matrix();
-    
     int break_flag;
     for(int i = 0; i < prob_data.max_iter; i++){
 
         break_flag = 0;
-        
-        prob_data.B_x_ineq = prob_data.A_ineq.transpose().matrix() * (prob_data.b_x_ineq - prob_data.s_x_ineq).matrix();
-        prob_data.B_y_ineq = prob_data.A_ineq.transpose().matrix() * (prob_data.b_y_ineq - prob_data.s_y_ineq).matrix();
-        prob_data.B_z_ineq = prob_data.A_ineq.transpose().matrix() * (prob_data.b_z_ineq - prob_data.s_z_ineq).matrix();
-
-        prob_data.B_vx_ineq = prob_data.A_v_ineq.transpose().matrix() * (prob_data.b_vx_ineq - prob_data.s_vx_ineq).matrix();
-        prob_data.B_vy_ineq = prob_data.A_v_ineq.transpose().matrix() * (prob_data.b_vy_ineq - prob_data.s_vy_ineq).matrix();
-        prob_data.B_vz_ineq = prob_data.A_v_ineq.transpose().matrix() * (prob_data.b_vz_ineq - prob_data.s_vz_ineq).matrix();
-
-        prob_data.B_ax_ineq = prob_data.A_a_ineq.transpose().matrix() * (prob_data.b_ax_ineq - prob_data.s_ax_ineq).matrix();
-        prob_data.B_ay_ineq = prob_data.A_a_ineq.transpose().matrix() * (prob_data.b_ay_ineq - prob_data.s_ay_ineq).matrix();
-        prob_data.B_az_ineq = prob_data.A_a_ineq.transpose().matrix() * (prob_data.b_az_ineq - prob_data.s_az_ineq).matrix();
-
-        objective_xy = prob_data.weight_goal * prob_data.cost_goal 
-                + prob_data.weight_smoothness * prob_data.cost_smoothness 
-                + prob_data.rho_vel * prob_data.cost_vel 
-                + prob_data.rho_acc * prob_data.cost_acc 
-                + prob_data.rho_ineq * prob_data.cost_ineq;
-        
-        objective_z = prob_data.weight_goal * prob_data.cost_goal 
-            + prob_data.weight_smoothness * prob_data.cost_smoothness 
-            + prob_data.rho_vel * prob_data.cost_vel 
-            + prob_data.rho_acc * prob_data.cost_acc 
-            + prob_data.rho_ineq * prob_data.cost_ineq;
-
-
-        lincost_x = -prob_data.lamda_x
-                    -prob_data.weight_goal * (prob_data.P.bottomRows(prob_data.kappa).transpose().matrix() * prob_data.x_ref.matrix()).array()
-                    -prob_data.rho_vel * prob_data.B_vx_ineq
-                    -prob_data.rho_acc * prob_data.B_ax_ineq
-                    -prob_data.rho_ineq * prob_data.B_x_ineq;
-
-        lincost_y = -prob_data.lamda_y
-                    -prob_data.weight_goal * (prob_data.P.bottomRows(prob_data.kappa).transpose().matrix() * prob_data.y_ref.matrix()).array()
-                    -prob_data.rho_vel * prob_data.B_vy_ineq
-                    -prob_data.rho_acc * prob_data.B_ay_ineq
-                    -prob_data.rho_ineq * prob_data.B_y_ineq;
-        
-    
-        lincost_z = -prob_data.lamda_z
-                    -prob_data.weight_goal * (prob_data.P.bottomRows(prob_data.kappa).transpose().matrix() * prob_data.z_ref.matrix()).array()
-                    -prob_data.rho_vel * prob_data.B_vz_ineq
-                    -prob_data.rho_acc * prob_data.B_az_ineq
-                    -prob_data.rho_ineq * prob_data.B_z_ineq;
-    
+        prob_data.num_iters = i + 1;
+
+        ws.objective_xy = prob_data.weight_goal * basis.cost_goal
+                + prob_data.weight_smoothness * basis.cost_smoothness
+                + prob_data.rho_vel * basis.cost_vel
+                + prob_data.rho_acc * basis.cost_acc
+                + prob_data.rho_ineq * basis.cost_ineq;
+
+        ws.lincost.col(0) = -prob_data.lamda_x;
+        ws.lincost.col(1) = -prob_data.lamda_y;
+        ws.lincost.col(2) = -prob_data.lamda_z;
+
+        ws.lincost.col(0).matrix().noalias() -= prob_data.weight_goal * basis.P.bottomRows(prob_data.kappa).transpose().matrix() * prob_data.x_ref.matrix();
+        ws.lincost.col(1).matrix().noalias() -= prob_data.weight_goal * basis.P.bottomRows(prob_data.kappa).transpose().matrix() * prob_data.y_ref.matrix();
+        ws.lincost.col(2).matrix().noalias() -= prob_data.weight_goal * basis.P.bottomRows(prob_data.kappa).transpose().matrix() * prob_data.z_ref.matrix();
+
+        subBoxCost(ws, 0, prob_data.rho_vel, basis.A_v_ineq, prob_data.b_vx_ineq, prob_data.s_vx_ineq);
+        subBoxCost(ws, 0, prob_data.rho_acc, basis.A_a_ineq, prob_data.b_ax_ineq, prob_data.s_ax_ineq);
+        subBoxCost(ws, 0, prob_data.rho_ineq, basis.A_ineq, prob_data.b_x_ineq, prob_data.s_x_ineq);
+
+        subBoxCost(ws, 1, prob_data.rho_vel, basis.A_v_ineq, prob_data.b_vy_ineq, prob_data.s_vy_ineq);
+        subBoxCost(ws, 1, prob_data.rho_acc, basis.A_a_ineq, prob_data.b_ay_ineq, prob_data.s_ay_ineq);
+        subBoxCost(ws, 1, prob_data.rho_ineq, basis.A_ineq, prob_data.b_y_ineq, prob_data.s_y_ineq);
+
+        subBoxCost(ws, 2, prob_data.rho_vel, basis.A_v_ineq, prob_data.b_vz_ineq, prob_data.s_vz_ineq);
+        subBoxCost(ws, 2, prob_data.rho_acc, basis.A_a_ineq, prob_data.b_az_ineq, prob_data.s_az_ineq);
+        subBoxCost(ws, 2, prob_data.rho_ineq, basis.A_ineq, prob_data.b_z_ineq, prob_data.s_z_ineq);
+
         if(prob_data.jerk_snap_constraints){
-            prob_data.B_jx_ineq = prob_data.A_j_ineq.transpose().matrix() * (prob_data.b_jx_ineq - prob_data.s_jx_ineq).matrix();
-            prob_data.B_jy_ineq = prob_data.A_j_ineq.transpose().matrix() * (prob_data.b_jy_ineq - prob_data.s_jy_ineq).matrix();
-            prob_data.B_jz_ineq = prob_data.A_j_ineq.transpose().matrix() * (prob_data.b_jz_ineq - prob_data.s_jz_ineq).matrix();
+            ws.objective_xy += prob_data.rho_jerk * basis.cost_jerk
+                + prob_data.rho_snap * basis.cost_snap;
 
-            prob_data.B_sx_ineq = prob_data.A_s_ineq.transpose().matrix() * (prob_data.b_sx_ineq - prob_data.s_sx_ineq).matrix();
-            prob_data.B_sy_ineq = prob_data.A_s_ineq.transpose().matrix() * (prob_data.b_sy_ineq - prob_data.s_sy_ineq).matrix();
-            prob_data.B_sz_ineq = prob_data.A_s_ineq.transpose().matrix() * (prob_data.b_sz_ineq - prob_data.s_sz_ineq).matrix();
-        
-            objective_xy += prob_data.rho_jerk * prob_data.cost_jerk
-                + prob_data.rho_snap * prob_data.cost_snap;
-            objective_z += prob_data.rho_jerk * prob_data.cost_jerk
-                + prob_data.rho_snap * prob_data.cost_snap;
-
-            lincost_x += -prob_data.rho_jerk * prob_data.B_jx_ineq 
-                    -prob_data.rho_snap * prob_data.B_sx_ineq;
-            lincost_y += -prob_data.rho_jerk * prob_data.B_jy_ineq
-                    -prob_data.rho_snap * prob_data.B_sy_ineq;
-            lincost_z += -prob_data.rho_jerk * prob_data.B_jz_ineq
-                    -prob_data.rho_snap * prob_data.B_sz_ineq;
-        }
-        
-        // @ Check for obstacles
-        if(prob_data.num_static_obs!=0){
-            temp_x_static_obs =  prob_data.x_static_obs + prob_data.d_static_obs * cos(prob_data.alpha_static_obs) * prob_data.a_static_obs;
-            temp_y_static_obs =  prob_data.y_static_obs + prob_data.d_static_obs * sin(prob_data.alpha_static_obs) * prob_data.b_static_obs;
+            subBoxCost(ws, 0, prob_data.rho_jerk, basis.A_j_ineq, prob_data.b_jx_ineq, prob_data.s_jx_ineq);
+            subBoxCost(ws, 0, prob_data.rho_snap, basis.A_s_ineq, prob_data.b_sx_ineq, prob_data.s_sx_ineq);
 
-            prob_data.b_x_static_obs = reshape(temp_x_static_obs.transpose(), prob_data.num*prob_data.num_static_obs, 1);
-            prob_data.b_y_static_obs = reshape(temp_y_static_obs.transpose(), prob_data.num*prob_data.num_static_obs, 1);
-        
-            objective_xy += prob_data.rho_static_obs * cost_static_obs;
-            lincost_x += -prob_data.rho_static_obs * (prob_data.A_static_obs.transpose().matrix() * prob_data.b_x_static_obs.matrix()).array();
-            lincost_y += -prob_data.rho_static_obs * (prob_data.A_static_obs.transpose().matrix() * prob_data.b_y_static_obs.matrix()).array();
+            subBoxCost(ws, 1, prob_data.rho_jerk, basis.A_j_ineq, prob_data.b_jy_ineq, prob_data.s_jy_ineq);
+            subBoxCost(ws, 1, prob_data.rho_snap, basis.A_s_ineq, prob_data.b_sy_ineq, prob_data.s_sy_ineq);
 
+            subBoxCost(ws, 2, prob_data.rho_jerk, basis.A_j_ineq, prob_data.b_jz_ineq, prob_data.s_jz_ineq);
+            subBoxCost(ws, 2, prob_data.rho_snap, basis.A_s_ineq, prob_data.b_sz_ineq, prob_data.s_sz_ineq);
         }
-        
-        if(prob_data.num_drone!=0){
-            
-            temp_x_drone =  prob_data.x_drone + prob_data.d_drone * cos(prob_data.alpha_drone) * sin(prob_data.beta_drone) * prob_data.a_drone;
-            temp_y_drone =  prob_data.y_drone + prob_data.d_drone * sin(prob_data.alpha_drone) * sin(prob_data.beta_drone) * prob_data.b_drone;
-            temp_z_drone =  prob_data.z_drone + prob_data.d_drone * cos(prob_data.beta_drone) * prob_data.c_drone;
-
-            prob_data.b_x_drone = reshape(temp_x_drone.transpose(), prob_data.num*prob_data.num_drone, 1);
-            prob_data.b_y_drone = reshape(temp_y_drone.transpose(), prob_data.num*prob_data.num_drone, 1);
-            prob_data.b_z_drone = reshape(temp_z_drone.transpose(), prob_data.num*prob_data.num_drone, 1);
-        
-            objective_xy += prob_data.rho_drone * cost_drone;
-            objective_z += prob_data.rho_drone * cost_drone;
-            
-            lincost_x += -prob_data.rho_drone * (prob_data.A_drone.transpose().matrix() * prob_data.b_x_drone.matrix()).array();
-            lincost_y += -prob_data.rho_drone * (prob_data.A_drone.transpose().matrix() * prob_data.b_y_drone.matrix()).array();
-            lincost_z += -prob_data.rho_drone * (prob_data.A_drone.transpose().matrix() * prob_data.b_z_drone.matrix()).array();
-        
-        }
+        ws.objective_z = ws.objective_xy;
+
+        // @ Check for obstacles
+        assembleCollision(prob_data, 3);
 
         // @ Solve set of linear equations
-        cost_xy = stack(stack(objective_xy, prob_data.A_eq.transpose(), 'h'), 
-                            stack(prob_data.A_eq, Eigen::ArrayXXf::Zero(prob_data.A_eq.rows(), prob_data.A_eq.rows()), 'h'), 'v');
-        cost_xy_inv = (cost_xy.matrix()).householderQr().solve(prob_data.I.matrix());
+        auto tic = std :: chrono :: high_resolution_clock :: now();
+        solveKKTAxes(prob_data, 3);
+        auto toc = std :: chrono :: high_resolution_clock :: now();
+        tel.time_solve += std :: chrono :: duration<float>(toc - tic).count();
+
+        // Trajectories from the solve, counted with the residuals
+        tic = std :: chrono :: high_resolution_clock :: now();
+        evalAxis(prob_data, 0, prob_data.x, prob_data.xdot, prob_data.xddot, prob_data.xdddot, prob_data.xddddot, prob_data.x_up, prob_data.xdot_up, prob_data.xddot_up);
+        evalAxis(prob_data, 1, prob_data.y, prob_data.ydot, prob_data.yddot, prob_data.ydddot, prob_data.yddddot, prob_data.y_up, prob_data.ydot_up, prob_data.yddot_up);
+        evalAxis(prob_data, 2, prob_data.z, prob_data.zdot, prob_data.zddot, prob_data.zdddot, prob_data.zddddot, prob_data.z_up, prob_data.zdot_up, prob_data.zddot_up);
+        toc = std :: chrono :: high_resolution_clock :: now();
+        tel.time_residual += std :: chrono :: duration<float>(toc - tic).count();
 
-        cost_z = stack(stack(objective_z, prob_data.A_eq.transpose(), 'h'), 
-                    stack(prob_data.A_eq, Eigen::ArrayXXf::Zero(prob_data.A_eq.rows(), prob_data.A_eq.rows()), 'h'), 'v');
-        cost_z_inv = (cost_z.matrix()).householderQr().solve(prob_data.I.matrix());
-        
-        sol_x = cost_xy_inv.matrix() * stack(-lincost_x, prob_data.b_x_eq, 'v').matrix();
-        sol_y = cost_xy_inv.matrix() * stack(-lincost_y, prob_data.b_y_eq, 'v').matrix(); 
-        sol_z = cost_z_inv.matrix() * stack(-lincost_z, prob_data.b_z_eq, 'v').matrix(); 
-
-        primal_sol_x = sol_x.topRows(prob_data.nvar);
-        primal_sol_y = sol_y.topRows(prob_data.nvar);
-        primal_sol_z = sol_z.topRows(prob_data.nvar);
-
-        prob_data.x = prob_data.P.matrix() * primal_sol_x.matrix();
-        prob_data.xdot = prob_data.Pdot.matrix() * primal_sol_x.matrix();
-        prob_data.xddot = prob_data.Pddot.matrix() * primal_sol_x.matrix();
-        prob_data.xdddot = prob_data.Pdddot.matrix() * primal_sol_x.matrix();
-        prob_data.xddddot = prob_data.Pddddot.matrix() * primal_sol_x.matrix();
-
-        prob_data.y = prob_data.P.matrix() * primal_sol_y.matrix();
-        prob_data.ydot = prob_data.Pdot.matrix() * primal_sol_y.matrix();
-        prob_data.yddot = prob_data.Pddot.matrix() * primal_sol_y.matrix();
-        prob_data.ydddot = prob_data.Pdddot.matrix() * primal_sol_y.matrix();
-        prob_data.yddddot = prob_data.Pddddot.matrix() * primal_sol_y.matrix();	
-
-        prob_data.z = prob_data.P.matrix() * primal_sol_z.matrix();
-        prob_data.zdot = prob_data.Pdot.matrix() * primal_sol_z.matrix();
-        prob_data.zddot = prob_data.Pddot.matrix() * primal_sol_z.matrix();
-        prob_data.zdddot = prob_data.Pdddot.matrix() * primal_sol_z.matrix();
-        prob_data.zddddot = prob_data.Pddddot.matrix() * primal_sol_z.matrix();
-
-        //////
-        prob_data.x_up = prob_data.P_up.matrix() * primal_sol_x.matrix();
-        prob_data.y_up = prob_data.P_up.matrix() * primal_sol_y.matrix();
-        prob_data.z_up = prob_data.P_up.matrix() * primal_sol_z.matrix();
-
-        prob_data.xdot_up = prob_data.Pdot_up.matrix() * primal_sol_x.matrix();
-        prob_data.ydot_up = prob_data.Pdot_up.matrix() * primal_sol_y.matrix();
-        prob_data.zdot_up = prob_data.Pdot_up.matrix() * primal_sol_z.matrix();
-
-        prob_data.xddot_up = prob_data.Pddot_up.matrix() * primal_sol_x.matrix();
-        prob_data.yddot_up = prob_data.Pddot_up.matrix() * primal_sol_y.matrix();
-        prob_data.zddot_up = prob_data.Pddot_up.matrix() * primal_sol_z.matrix();
-        /////
-        
-        
         // @ Residual and Lagrange Update
         initAlphaBeta(prob_data, VERBOSE);
+        tic = std :: chrono :: high_resolution_clock :: now();
+        tel.time_polar += std :: chrono :: duration<float>(tic - toc).count();
 
         // Position
-        prob_data.s_x_ineq = ((-prob_data.A_ineq.matrix() * primal_sol_x.matrix()).array() + prob_data.b_x_ineq).max(0.0);
-        prob_data.s_y_ineq = ((-prob_data.A_ineq.matrix() * primal_sol_y.matrix()).array() + prob_data.b_y_ineq).max(0.0);
-        prob_data.s_z_ineq = ((-prob_data.A_ineq.matrix() * primal_sol_z.matrix()).array() + prob_data.b_z_ineq).max(0.0);
-
-        res_x_ineq = (prob_data.A_ineq.matrix() * primal_sol_x.matrix()).array() - prob_data.b_x_ineq + prob_data.s_x_ineq;
-        res_y_ineq = (prob_data.A_ineq.matrix() * primal_sol_y.matrix()).array() - prob_data.b_y_ineq + prob_data.s_y_ineq;
-        res_z_ineq = (prob_data.A_ineq.matrix() * primal_sol_z.matrix()).array() - prob_data.b_z_ineq + prob_data.s_z_ineq;
-
+        prob_data.res_x_ineq_norm = updateBox(ws, 0, prob_data.rho_ineq, basis.A_ineq, prob_data.b_x_ineq, prob_data.s_x_ineq, prob_data.lamda_x);
+        prob_data.res_y_ineq_norm = updateBox(ws, 1, prob_data.rho_ineq, basis.A_ineq, prob_data.b_y_ineq, prob_data.s_y_ineq, prob_data.lamda_y);
+        prob_data.res_z_ineq_norm = updateBox(ws, 2, prob_data.rho_ineq, basis.A_ineq, prob_data.b_z_ineq, prob_data.s_z_ineq, prob_data.lamda_z);
 
         // Velocity
-        prob_data.s_vx_ineq = ((-prob_data.A_v_ineq.matrix() * primal_sol_x.matrix()).array() + prob_data.b_vx_ineq).max(0.0);
-        prob_data.s_vy_ineq = ((-prob_data.A_v_ineq.matrix() * primal_sol_y.matrix()).array() + prob_data.b_vy_ineq).max(0.0);
-        prob_data.s_vz_ineq = ((-prob_data.A_v_ineq.matrix() * primal_sol_z.matrix()).array() + prob_data.b_vz_ineq).max(0.0);
-        
-        res_vx_ineq = (prob_data.A_v_ineq.matrix() * primal_sol_x.matrix()).array() - prob_data.b_vx_ineq + prob_data.s_vx_ineq;
-        res_vy_ineq = (prob_data.A_v_ineq.matrix() * primal_sol_y.matrix()).array() - prob_data.b_vy_ineq + prob_data.s_vy_ineq;
-        res_vz_ineq = (prob_data.A_v_ineq.matrix() * primal_sol_z.matrix()).array() - prob_data.b_vz_ineq + prob_data.s_vz_ineq;
+        prob_data.res_x_vel_norm = updateBox(ws, 0, prob_data.rho_vel, basis.A_v_ineq, prob_data.b_vx_ineq, prob_data.s_vx_ineq, prob_data.lamda_x);
+        prob_data.res_y_vel_norm = updateBox(ws, 1, prob_data.rho_vel, basis.A_v_ineq, prob_data.b_vy_ineq, prob_data.s_vy_ineq, prob_data.lamda_y);
+        prob_data.res_z_vel_norm = updateBox(ws, 2, prob_data.rho_vel, basis.A_v_ineq, prob_data.b_vz_ineq, prob_data.s_vz_ineq, prob_data.lamda_z);
 
         // Acceleration
-        prob_data.s_ax_ineq = ((-prob_data.A_a_ineq.matrix() * primal_sol_x.matrix()).array() + prob_data.b_ax_ineq).max(0.0);
-        prob_data.s_ay_ineq = ((-prob_data.A_a_ineq.matrix() * primal_sol_y.matrix()).array() + prob_data.b_ay_ineq).max(0.0);
-        prob_data.s_az_ineq = ((-prob_data.A_a_ineq.matrix() * primal_sol_z.matrix()).array() + prob_data.b_az_ineq).max(0.0);
-        
-        res_ax_ineq = (prob_data.A_a_ineq.matrix() * primal_sol_x.matrix()).array() - prob_data.b_ax_ineq + prob_data.s_ax_ineq;
-        res_ay_ineq = (prob_data.A_a_ineq.matrix() * primal_sol_y.matrix()).array() - prob_data.b_ay_ineq + prob_data.s_ay_ineq;
-        res_az_ineq = (prob_data.A_a_ineq.matrix() * primal_sol_z.matrix()).array() - prob_data.b_az_ineq + prob_data.s_az_ineq;
-
-        prob_data.lamda_x = prob_data.lamda_x 
-                -prob_data.rho_vel * (prob_data.A_v_ineq.transpose().matrix() * res_vx_ineq.matrix()).array()
-                -prob_data.rho_acc * (prob_data.A_a_ineq.transpose().matrix() * res_ax_ineq.matrix()).array()
-                -prob_data.rho_ineq * (prob_data.A_ineq.transpose().matrix() * res_x_ineq.matrix()).array();
-
-        prob_data.lamda_z = prob_data.lamda_z 
-                -prob_data.rho_vel * (prob_data.A_v_ineq.transpose().matrix() * res_vz_ineq.matrix()).array()
-                -prob_data.rho_acc * (prob_data.A_a_ineq.transpose().matrix() * res_az_ineq.matrix()).array()
-                -prob_data.rho_ineq * (prob_data.A_ineq.transpose().matrix() * res_z_ineq.matrix()).array();
-
-        prob_data.lamda_y = prob_data.lamda_y 
-                -prob_data.rho_vel * (prob_data.A_v_ineq.transpose().matrix() * res_vy_ineq.matrix()).array()
-                -prob_data.rho_acc * (prob_data.A_a_ineq.transpose().matrix() * res_ay_ineq.matrix()).array()
-                -prob_data.rho_ineq * (prob_data.A_ineq.transpose().matrix() * res_y_ineq.matrix()).array();
-        
-        
+        prob_data.res_x_acc_norm = updateBox(ws, 0, prob_data.rho_acc, basis.A_a_ineq, prob_data.b_ax_ineq, prob_data.s_ax_ineq, prob_data.lamda_x);
+        prob_data.res_y_acc_norm = updateBox(ws, 1, prob_data.rho_acc, basis.A_a_ineq, prob_data.b_ay_ineq, prob_data.s_ay_ineq, prob_data.lamda_y);
+        prob_data.res_z_acc_norm = updateBox(ws, 2, prob_data.rho_acc, basis.A_a_ineq, prob_data.b_az_ineq, prob_data.s_az_ineq, prob_data.lamda_z);
 
         if(prob_data.jerk_snap_constraints){
             // Jerk
-            prob_data.s_jx_ineq = ((-prob_data.A_j_ineq.matrix() * primal_sol_x.matrix()).array() + prob_data.b_jx_ineq).max(0.0);
-            prob_data.s_jy_ineq = ((-prob_data.A_j_ineq.matrix() * primal_sol_y.matrix()).array() + prob_data.b_jy_ineq).max(0.0);
-            prob_data.s_jz_ineq = ((-prob_data.A_j_ineq.matrix() * primal_sol_z.matrix()).array() + prob_data.b_jz_ineq).max(0.0);
-            
-            res_jx_ineq = (prob_data.A_j_ineq.matrix() * primal_sol_x.matrix()).array() - prob_data.b_jx_ineq + prob_data.s_jx_ineq;
-            res_jy_ineq = (prob_data.A_j_ineq.matrix() * primal_sol_y.matrix()).array() - prob_data.b_jy_ineq + prob_data.s_jy_ineq;
-            res_jz_ineq = (prob_data.A_j_ineq.matrix() * primal_sol_z.matrix()).array() - prob_data.b_jz_ineq + prob_data.s_jz_ineq;
-
+            prob_data.res_x_jerk_norm = updateBox(ws, 0, prob_data.rho_jerk, basis.A_j_ineq, prob_data.b_jx_ineq, prob_data.s_jx_ineq, prob_data.lamda_x);
+            prob_data.res_y_jerk_norm = updateBox(ws, 1, prob_data.rho_jerk, basis.A_j_ineq, prob_data.b_jy_ineq, prob_data.s_jy_ineq, prob_data.lamda_y);
+            prob_data.res_z_jerk_norm = updateBox(ws, 2, prob_data.rho_jerk, basis.A_j_ineq, prob_data.b_jz_ineq, prob_data.s_jz_ineq, prob_data.lamda_z);
 
             // Snap
-            prob_data.s_sx_ineq = ((-prob_data.A_s_ineq.matrix() * primal_sol_x.matrix()).array() + prob_data.b_sx_ineq).max(0.0);
-            prob_data.s_sy_ineq = ((-prob_data.A_s_ineq.matrix() * primal_sol_y.matrix()).array() + prob_data.b_sy_ineq).max(0.0);
-            prob_data.s_sz_ineq = ((-prob_data.A_s_ineq.matrix() * primal_sol_z.matrix()).array() + prob_data.b_sz_ineq).max(0.0);
-
-            res_sx_ineq = (prob_data.A_s_ineq.matrix() * primal_sol_x.matrix()).array() - prob_data.b_sx_ineq + prob_data.s_sx_ineq;
-            res_sy_ineq = (prob_data.A_s_ineq.matrix() * primal_sol_y.matrix()).array() - prob_data.b_sy_ineq + prob_data.s_sy_ineq;
-            res_sz_ineq = (prob_data.A_s_ineq.matrix() * primal_sol_z.matrix()).array() - prob_data.b_sz_ineq + prob_data.s_sz_ineq;
-
-            prob_data.lamda_x = prob_data.lamda_x 
-                            -prob_data.rho_jerk * (prob_data.A_j_ineq.transpose().matrix() * res_jx_ineq.matrix()).array()
-                            -prob_data.rho_snap * (prob_data.A_s_ineq.transpose().matrix() * res_sx_ineq.matrix()).array();
-            
-            prob_data.lamda_y = prob_data.lamda_y 
-                            -prob_data.rho_jerk * (prob_data.A_j_ineq.transpose().matrix() * res_jy_ineq.matrix()).array()
-                            -prob_data.rho_snap * (prob_data.A_s_ineq.transpose().matrix() * res_sy_ineq.matrix()).array();
-
-            prob_data.lamda_z = prob_data.lamda_z
-                            -prob_data.rho_jerk * (prob_data.A_j_ineq.transpose().matrix() * res_jz_ineq.matrix()).array()
-                            -prob_data.rho_snap * (prob_data.A_s_ineq.transpose().matrix() * res_sz_ineq.matrix()).array();
-
-            prob_data.res_x_jerk_norm = res_jx_ineq.matrix().norm();
-            prob_data.res_y_jerk_norm = res_jy_ineq.matrix().norm();
-            prob_data.res_z_jerk_norm = res_jz_ineq.matrix().norm();
-
-            prob_data.res_x_snap_norm = res_sx_ineq.matrix().norm();
-            prob_data.res_y_snap_norm = res_sy_ineq.matrix().norm();
-            prob_data.res_z_snap_norm = res_sz_ineq.matrix().norm();
+            prob_data.res_x_snap_norm = updateBox(ws, 0, prob_data.rho_snap, basis.A_s_ineq, prob_data.b_sx_ineq, prob_data.s_sx_ineq, prob_data.lamda_x);
+            prob_data.res_y_snap_norm = updateBox(ws, 1, prob_data.rho_snap, basis.A_s_ineq, prob_data.b_sy_ineq, prob_data.s_sy_ineq, prob_data.lamda_y);
+            prob_data.res_z_snap_norm = updateBox(ws, 2, prob_data.rho_snap, basis.A_s_ineq, prob_data.b_sz_ineq, prob_data.s_sz_ineq, prob_data.lamda_z);
 
             if(prob_data.res_x_jerk_norm > thresold || prob_data.res_y_jerk_norm > thresold || prob_data.res_z_jerk_norm > thresold){;
                 prob_data.rho_jerk *= prob_data.delta_jerk;
@@ -1054,70 +866,8 @@ void computeXYZAxis(probData &prob_data, int VERBOSE)
             break_flag += 2;
         }
 
-        if(prob_data.num_static_obs!=0){
-            
-            res_x_static_obs = reshape(((-prob_data.x_static_obs).rowwise() + prob_data.x.transpose().row(0) - prob_data.a_static_obs * prob_data.d_static_obs * cos(prob_data.alpha_static_obs)).transpose(), prob_data.num_static_obs*prob_data.num, 1);
-            res_y_static_obs = reshape(((-prob_data.y_static_obs).rowwise() + prob_data.y.transpose().row(0) - prob_data.b_static_obs * prob_data.d_static_obs * sin(prob_data.alpha_static_obs)).transpose(), prob_data.num_static_obs*prob_data.num, 1);
-        
-            prob_data.lamda_x = prob_data.lamda_x -prob_data.rho_static_obs * (prob_data.A_static_obs.transpose().matrix() * res_x_static_obs.matrix()).array();
-            prob_data.lamda_y = prob_data.lamda_y -prob_data.rho_static_obs * (prob_data.A_static_obs.transpose().matrix() * res_y_static_obs.matrix()).array();
-        
-            prob_data.res_x_static_obs_norm = res_x_static_obs.matrix().norm();
-            prob_data.res_y_static_obs_norm = res_y_static_obs.matrix().norm();
-        
-            if(prob_data.res_x_static_obs_norm > thresold || prob_data.res_y_static_obs_norm > thresold){
-                prob_data.rho_static_obs *= prob_data.delta_static_obs;
-                if(prob_data.rho_static_obs > prob_data.rho_static_obs_max) prob_data.rho_static_obs = prob_data.rho_static_obs_max;
-            }
-            else break_flag++;
-        }
-        else{
-            prob_data.res_x_static_obs_norm = 0;
-            prob_data.res_y_static_obs_norm = 0;
-            break_flag++;
-        }
-
-        if(prob_data.num_drone!=0){
-            
-            res_x_drone = reshape(((-prob_data.x_drone).rowwise() + prob_data.x.transpose().row(0) - prob_data.a_drone * prob_data.d_drone * cos(prob_data.alpha_drone) * sin(prob_data.beta_drone)).transpose(), prob_data.num_drone*prob_data.num, 1);
-            res_y_drone = reshape(((-prob_data.y_drone).rowwise() + prob_data.y.transpose().row(0) - prob_data.b_drone * prob_data.d_drone * sin(prob_data.alpha_drone) * sin(prob_data.beta_drone)).transpose(), prob_data.num_drone*prob_data.num, 1);
-            res_z_drone = reshape(((-prob_data.z_drone).rowwise() + prob_data.z.transpose().row(0) - prob_data.c_drone * prob_data.d_drone * cos(prob_data.beta_drone)).transpose(), prob_data.num_drone*prob_data.num, 1);
-
-            prob_data.lamda_z = prob_data.lamda_z -prob_data.rho_drone * (prob_data.A_drone.transpose().matrix() * res_z_drone.matrix()).array();
-            prob_data.res_z_drone_norm = res_z_drone.matrix().norm();
-        
-            prob_data.lamda_x = prob_data.lamda_x -prob_data.rho_drone * (prob_data.A_drone.transpose().matrix() * res_x_drone.matrix()).array();
-            prob_data.lamda_y = prob_data.lamda_y -prob_data.rho_drone * (prob_data.A_drone.transpose().matrix() * res_y_drone.matrix()).array();
-        
-            prob_data.res_x_drone_norm = res_x_drone.matrix().norm();
-            prob_data.res_y_drone_norm = res_y_drone.matrix().norm();
-
-            if(prob_data.res_x_drone_norm > thresold || prob_data.res_y_drone_norm > thresold || prob_data.res_z_drone_norm > thresold){
-                prob_data.rho_drone *= prob_data.delta_drone;
-                if(prob_data.rho_drone > prob_data.rho_drone_max) prob_data.rho_drone = prob_data.rho_drone_max;
-            }
-            else break_flag++;
-        }
-        else{
-            prob_data.res_x_drone_norm = 0;
-            prob_data.res_y_drone_norm = 0;
-            prob_data.res_z_drone_norm = 0;
-            break_flag++;
-        }
-        
-        prob_data.res_x_ineq_norm = res_x_ineq.matrix().norm();
-        prob_data.res_y_ineq_norm = res_y_ineq.matrix().norm();
-        prob_data.res_z_ineq_norm = res_z_ineq.matrix().norm();
-
-        prob_data.res_x_vel_norm = res_vx_ineq.matrix().norm();
-        prob_data.res_y_vel_norm = res_vy_ineq.matrix().norm();
-        prob_data.res_z_vel_norm = res_vz_ineq.matrix().norm();
+        break_flag += updateCollision(prob_data, 3);
 
-        prob_data.res_x_acc_norm = res_ax_ineq.matrix().norm();
-        prob_data.res_y_acc_norm = res_ay_ineq.matrix().norm();
-        prob_data.res_z_acc_norm = res_az_ineq.matrix().norm();
-        
-        
         if(prob_data.res_x_ineq_norm > thresold || prob_data.res_y_ineq_norm > thresold || prob_data.res_z_ineq_norm > thresold){;
                 prob_data.rho_ineq *= prob_data.delta_ineq;
                 if(prob_data.rho_ineq > prob_data.rho_ineq_max) prob_data.rho_ineq = prob_data.rho_ineq_max;
@@ -1133,417 +883,367 @@ void computeXYZAxis(probData &prob_data, int VERBOSE)
                 if(prob_data.rho_acc > prob_data.rho_acc_max) prob_data.rho_acc = prob_data.rho_acc_max;
         }
         else break_flag++;
-        
+
+        toc = std :: chrono :: high_resolution_clock :: now();
+        tel.time_residual += std :: chrono :: duration<float>(toc - tic).count();
 
         if(break_flag == 7)
-            break;	
+            break;
     }
-    
-    if(break_flag != 7){
-            prob_data.weight_goal *= prob_data.delta_aggressive;
-            prob_data.weight_smoothness *= prob_data.delta_aggressive;
-        }
-    else{
-        prob_data.weight_goal = prob_data.weight_goal_og;
-        prob_data.weight_smoothness = prob_data.weight_smoothness_og;
 
-        if(prob_data.weight_goal > prob_data.weight_goal_og)
-            prob_data.weight_goal = prob_data.weight_goal_og;
+    endXYZ(prob_data, break_flag);
+}
 
-        if(prob_data.weight_goal > prob_data.weight_smoothness_og)
-            prob_data.weight_smoothness = prob_data.weight_smoothness_og;
+static void shiftSamples(float *data, int n)
+{
+    // Receding horizon moved by one sample, the last sample is held
+    for(int k = 0; k < n - 1; k++) data[k] = data[k + 1];
+}
+
+void warmStartADMM(probData &prob_data)
+{
+    amWorkspace &ws = prob_data.ws;
+    const basisCache &basis = *prob_data.basis;
+    float decay = prob_data.warm_start_decay;
+
+    // @ Penalties restart from a decayed version of where the last step ended
+    prob_data.rho_static_obs = std :: max(1.0f, decay * prob_data.rho_static_obs);
+    prob_data.rho_drone = std :: max(1.0f, decay * prob_data.rho_drone);
+    prob_data.rho_vel = std :: max(1.0f, decay * prob_data.rho_vel);
+    prob_data.rho_acc = std :: max(1.0f, decay * prob_data.rho_acc);
+    prob_data.rho_jerk = std :: max(1.0f, decay * prob_data.rho_jerk);
+    prob_data.rho_snap = std :: max(1.0f, decay * prob_data.rho_snap);
+    prob_data.rho_ineq = std :: max(1.0f, decay * prob_data.rho_ineq);
+
+    // Planar worlds only carry the xy axes
+    int num_axes = prob_data.world == 3 ? 3 : 2;
+    Eigen :: ArrayXXf *lamda[] = {&prob_data.lamda_x, &prob_data.lamda_y, &prob_data.lamda_z};
+    Eigen :: ArrayXXf *s_ineq[] = {&prob_data.s_x_ineq, &prob_data.s_y_ineq, &prob_data.s_z_ineq};
+
+    for(int k = 0; k < num_axes; k++){
+        // @ Lagrange Multiplier, scaled with the penalties they were accumulated under
+        // (lincost is free until the first iteration)
+        ws.lincost.col(k).matrix().noalias() = decay * basis.shift_dual * lamda[k]->matrix();
+        *lamda[k] = ws.lincost.col(k);
+
+        // @ Position Constraints, upper and lower halves
+        shiftSamples(s_ineq[k]->data(), prob_data.num);
+        shiftSamples(s_ineq[k]->data() + prob_data.num, prob_data.num);
+    }
+
+    if(prob_data.axis_wise){
+        // @ Slacks of the axis-wise derivative bounds, upper and lower halves
+        Eigen :: ArrayXXf *box[][3] = {{&prob_data.s_vx_ineq, &prob_data.s_vy_ineq, &prob_data.s_vz_ineq},
+                                    {&prob_data.s_ax_ineq, &prob_data.s_ay_ineq, &prob_data.s_az_ineq},
+                                    {&prob_data.s_jx_ineq, &prob_data.s_jy_ineq, &prob_data.s_jz_ineq},
+                                    {&prob_data.s_sx_ineq, &prob_data.s_sy_ineq, &prob_data.s_sz_ineq}};
+        int num_box = prob_data.jerk_snap_constraints ? 4 : 2;
+        for(int i = 0; i < num_box; i++)
+            for(int k = 0; k < num_axes; k++){
+                shiftSamples(box[i][k]->data(), prob_data.num);
+                shiftSamples(box[i][k]->data() + prob_data.num, prob_data.num);
+            }
+    }
+    else{
+        // @ Polar variables of the derivative bounds follow the agent's own trajectory
+        Eigen :: ArrayXXf *polar[] = {&prob_data.d_vel, &prob_data.dir_x_vel, &prob_data.dir_y_vel, &prob_data.dir_z_vel,
+                                    &prob_data.d_acc, &prob_data.dir_x_acc, &prob_data.dir_y_acc, &prob_data.dir_z_acc,
+                                    &prob_data.d_jerk, &prob_data.dir_x_jerk, &prob_data.dir_y_jerk, &prob_data.dir_z_jerk,
+                                    &prob_data.d_snap, &prob_data.dir_x_snap, &prob_data.dir_y_snap, &prob_data.dir_z_snap};
+        int num_polar = prob_data.jerk_snap_constraints ? 16 : 8;
+        for(int i = 0; i < num_polar; i++) shiftSamples(polar[i]->data(), prob_data.num);
     }
 }
 
-void computeXYZ(probData &prob_data, int VERBOSE)
+static void beginXYZ(probData &prob_data)
 {
-                            
-    Eigen :: ArrayXXf cost_xy, cost_z, cost_xy_inv, cost_z_inv;
-    Eigen :: ArrayXXf objective_xy, objective_z, lincost_x, lincost_y, lincost_z;
-    Eigen :: ArrayXXf cost_drone, cost_static_obs;
-    Eigen :: ArrayXXf temp_x_static_obs, temp_y_static_obs;
-    Eigen :: ArrayXXf temp_x_drone, temp_y_drone, temp_z_drone;
-    Eigen :: ArrayXXf sol_x, sol_y, sol_z, primal_sol_x, primal_sol_y, primal_sol_z;
-    Eigen :: ArrayXXf res_x_static_obs, res_y_static_obs,
-                        res_x_drone, res_y_drone, res_z_drone,
-                        res_x_vel, res_y_vel, res_z_vel,
-                        res_x_acc, res_y_acc, res_z_acc,
-                        res_x_jerk, res_y_jerk, res_z_jerk,
-                        res_x_snap, res_y_snap, res_z_snap,
-                        res_x_ineq, res_y_ineq, res_z_ineq;
+    // Per MPC step setup of computeXYZ
+    amWorkspace &ws = prob_data.ws;
     
     // @ Set Initial Conidtions for next MPC step
     prob_data.b_x_eq << prob_data.x_init, prob_data.vx_init, prob_data.ax_init;
     prob_data.b_y_eq << prob_data.y_init, prob_data.vy_init, prob_data.ay_init;
     prob_data.b_z_eq << prob_data.z_init, prob_data.vz_init, prob_data.az_init;
 
-    float thresold = prob_data.thresold;
-
-    prob_data.rho_static_obs = 1.0;
-    prob_data.rho_drone = 1.0;
-    prob_data.rho_vel = 1.0;
-    prob_data.rho_acc = 1.0;
-    prob_data.rho_jerk = 1.0;
-    prob_data.rho_snap = 1.0;
-    prob_data.rho_ineq = 1.0;
-    
-    
-    // @ Lagrange Multiplier
-    prob_data.lamda_x = Eigen :: ArrayXXf :: Ones(prob_data.nvar, 1) *0;
-    prob_data.lamda_y = Eigen :: ArrayXXf :: Ones(prob_data.nvar, 1) *0;
-    prob_data.lamda_z = Eigen :: ArrayXXf :: Ones(prob_data.nvar, 1) *0;
-
-    // @ Position Constraints
-    prob_data.s_x_ineq = Eigen :: ArrayXXf :: Ones(2*prob_data.num, 1) *0;
-    prob_data.s_y_ineq = Eigen :: ArrayXXf :: Ones(2*prob_data.num, 1) *0;
-    prob_data.s_z_ineq = Eigen :: ArrayXXf :: Ones(2*prob_data.num, 1) *0;
-
-    
-    if(prob_data.num_drone!=0)cost_drone = prob_data.A_drone.transpose().matrix() * prob_data.A_drone.matrix();
-    if(prob_data.num_static_obs!=0)cost_static_obs = prob_data.A_static_obs.transpose().matrix() * prob_data.A_static_obs.matrix();
-    
-    
-    int break_flag;
-    for(int i = 0; i < prob_data.max_iter; i++){
-
-        break_flag = 0;
-
-        prob_data.b_x_vel = prob_data.d_vel * cos(prob_data.alpha_vel) * sin(prob_data.beta_vel);
-        prob_data.b_y_vel = prob_data.d_vel * sin(prob_data.alpha_vel) * sin(prob_data.beta_vel);
-        prob_data.b_z_vel = prob_data.d_vel * cos(prob_data.beta_vel);
+    bool warm_start = prob_data.warm_start && prob_data.mpc_step > 0;
 
-        prob_data.b_x_acc = prob_data.d_acc * cos(prob_data.alpha_acc) * sin(prob_data.beta_acc);
-        prob_data.b_y_acc = prob_data.d_acc * sin(prob_data.alpha_acc) * sin(prob_data.beta_acc);
-        prob_data.b_z_acc = prob_data.d_acc * cos(prob_data.beta_acc);
-        
-        prob_data.B_x_ineq = prob_data.A_ineq.transpose().matrix() * (prob_data.b_x_ineq - prob_data.s_x_ineq).matrix();
-        prob_data.B_y_ineq = prob_data.A_ineq.transpose().matrix() * (prob_data.b_y_ineq - prob_data.s_y_ineq).matrix();
+    if(!warm_start){
+        prob_data.rho_static_obs = 1.0;
+        prob_data.rho_drone = 1.0;
+        prob_data.rho_vel = 1.0;
+        prob_data.rho_acc = 1.0;
+        prob_data.rho_jerk = 1.0;
+        prob_data.rho_snap = 1.0;
+        prob_data.rho_ineq = 1.0;
         
         
-        objective_xy = prob_data.weight_goal * prob_data.cost_goal 
-                + prob_data.weight_smoothness * prob_data.cost_smoothness 
-                + prob_data.rho_vel * prob_data.cost_vel 
-                + prob_data.rho_acc * prob_data.cost_acc 
-                + prob_data.rho_ineq * prob_data.cost_ineq;
-        
-        lincost_x = -prob_data.lamda_x
-                    -prob_data.weight_goal * (prob_data.P.bottomRows(prob_data.kappa).transpose().matrix() * prob_data.x_ref.matrix()).array()
-                    -prob_data.rho_vel * (prob_data.Pdot.transpose().matrix() * prob_data.b_x_vel.matrix()).array()
-                    -prob_data.rho_acc * (prob_data.Pddot.transpose().matrix() * prob_data.b_x_acc.matrix()).array()
-                    -prob_data.rho_ineq * prob_data.B_x_ineq;
-
-        lincost_y = -prob_data.lamda_y
-                    -prob_data.weight_goal * (prob_data.P.bottomRows(prob_data.kappa).transpose().matrix() * prob_data.y_ref.matrix()).array()
-                    -prob_data.rho_vel * (prob_data.Pdot.transpose().matrix() * prob_data.b_y_vel.matrix()).array()
-                    -prob_data.rho_acc * (prob_data.Pddot.transpose().matrix() * prob_data.b_y_acc.matrix()).array()
-                    -prob_data.rho_ineq * prob_data.B_y_ineq;
-        
-        
-        prob_data.B_z_ineq = prob_data.A_ineq.transpose().matrix() * (prob_data.b_z_ineq - prob_data.s_z_ineq).matrix();
-        objective_z = prob_data.weight_goal * prob_data.cost_goal 
-            + prob_data.weight_smoothness * prob_data.cost_smoothness 
-            + prob_data.rho_vel * prob_data.cost_vel 
-            + prob_data.rho_acc * prob_data.cost_acc 
-            + prob_data.rho_ineq * prob_data.cost_ineq;
-    
-        lincost_z = -prob_data.lamda_z
-                    -prob_data.weight_goal * (prob_data.P.bottomRows(prob_data.kappa).transpose().matrix() * prob_data.z_ref.matrix()).array()
-                    -prob_data.rho_vel * (prob_data.Pdot.transpose().matrix() * prob_data.b_z_vel.matrix()).array()
-                    -prob_data.rho_acc * (prob_data.Pddot.transpose().matrix() * prob_data.b_z_acc.matrix()).array()
-                    -prob_data.rho_ineq * prob_data.B_z_ineq;
-
-        // jerk-snap
-        if(prob_data.jerk_snap_constraints){
-            prob_data.b_x_jerk = prob_data.d_jerk * cos(prob_data.alpha_jerk) * sin(prob_data.beta_jerk);
-            prob_data.b_y_jerk = prob_data.d_jerk * sin(prob_data.alpha_jerk) * sin(prob_data.beta_jerk);
-            prob_data.b_z_jerk = prob_data.d_jerk * cos(prob_data.beta_jerk);
-
-            prob_data.b_x_snap = prob_data.d_snap * cos(prob_data.alpha_snap) * sin(prob_data.beta_snap);
-            prob_data.b_y_snap = prob_data.d_snap * sin(prob_data.alpha_snap) * sin(prob_data.beta_snap);
-            prob_data.b_z_snap = prob_data.d_snap * cos(prob_data.beta_snap);
-
-            objective_xy += prob_data.rho_jerk * prob_data.cost_jerk
-                + prob_data.rho_snap * prob_data.cost_snap;
-            
-            objective_z += prob_data.rho_jerk * prob_data.cost_jerk
-                + prob_data.rho_snap * prob_data.cost_snap;
-
-            lincost_x += -prob_data.rho_jerk * (prob_data.Pdddot.transpose().matrix() * prob_data.b_x_jerk.matrix()).array()
-                    -prob_data.rho_snap * (prob_data.Pddddot.transpose().matrix() * prob_data.b_x_snap.matrix()).array();
+        // @ Lagrange Multiplier
+        prob_data.lamda_x.setZero(prob_data.nvar, 1);
+        prob_data.lamda_y.setZero(prob_data.nvar, 1);
+        prob_data.lamda_z.setZero(prob_data.nvar, 1);
+
+        // @ Position Constraints
+        prob_data.s_x_ineq.setZero(2*prob_data.num, 1);
+        prob_data.s_y_ineq.setZero(2*prob_data.num, 1);
+        prob_data.s_z_ineq.setZero(2*prob_data.num, 1);
+    }
 
-            lincost_y += -prob_data.rho_jerk * (prob_data.Pdddot.transpose().matrix() * prob_data.b_y_jerk.matrix()).array()
-                    -prob_data.rho_snap * (prob_data.Pddddot.transpose().matrix() * prob_data.b_y_snap.matrix()).array();
+    // @ Workspace
+    beginWorkspace(prob_data);
 
-            lincost_z += -prob_data.rho_jerk * (prob_data.Pdddot.transpose().matrix() * prob_data.b_z_jerk.matrix()).array()
-                    -prob_data.rho_snap * (prob_data.Pddddot.transpose().matrix() * prob_data.b_z_snap.matrix()).array();
-        }			
+    if(warm_start) 
+        warmStartADMM(prob_data);
 
-        
-        // @ Check for obstacles
-        if(prob_data.num_static_obs!=0){
-            temp_x_static_obs =  prob_data.x_static_obs + prob_data.d_static_obs * cos(prob_data.alpha_static_obs) * prob_data.a_static_obs;
-            temp_y_static_obs =  prob_data.y_static_obs + prob_data.d_static_obs * sin(prob_data.alpha_static_obs) * prob_data.b_static_obs;
+    ws.b_eq.col(0) = prob_data.b_x_eq;
+    ws.b_eq.col(1) = prob_data.b_y_eq;
+    ws.b_eq.col(2) = prob_data.b_z_eq;
+}
 
-            prob_data.b_x_static_obs = reshape(temp_x_static_obs.transpose(), prob_data.num*prob_data.num_static_obs, 1);
-            prob_data.b_y_static_obs = reshape(temp_y_static_obs.transpose(), prob_data.num*prob_data.num_static_obs, 1);
-        
-            objective_xy += prob_data.rho_static_obs * cost_static_obs;
-            lincost_x += -prob_data.rho_static_obs * (prob_data.A_static_obs.transpose().matrix() * prob_data.b_x_static_obs.matrix()).array();
-            lincost_y += -prob_data.rho_static_obs * (prob_data.A_static_obs.transpose().matrix() * prob_data.b_y_static_obs.matrix()).array();
+template<int Num, int Kappa, int Nvar>
+static void assembleXYZ(probData &prob_data)
+{
+    // Objective and linear cost of one AM iteration from the current slacks, polar variables and multipliers
+    amWorkspace &ws = prob_data.ws;
+    const basisCache &basis = *prob_data.basis;
+    auto P_goal = sized<Num, Nvar>(basis.P).template block<Kappa, Nvar>(prob_data.num - prob_data.kappa, 0, prob_data.kappa, prob_data.nvar);
+    auto Pdot = sized<Num, Nvar>(basis.Pdot), Pddot = sized<Num, Nvar>(basis.Pddot);
+    auto Pdddot = sized<Num, Nvar>(basis.Pdddot), Pddddot = sized<Num, Nvar>(basis.Pddddot);
+    auto A_ineq = sized<stacked(Num), Nvar>(basis.A_ineq);
+    auto objective_xy = sized<Nvar, Nvar>(ws.objective_xy), objective_z = sized<Nvar, Nvar>(ws.objective_z);
+    auto lincost = sized<Nvar, 3>(ws.lincost);
+
+    prob_data.b_x_vel = prob_data.d_vel * prob_data.dir_x_vel;
+    prob_data.b_y_vel = prob_data.d_vel * prob_data.dir_y_vel;
+    prob_data.b_z_vel = prob_data.d_vel * prob_data.dir_z_vel;
+
+    prob_data.b_x_acc = prob_data.d_acc * prob_data.dir_x_acc;
+    prob_data.b_y_acc = prob_data.d_acc * prob_data.dir_y_acc;
+    prob_data.b_z_acc = prob_data.d_acc * prob_data.dir_z_acc;
+    
+    ws.ineq_tmp = prob_data.b_x_ineq - prob_data.s_x_ineq;
+    prob_data.B_x_ineq.matrix().noalias() = times(A_ineq.transpose(), sized<stacked(Num)>(ws.ineq_tmp));
+    ws.ineq_tmp = prob_data.b_y_ineq - prob_data.s_y_ineq;
+    prob_data.B_y_ineq.matrix().noalias() = times(A_ineq.transpose(), sized<stacked(Num)>(ws.ineq_tmp));
+    ws.ineq_tmp = prob_data.b_z_ineq - prob_data.s_z_ineq;
+    prob_data.B_z_ineq.matrix().noalias() = times(A_ineq.transpose(), sized<stacked(Num)>(ws.ineq_tmp));
+    
+    
+    objective_xy = prob_data.weight_goal * sized<Nvar, Nvar>(basis.cost_goal) 
+            + prob_data.weight_smoothness * sized<Nvar, Nvar>(basis.cost_smoothness) 
+            + prob_data.rho_vel * sized<Nvar, Nvar>(basis.cost_vel) 
+            + prob_data.rho_acc * sized<Nvar, Nvar>(basis.cost_acc) 
+            + prob_data.rho_ineq * sized<Nvar, Nvar>(basis.cost_ineq);
+    
+    lincost.col(0) = -sized<Nvar>(prob_data.lamda_x) - prob_data.rho_ineq * sized<Nvar>(prob_data.B_x_ineq);
+    lincost.col(1) = -sized<Nvar>(prob_data.lamda_y) - prob_data.rho_ineq * sized<Nvar>(prob_data.B_y_ineq);
+    lincost.col(2) = -sized<Nvar>(prob_data.lamda_z) - prob_data.rho_ineq * sized<Nvar>(prob_data.B_z_ineq);
 
-        }
-        
-        // drones
-        if(prob_data.num_drone!=0){
-            
-            temp_x_drone =  prob_data.x_drone + prob_data.d_drone * cos(prob_data.alpha_drone) * sin(prob_data.beta_drone) * prob_data.a_drone;
-            temp_y_drone =  prob_data.y_drone + prob_data.d_drone * sin(prob_data.alpha_drone) * sin(prob_data.beta_drone) * prob_data.b_drone;
-            temp_z_drone =  prob_data.z_drone + prob_data.d_drone * cos(prob_data.beta_drone) * prob_data.c_drone;
-
-            prob_data.b_x_drone = reshape(temp_x_drone.transpose(), prob_data.num*prob_data.num_drone, 1);
-            prob_data.b_y_drone = reshape(temp_y_drone.transpose(), prob_data.num*prob_data.num_drone, 1);
-            prob_data.b_z_drone = reshape(temp_z_drone.transpose(), prob_data.num*prob_data.num_drone, 1);
-        
-            objective_xy += prob_data.rho_drone * cost_drone;
-            objective_z += prob_data.rho_drone * cost_drone;
-            
-            lincost_x += -prob_data.rho_drone * (prob_data.A_drone.transpose().matrix() * prob_data.b_x_drone.matrix()).array();
-            lincost_y += -prob_data.rho_drone * (prob_data.A_drone.transpose().matrix() * prob_data.b_y_drone.matrix()).array();
-            lincost_z += -prob_data.rho_drone * (prob_data.A_drone.transpose().matrix() * prob_data.b_z_drone.matrix()).array();
-        
-        }
+    lincost.col(0).noalias() -= prob_data.weight_goal * times(P_goal.transpose(), sized<Kappa>(prob_data.x_ref));
+    lincost.col(0).noalias() -= prob_data.rho_vel * times(Pdot.transpose(), sized<Num>(prob_data.b_x_vel));
+    lincost.col(0).noalias() -= prob_data.rho_acc * times(Pddot.transpose(), sized<Num>(prob_data.b_x_acc));
 
-        // @ Solve set of linear equations
-        cost_xy = stack(stack(objective_xy, prob_data.A_eq.transpose(), 'h'), 
-                            stack(prob_data.A_eq, Eigen::ArrayXXf::Zero(prob_data.A_eq.rows(), prob_data.A_eq.rows()), 'h'), 'v');
-        cost_xy_inv = (cost_xy.matrix()).householderQr().solve(prob_data.I.matrix());
+    lincost.col(1).noalias() -= prob_data.weight_goal * times(P_goal.transpose(), sized<Kappa>(prob_data.y_ref));
+    lincost.col(1).noalias() -= prob_data.rho_vel * times(Pdot.transpose(), sized<Num>(prob_data.b_y_vel));
+    lincost.col(1).noalias() -= prob_data.rho_acc * times(Pddot.transpose(), sized<Num>(prob_data.b_y_acc));
+    
+    objective_z = objective_xy;
 
-        
-        sol_x = cost_xy_inv.matrix() * stack(-lincost_x, prob_data.b_x_eq, 'v').matrix();
-        sol_y = cost_xy_inv.matrix() * stack(-lincost_y, prob_data.b_y_eq, 'v').matrix(); 
+    lincost.col(2).noalias() -= prob_data.weight_goal * times(P_goal.transpose(), sized<Kappa>(prob_data.z_ref));
+    lincost.col(2).noalias() -= prob_data.rho_vel * times(Pdot.transpose(), sized<Num>(prob_data.b_z_vel));
+    lincost.col(2).noalias() -= prob_data.rho_acc * times(Pddot.transpose(), sized<Num>(prob_data.b_z_acc));
 
-        
-            
-        cost_z = stack(stack(objective_z, prob_data.A_eq.transpose(), 'h'), 
-                    stack(prob_data.A_eq, Eigen::ArrayXXf::Zero(prob_data.A_eq.rows(), prob_data.A_eq.rows()), 'h'), 'v');
-        cost_z_inv = (cost_z.matrix()).householderQr().solve(prob_data.I.matrix());
-            
-            
-
-        sol_z = cost_z_inv.matrix() * stack(-lincost_z, prob_data.b_z_eq, 'v').matrix(); 
-        primal_sol_z = sol_z.topRows(prob_data.nvar);
-
-
-        prob_data.z = prob_data.P.matrix() * primal_sol_z.matrix();
-        prob_data.zdot = prob_data.Pdot.matrix() * primal_sol_z.matrix();
-        prob_data.zddot = prob_data.Pddot.matrix() * primal_sol_z.matrix();
-        prob_data.zdddot = prob_data.Pdddot.matrix() * primal_sol_z.matrix();
-        prob_data.zddddot = prob_data.Pddddot.matrix() * primal_sol_z.matrix();
-                    
-        primal_sol_x = sol_x.topRows(prob_data.nvar);
-        primal_sol_y = sol_y.topRows(prob_data.nvar);
-
-        prob_data.x = prob_data.P.matrix() * primal_sol_x.matrix();
-        prob_data.y = prob_data.P.matrix() * primal_sol_y.matrix();
-        
-        prob_data.xdot = prob_data.Pdot.matrix() * primal_sol_x.matrix();
-        prob_data.ydot = prob_data.Pdot.matrix() * primal_sol_y.matrix();
-        
-        prob_data.xddot = prob_data.Pddot.matrix() * primal_sol_x.matrix();
-        prob_data.yddot = prob_data.Pddot.matrix() * primal_sol_y.matrix();
+    // jerk-snap
+    if(prob_data.jerk_snap_constraints){
+        prob_data.b_x_jerk = prob_data.d_jerk * prob_data.dir_x_jerk;
+        prob_data.b_y_jerk = prob_data.d_jerk * prob_data.dir_y_jerk;
+        prob_data.b_z_jerk = prob_data.d_jerk * prob_data.dir_z_jerk;
 
-        prob_data.xdddot = prob_data.Pdddot.matrix() * primal_sol_x.matrix();
-        prob_data.ydddot = prob_data.Pdddot.matrix() * primal_sol_y.matrix();
+        prob_data.b_x_snap = prob_data.d_snap * prob_data.dir_x_snap;
+        prob_data.b_y_snap = prob_data.d_snap * prob_data.dir_y_snap;
+        prob_data.b_z_snap = prob_data.d_snap * prob_data.dir_z_snap;
 
-        prob_data.xddddot = prob_data.Pddddot.matrix() * primal_sol_x.matrix();
-        prob_data.yddddot = prob_data.Pddddot.matrix() * primal_sol_y.matrix();	
+        objective_xy += prob_data.rho_jerk * sized<Nvar, Nvar>(basis.cost_jerk)
+            + prob_data.rho_snap * sized<Nvar, Nvar>(basis.cost_snap);
         
-        prob_data.x_up = prob_data.P_up.matrix() * primal_sol_x.matrix();
-        prob_data.y_up = prob_data.P_up.matrix() * primal_sol_y.matrix();
-        prob_data.z_up = prob_data.P_up.matrix() * primal_sol_z.matrix();
+        objective_z += prob_data.rho_jerk * sized<Nvar, Nvar>(basis.cost_jerk)
+            + prob_data.rho_snap * sized<Nvar, Nvar>(basis.cost_snap);
 
-        prob_data.xdot_up = prob_data.Pdot_up.matrix() * primal_sol_x.matrix();
-        prob_data.ydot_up = prob_data.Pdot_up.matrix() * primal_sol_y.matrix();
-        prob_data.zdot_up = prob_data.Pdot_up.matrix() * primal_sol_z.matrix();
+        lincost.col(0).noalias() -= prob_data.rho_jerk * times(Pdddot.transpose(), sized<Num>(prob_data.b_x_jerk));
+        lincost.col(0).noalias() -= prob_data.rho_snap * times(Pddddot.transpose(), sized<Num>(prob_data.b_x_snap));
 
-        prob_data.xddot_up = prob_data.Pddot_up.matrix() * primal_sol_x.matrix();
-        prob_data.yddot_up = prob_data.Pddot_up.matrix() * primal_sol_y.matrix();
-        prob_data.zddot_up = prob_data.Pddot_up.matrix() * primal_sol_z.matrix();
-        
-        // @ Residual and Lagrange Update
-        initAlphaBeta(prob_data, VERBOSE);
-        
+        lincost.col(1).noalias() -= prob_data.rho_jerk * times(Pdddot.transpose(), sized<Num>(prob_data.b_y_jerk));
+        lincost.col(1).noalias() -= prob_data.rho_snap * times(Pddddot.transpose(), sized<Num>(prob_data.b_y_snap));
 
-        prob_data.s_x_ineq = ((-prob_data.A_ineq.matrix() * primal_sol_x.matrix()).array() + prob_data.b_x_ineq).max(0.0);
-        prob_data.s_y_ineq = ((-prob_data.A_ineq.matrix() * primal_sol_y.matrix()).array() + prob_data.b_y_ineq).max(0.0);
-        prob_data.s_z_ineq = ((-prob_data.A_ineq.matrix() * primal_sol_z.matrix()).array() + prob_data.b_z_ineq).max(0.0);
+        lincost.col(2).noalias() -= prob_data.rho_jerk * times(Pdddot.transpose(), sized<Num>(prob_data.b_z_jerk));
+        lincost.col(2).noalias() -= prob_data.rho_snap * times(Pddddot.transpose(), sized<Num>(prob_data.b_z_snap));
+    }			
 
-        res_x_ineq = (prob_data.A_ineq.matrix() * primal_sol_x.matrix()).array() - prob_data.b_x_ineq + prob_data.s_x_ineq;
-        res_y_ineq = (prob_data.A_ineq.matrix() * primal_sol_y.matrix()).array() - prob_data.b_y_ineq + prob_data.s_y_ineq;
-        res_z_ineq = (prob_data.A_ineq.matrix() * primal_sol_z.matrix()).array() - prob_data.b_z_ineq + prob_data.s_z_ineq;
+    
+    // @ Check for obstacles
+    assembleCollision(prob_data, 3);
+}
 
-        res_x_vel = prob_data.xdot - prob_data.d_vel * cos(prob_data.alpha_vel) * sin(prob_data.beta_vel);
-        res_y_vel = prob_data.ydot - prob_data.d_vel * sin(prob_data.alpha_vel) * sin(prob_data.beta_vel);
-        res_z_vel = prob_data.zdot - prob_data.d_vel * cos(prob_data.beta_vel);
+static void solveXYZ(probData &prob_data)
+{
+    auto tic = std :: chrono :: high_resolution_clock :: now();
+    solveKKTAxes(prob_data, 3);
+    prob_data.step_telemetry.time_solve += std :: chrono :: duration<float>(std :: chrono :: high_resolution_clock :: now() - tic).count();
+}
 
-        res_x_acc = prob_data.xddot - prob_data.d_acc * cos(prob_data.alpha_acc) * sin(prob_data.beta_acc);
-        res_y_acc = prob_data.yddot - prob_data.d_acc * sin(prob_data.alpha_acc) * sin(prob_data.beta_acc);
-        if(!prob_data.use_thrust_values)
-            res_z_acc = prob_data.zddot - prob_data.d_acc * cos(prob_data.beta_acc);
-        else
-            res_z_acc = prob_data.zddot + prob_data.gravity - prob_data.d_acc * cos(prob_data.beta_acc);
-        
-        prob_data.lamda_z = prob_data.lamda_z 
-                -prob_data.rho_vel * (prob_data.Pdot.transpose().matrix() * res_z_vel.matrix()).array()
-                -prob_data.rho_acc * (prob_data.Pddot.transpose().matrix() * res_z_acc.matrix()).array()
-                -prob_data.rho_ineq * (prob_data.A_ineq.transpose().matrix() * res_z_ineq.matrix()).array();
+template<int Num, int Nvar>
+static int updateXYZ(probData &prob_data, int VERBOSE)
+{
+    // Trajectories from the solve, then polar variables, slacks, multipliers and penalties. Returns
+    // the number of converged constraint families, 7 once all are below thresold
+    amWorkspace &ws = prob_data.ws;
+    const basisCache &basis = *prob_data.basis;
+    auto Pdot = sized<Num, Nvar>(basis.Pdot), Pddot = sized<Num, Nvar>(basis.Pddot);
+    auto Pdddot = sized<Num, Nvar>(basis.Pdddot), Pddddot = sized<Num, Nvar>(basis.Pddddot);
+    auto A_ineq = sized<stacked(Num), Nvar>(basis.A_ineq);
+    auto res_ineq = sized<stacked(Num), 3>(ws.res_ineq);
+    auto res_vel = sized<Num, 3>(ws.res_vel), res_acc = sized<Num, 3>(ws.res_acc);
+    auto res_jerk = sized<Num, 3>(ws.res_jerk), res_snap = sized<Num, 3>(ws.res_snap);
+    stepTelemetry &tel = prob_data.step_telemetry;
+    float thresold = prob_data.thresold;
+    int break_flag = 0;
+
+    auto tic = std :: chrono :: high_resolution_clock :: now();
+    evalAxis<Num, Nvar>(prob_data, 0, prob_data.x, prob_data.xdot, prob_data.xddot, prob_data.xdddot, prob_data.xddddot, prob_data.x_up, prob_data.xdot_up, prob_data.xddot_up);
+    evalAxis<Num, Nvar>(prob_data, 1, prob_data.y, prob_data.ydot, prob_data.yddot, prob_data.ydddot, prob_data.yddddot, prob_data.y_up, prob_data.ydot_up, prob_data.yddot_up);
+    evalAxis<Num, Nvar>(prob_data, 2, prob_data.z, prob_data.zdot, prob_data.zddot, prob_data.zdddot, prob_data.zddddot, prob_data.z_up, prob_data.zdot_up, prob_data.zddot_up);
+    auto toc = std :: chrono :: high_resolution_clock :: now();
+    tel.time_residual += std :: chrono :: duration<float>(toc - tic).count();
+
+    // @ Residual and Lagrange Update
+    initAlphaBeta(prob_data, VERBOSE);
+    tic = std :: chrono :: high_resolution_clock :: now();
+    tel.time_polar += std :: chrono :: duration<float>(tic - toc).count();
     
-        prob_data.lamda_x = prob_data.lamda_x 
-                    -prob_data.rho_vel * (prob_data.Pdot.transpose().matrix() * res_x_vel.matrix()).array()
-                    -prob_data.rho_acc * (prob_data.Pddot.transpose().matrix() * res_x_acc.matrix()).array()
-                    -prob_data.rho_ineq * (prob_data.A_ineq.transpose().matrix() * res_x_ineq.matrix()).array();
+    // s = max(0, b - A x), res = A x - b + s
+    res_ineq.noalias() = times(A_ineq, sized<Nvar, 3>(ws.sol));
+    prob_data.s_x_ineq = (prob_data.b_x_ineq - ws.res_ineq.col(0)).max(0.0);
+    prob_data.s_y_ineq = (prob_data.b_y_ineq - ws.res_ineq.col(1)).max(0.0);
+    prob_data.s_z_ineq = (prob_data.b_z_ineq - ws.res_ineq.col(2)).max(0.0);
+
+    ws.res_ineq.col(0) += prob_data.s_x_ineq - prob_data.b_x_ineq;
+    ws.res_ineq.col(1) += prob_data.s_y_ineq - prob_data.b_y_ineq;
+    ws.res_ineq.col(2) += prob_data.s_z_ineq - prob_data.b_z_ineq;
+
+    ws.res_vel.col(0) = prob_data.xdot - prob_data.d_vel * prob_data.dir_x_vel;
+    ws.res_vel.col(1) = prob_data.ydot - prob_data.d_vel * prob_data.dir_y_vel;
+    ws.res_vel.col(2) = prob_data.zdot - prob_data.d_vel * prob_data.dir_z_vel;
+
+    ws.res_acc.col(0) = prob_data.xddot - prob_data.d_acc * prob_data.dir_x_acc;
+    ws.res_acc.col(1) = prob_data.yddot - prob_data.d_acc * prob_data.dir_y_acc;
+    if(!prob_data.use_thrust_values)
+        ws.res_acc.col(2) = prob_data.zddot - prob_data.d_acc * prob_data.dir_z_acc;
+    else
+        ws.res_acc.col(2) = prob_data.zddot + prob_data.gravity - prob_data.d_acc * prob_data.dir_z_acc;
+    
+    prob_data.lamda_z.matrix().noalias() -= prob_data.rho_vel * times(Pdot.transpose(), res_vel.col(2));
+    prob_data.lamda_z.matrix().noalias() -= prob_data.rho_acc * times(Pddot.transpose(), res_acc.col(2));
+    prob_data.lamda_z.matrix().noalias() -= prob_data.rho_ineq * times(A_ineq.transpose(), res_ineq.col(2));
 
-        prob_data.lamda_y = prob_data.lamda_y 
-                    -prob_data.rho_vel * (prob_data.Pdot.transpose().matrix() * res_y_vel.matrix()).array()
-                    -prob_data.rho_acc * (prob_data.Pddot.transpose().matrix() * res_y_acc.matrix()).array()
-                    -prob_data.rho_ineq * (prob_data.A_ineq.transpose().matrix() * res_y_ineq.matrix()).array();
+    prob_data.lamda_x.matrix().noalias() -= prob_data.rho_vel * times(Pdot.transpose(), res_vel.col(0));
+    prob_data.lamda_x.matrix().noalias() -= prob_data.rho_acc * times(Pddot.transpose(), res_acc.col(0));
+    prob_data.lamda_x.matrix().noalias() -= prob_data.rho_ineq * times(A_ineq.transpose(), res_ineq.col(0));
 
-        if(prob_data.jerk_snap_constraints){
-            res_x_jerk = prob_data.xdddot - prob_data.d_jerk * cos(prob_data.alpha_jerk) * sin(prob_data.beta_jerk);
-            res_y_jerk = prob_data.ydddot - prob_data.d_jerk * sin(prob_data.alpha_jerk) * sin(prob_data.beta_jerk);
-            res_z_jerk = prob_data.zdddot - prob_data.d_jerk * cos(prob_data.beta_jerk);
+    prob_data.lamda_y.matrix().noalias() -= prob_data.rho_vel * times(Pdot.transpose(), res_vel.col(1));
+    prob_data.lamda_y.matrix().noalias() -= prob_data.rho_acc * times(Pddot.transpose(), res_acc.col(1));
+    prob_data.lamda_y.matrix().noalias() -= prob_data.rho_ineq * times(A_ineq.transpose(), res_ineq.col(1));
 
-            res_x_snap = prob_data.xddddot - prob_data.d_snap * cos(prob_data.alpha_snap) * sin(prob_data.beta_snap);
-            res_y_snap = prob_data.yddddot - prob_data.d_snap * sin(prob_data.alpha_snap) * sin(prob_data.beta_snap);
-            res_z_snap = prob_data.zddddot - prob_data.d_snap * cos(prob_data.beta_snap);
+    if(prob_data.jerk_snap_constraints){
+        ws.res_jerk.col(0) = prob_data.xdddot - prob_data.d_jerk * prob_data.dir_x_jerk;
+        ws.res_jerk.col(1) = prob_data.ydddot - prob_data.d_jerk * prob_data.dir_y_jerk;
+        ws.res_jerk.col(2) = prob_data.zdddot - prob_data.d_jerk * prob_data.dir_z_jerk;
 
-            prob_data.lamda_x += -prob_data.rho_jerk * (prob_data.Pdddot.transpose().matrix() * res_x_jerk.matrix()).array()
-                    -prob_data.rho_snap * (prob_data.Pddddot.transpose().matrix() * res_x_snap.matrix()).array();
+        ws.res_snap.col(0) = prob_data.xddddot - prob_data.d_snap * prob_data.dir_x_snap;
+        ws.res_snap.col(1) = prob_data.yddddot - prob_data.d_snap * prob_data.dir_y_snap;
+        ws.res_snap.col(2) = prob_data.zddddot - prob_data.d_snap * prob_data.dir_z_snap;
 
-            prob_data.lamda_y += -prob_data.rho_jerk * (prob_data.Pdddot.transpose().matrix() * res_y_jerk.matrix()).array()
-                    -prob_data.rho_snap * (prob_data.Pddddot.transpose().matrix() * res_y_snap.matrix()).array();
+        prob_data.lamda_x.matrix().noalias() -= prob_data.rho_jerk * times(Pdddot.transpose(), res_jerk.col(0));
+        prob_data.lamda_x.matrix().noalias() -= prob_data.rho_snap * times(Pddddot.transpose(), res_snap.col(0));
 
-            prob_data.lamda_z += -prob_data.rho_jerk * (prob_data.Pdddot.transpose().matrix() * res_z_jerk.matrix()).array()
-                -prob_data.rho_snap * (prob_data.Pddddot.transpose().matrix() * res_z_snap.matrix()).array();
+        prob_data.lamda_y.matrix().noalias() -= prob_data.rho_jerk * times(Pdddot.transpose(), res_jerk.col(1));
+        prob_data.lamda_y.matrix().noalias() -= prob_data.rho_snap * times(Pddddot.transpose(), res_snap.col(1));
 
+        prob_data.lamda_z.matrix().noalias() -= prob_data.rho_jerk * times(Pdddot.transpose(), res_jerk.col(2));
+        prob_data.lamda_z.matrix().noalias() -= prob_data.rho_snap * times(Pddddot.transpose(), res_snap.col(2));
 
-            prob_data.res_x_jerk_norm = res_x_jerk.matrix().norm();
-            prob_data.res_y_jerk_norm = res_y_jerk.matrix().norm();
-            prob_data.res_z_jerk_norm = res_z_jerk.matrix().norm();
 
-            prob_data.res_x_snap_norm = res_x_snap.matrix().norm();
-            prob_data.res_y_snap_norm = res_y_snap.matrix().norm();
-            prob_data.res_z_snap_norm = res_z_snap.matrix().norm();
+        prob_data.res_x_jerk_norm = ws.res_jerk.col(0).matrix().norm();
+        prob_data.res_y_jerk_norm = ws.res_jerk.col(1).matrix().norm();
+        prob_data.res_z_jerk_norm = ws.res_jerk.col(2).matrix().norm();
 
-            if(prob_data.res_x_jerk_norm > thresold || prob_data.res_y_jerk_norm > thresold || prob_data.res_z_jerk_norm > thresold){;
-                prob_data.rho_jerk *= prob_data.delta_jerk;
-                if(prob_data.rho_jerk > prob_data.rho_jerk_max) prob_data.rho_jerk = prob_data.rho_jerk_max;
-            }
-            else break_flag++;
+        prob_data.res_x_snap_norm = ws.res_snap.col(0).matrix().norm();
+        prob_data.res_y_snap_norm = ws.res_snap.col(1).matrix().norm();
+        prob_data.res_z_snap_norm = ws.res_snap.col(2).matrix().norm();
 
-            if(prob_data.res_x_snap_norm > thresold || prob_data.res_y_snap_norm > thresold || prob_data.res_z_snap_norm > thresold){;
-                    prob_data.rho_snap *= prob_data.delta_snap;
-                    if(prob_data.rho_snap > prob_data.rho_snap_max) prob_data.rho_snap = prob_data.rho_snap_max;
-            }
-            else break_flag++;
+        if(prob_data.res_x_jerk_norm > thresold || prob_data.res_y_jerk_norm > thresold || prob_data.res_z_jerk_norm > thresold){;
+            prob_data.rho_jerk *= prob_data.delta_jerk;
+            if(prob_data.rho_jerk > prob_data.rho_jerk_max) prob_data.rho_jerk = prob_data.rho_jerk_max;
         }
-        else{
-            prob_data.res_x_jerk_norm = 0.0;
-            prob_data.res_y_jerk_norm = 0.0;
-            prob_data.res_z_jerk_norm = 0.0;
-
-            prob_data.res_x_snap_norm = 0.0;
-            prob_data.res_y_snap_norm = 0.0;
-            prob_data.res_z_snap_norm = 0.0;
+        else break_flag++;
 
-            break_flag += 2;
+        if(prob_data.res_x_snap_norm > thresold || prob_data.res_y_snap_norm > thresold || prob_data.res_z_snap_norm > thresold){;
+                prob_data.rho_snap *= prob_data.delta_snap;
+                if(prob_data.rho_snap > prob_data.rho_snap_max) prob_data.rho_snap = prob_data.rho_snap_max;
         }
+        else break_flag++;
+    }
+    else{
+        prob_data.res_x_jerk_norm = 0.0;
+        prob_data.res_y_jerk_norm = 0.0;
+        prob_data.res_z_jerk_norm = 0.0;
 
+        prob_data.res_x_snap_norm = 0.0;
+        prob_data.res_y_snap_norm = 0.0;
+        prob_data.res_z_snap_norm = 0.0;
 
-        if(prob_data.num_static_obs!=0){
-            
-            res_x_static_obs = reshape(((-prob_data.x_static_obs).rowwise() + prob_data.x.transpose().row(0) - prob_data.a_static_obs * prob_data.d_static_obs * cos(prob_data.alpha_static_obs)).transpose(), prob_data.num_static_obs*prob_data.num, 1);
-            res_y_static_obs = reshape(((-prob_data.y_static_obs).rowwise() + prob_data.y.transpose().row(0) - prob_data.b_static_obs * prob_data.d_static_obs * sin(prob_data.alpha_static_obs)).transpose(), prob_data.num_static_obs*prob_data.num, 1);
-        
-            prob_data.lamda_x = prob_data.lamda_x -prob_data.rho_static_obs * (prob_data.A_static_obs.transpose().matrix() * res_x_static_obs.matrix()).array();
-            prob_data.lamda_y = prob_data.lamda_y -prob_data.rho_static_obs * (prob_data.A_static_obs.transpose().matrix() * res_y_static_obs.matrix()).array();
-        
-            prob_data.res_x_static_obs_norm = res_x_static_obs.matrix().norm();
-            prob_data.res_y_static_obs_norm = res_y_static_obs.matrix().norm();
-        
-            if(prob_data.res_x_static_obs_norm > thresold || prob_data.res_y_static_obs_norm > thresold){
-                prob_data.rho_static_obs *= prob_data.delta_static_obs;
-                if(prob_data.rho_static_obs > prob_data.rho_static_obs_max) prob_data.rho_static_obs = prob_data.rho_static_obs_max;
-            }
-            else break_flag++;
-        }
-        else{
-            prob_data.res_x_static_obs_norm = 0;
-            prob_data.res_y_static_obs_norm = 0;
-            break_flag++;
-        }
-
-        if(prob_data.num_drone!=0){
-            
-            res_x_drone = reshape(((-prob_data.x_drone).rowwise() + prob_data.x.transpose().row(0) - prob_data.a_drone * prob_data.d_drone * cos(prob_data.alpha_drone) * sin(prob_data.beta_drone)).transpose(), prob_data.num_drone*prob_data.num, 1);
-            res_y_drone = reshape(((-prob_data.y_drone).rowwise() + prob_data.y.transpose().row(0) - prob_data.b_drone * prob_data.d_drone * sin(prob_data.alpha_drone) * sin(prob_data.beta_drone)).transpose(), prob_data.num_drone*prob_data.num, 1);
-            res_z_drone = reshape(((-prob_data.z_drone).rowwise() + prob_data.z.transpose().row(0) - prob_data.c_drone * prob_data.d_drone * cos(prob_data.beta_drone)).transpose(), prob_data.num_drone*prob_data.num, 1);
+        break_flag += 2;
+    }
 
-            prob_data.lamda_z = prob_data.lamda_z -prob_data.rho_drone * (prob_data.A_drone.transpose().matrix() * res_z_drone.matrix()).array();
-            prob_data.res_z_drone_norm = res_z_drone.matrix().norm();
-        
-            prob_data.lamda_x = prob_data.lamda_x -prob_data.rho_drone * (prob_data.A_drone.transpose().matrix() * res_x_drone.matrix()).array();
-            prob_data.lamda_y = prob_data.lamda_y -prob_data.rho_drone * (prob_data.A_drone.transpose().matrix() * res_y_drone.matrix()).array();
-        
-            prob_data.res_x_drone_norm = res_x_drone.matrix().norm();
-            prob_data.res_y_drone_norm = res_y_drone.matrix().norm();
 
-            if(prob_data.res_x_drone_norm > thresold || prob_data.res_y_drone_norm > thresold || prob_data.res_z_drone_norm > thresold){
-                prob_data.rho_drone *= prob_data.delta_drone;
-                if(prob_data.rho_drone > prob_data.rho_drone_max) prob_data.rho_drone = prob_data.rho_drone_max;
-            }
-            else break_flag++;
-        }
-        else{
-            prob_data.res_x_drone_norm = 0;
-            prob_data.res_y_drone_norm = 0;
-            prob_data.res_z_drone_norm = 0;
-            break_flag++;
-        }
-        
-        prob_data.res_x_ineq_norm = res_x_ineq.matrix().norm();
-        prob_data.res_y_ineq_norm = res_y_ineq.matrix().norm();
-        prob_data.res_z_ineq_norm = res_z_ineq.matrix().norm();
+    break_flag += updateCollision(prob_data, 3);
+    
+    prob_data.res_x_ineq_norm = ws.res_ineq.col(0).matrix().norm();
+    prob_data.res_y_ineq_norm = ws.res_ineq.col(1).matrix().norm();
+    prob_data.res_z_ineq_norm = ws.res_ineq.col(2).matrix().norm();
 
-        prob_data.res_x_vel_norm = res_x_vel.matrix().norm();
-        prob_data.res_y_vel_norm = res_y_vel.matrix().norm();
-        prob_data.res_z_vel_norm = res_z_vel.matrix().norm();
+    prob_data.res_x_vel_norm = ws.res_vel.col(0).matrix().norm();
+    prob_data.res_y_vel_norm = ws.res_vel.col(1).matrix().norm();
+    prob_data.res_z_vel_norm = ws.res_vel.col(2).matrix().norm();
 
-        prob_data.res_x_acc_norm = res_x_acc.matrix().norm();
-        prob_data.res_y_acc_norm = res_y_acc.matrix().norm();
-        prob_data.res_z_acc_norm = res_z_acc.matrix().norm();
-        
-        
-        if((prob_data.res_x_ineq_norm > thresold || prob_data.res_y_ineq_norm > thresold || prob_data.res_z_ineq_norm > thresold) && prob_data.rho_ineq){;
-                prob_data.rho_ineq *= prob_data.delta_ineq;
-                if(prob_data.rho_ineq > prob_data.rho_ineq_max) prob_data.rho_ineq = prob_data.rho_ineq_max;
-        }
-        else break_flag++;
-        if(prob_data.res_x_vel_norm > thresold || prob_data.res_y_vel_norm > thresold || prob_data.res_z_vel_norm > thresold){;
-                prob_data.rho_vel *= prob_data.delta_vel;
-                if(prob_data.rho_vel > prob_data.rho_vel_max) prob_data.rho_vel = prob_data.rho_vel_max;
-        }
-        else break_flag++;
-        if(prob_data.res_x_acc_norm > thresold || prob_data.res_y_acc_norm > thresold || prob_data.res_z_acc_norm > thresold){;
-                prob_data.rho_acc *= prob_data.delta_acc;
-                if(prob_data.rho_acc > prob_data.rho_acc_max) prob_data.rho_acc = prob_data.rho_acc_max;
-        }
-        else break_flag++;
-        
-        if(break_flag == 7)
-            break;	
-    }
+    prob_data.res_x_acc_norm = ws.res_acc.col(0).matrix().norm();
+    prob_data.res_y_acc_norm = ws.res_acc.col(1).matrix().norm();
+    prob_data.res_z_acc_norm = ws.res_acc.col(2).matrix().norm();
     
+    
+    if((prob_data.res_x_ineq_norm > thresold || prob_data.res_y_ineq_norm > thresold || prob_data.res_z_ineq_norm > thresold) && prob_data.rho_ineq){;
+            prob_data.rho_ineq *= prob_data.delta_ineq;
+            if(prob_data.rho_ineq > prob_data.rho_ineq_max) prob_data.rho_ineq = prob_data.rho_ineq_max;
+    }
+    else break_flag++;
+    if(prob_data.res_x_vel_norm > thresold || prob_data.res_y_vel_norm > thresold || prob_data.res_z_vel_norm > thresold){;
+            prob_data.rho_vel *= prob_data.delta_vel;
+            if(prob_data.rho_vel > prob_data.rho_vel_max) prob_data.rho_vel = prob_data.rho_vel_max;
+    }
+    else break_flag++;
+    if(prob_data.res_x_acc_norm > thresold || prob_data.res_y_acc_norm > thresold || prob_data.res_z_acc_norm > thresold){;
+            prob_data.rho_acc *= prob_data.delta_acc;
+            if(prob_data.rho_acc > prob_data.rho_acc_max) prob_data.rho_acc = prob_data.rho_acc_max;
+    }
+    else break_flag++;
+
+    toc = std :: chrono :: high_resolution_clock :: now();
+    tel.time_residual += std :: chrono :: duration<float>(toc - tic).count();
+
+    return break_flag;
+}
+
+void endXYZ(probData &prob_data, int break_flag)
+{
+    prob_data.converged = break_flag == 7;
     if(break_flag != 7){
             prob_data.weight_goal *= prob_data.delta_aggressive;
             prob_data.weight_smoothness *= prob_data.delta_aggressive;
@@ -1560,6 +1260,36 @@ void computeXYZ(probData &prob_data, int VERBOSE)
     }					
 }
 
+template<int Num, int Kappa, int Nvar>
+static int iterateXYZ(probData &prob_data, int VERBOSE)
+{
+    int break_flag;
+    for(int i = 0; i < prob_data.max_iter; i++){
+        prob_data.num_iters = i + 1;
+
+        assembleXYZ<Num, Kappa, Nvar>(prob_data);
+        solveXYZ(prob_data);
+        break_flag = updateXYZ<Num, Nvar>(prob_data, VERBOSE);
+        if(break_flag == 7)
+            break;	
+    }
+    return break_flag;
+}
+
+void computeXYZ(probData &prob_data, int VERBOSE)
+{
+    beginXYZ(prob_data);
+
+    // The shipped horizon (prob_data.fixed_basis, set by initializeOptimizer) runs with the basis
+    // products and 11x11 cost sums sized at compile time
+    int break_flag;
+    if(prob_data.fixed_basis)
+        break_flag = iterateXYZ<FIXED_NUM, FIXED_KAPPA, 11>(prob_data, VERBOSE);
+    else
+        break_flag = iterateXYZ<Eigen :: Dynamic, Eigen :: Dynamic, Eigen :: Dynamic>(prob_data, VERBOSE);
+    endXYZ(prob_data, break_flag);
+}
+
 void checkResiduals(probData &prob_data, int VERBOSE)
 {
     float thresold = prob_data.thresold;
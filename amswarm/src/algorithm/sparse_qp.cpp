@@ -0,0 +1,407 @@
+#include "algorithm/scp/sparse_qp.hpp"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Fixed ADMM constants, as in OSQP
+static const double QP_SIGMA = 1e-6;
+static const double QP_ALPHA = 1.6;
+static const double QP_RHO_EQ_FACTOR = 1e3;
+static const double QP_RHO_MIN = 1e-6, QP_RHO_MAX = 1e6;
+static const double QP_SCALE_MIN = 1e-4, QP_SCALE_MAX = 1e4;
+static const int QP_SCALING_ITER = 10;
+static const int QP_CHECK_EVERY = 25;
+
+// Bound of the open side of a row. The build assumes finite math, so no infinities or NaNs
+static const double QP_INFTY = 1e12;
+
+static double normInf(const Eigen :: VectorXd &v)
+{
+    return v.size() == 0 ? 0.0 : v.lpNorm<Eigen :: Infinity>();
+}
+
+// Infinity norm of every column of a column major matrix
+static Eigen :: VectorXd colNormInf(const Eigen :: SparseMatrix<double> &M)
+{
+    Eigen :: VectorXd norm = Eigen :: VectorXd :: Zero(M.cols());
+    for(int k = 0; k < M.outerSize(); k++)
+        for(Eigen :: SparseMatrix<double> :: InnerIterator it(M, k); it; ++it)
+            norm(k) = std :: max(norm(k), std :: abs(it.value()));
+    return norm;
+}
+
+static Eigen :: VectorXd rowNormInf(const Eigen :: SparseMatrix<double> &M)
+{
+    Eigen :: VectorXd norm = Eigen :: VectorXd :: Zero(M.rows());
+    for(int k = 0; k < M.outerSize(); k++)
+        for(Eigen :: SparseMatrix<double> :: InnerIterator it(M, k); it; ++it)
+            norm(it.row()) = std :: max(norm(it.row()), std :: abs(it.value()));
+    return norm;
+}
+
+// 1/sqrt of the norms, unit scaling for empty or degenerate rows
+static Eigen :: VectorXd scaleStep(const Eigen :: VectorXd &norm)
+{
+    Eigen :: VectorXd step(norm.size());
+    for(int i = 0; i < norm.size(); i++)
+        step(i) = norm(i) < QP_SCALE_MIN ? 1.0 : 1.0/std :: sqrt(std :: min(norm(i), QP_SCALE_MAX));
+    return step;
+}
+
+SparseQP :: SparseQP(const sparseQPSettings &settings){
+    this->settings = settings;
+    status = 1;
+    num_iter = 0;
+    w_lin = 0.0;
+    w_quad = 0.0;
+    setup = false;
+}
+
+void SparseQP :: penalize(const Eigen :: SparseMatrix<double> &A_pen, const Eigen :: VectorXd &b_pen, double w_lin, double w_quad){
+    this->A_pen = A_pen;
+    this->b_pen = b_pen;
+    this->w_lin = w_lin;
+    this->w_quad = w_quad;
+}
+
+const Eigen :: VectorXd &SparseQP :: result() const{
+    return x_out;
+}
+
+int SparseQP :: fail() const{
+    return status;
+}
+
+int SparseQP :: iterations() const{
+    return num_iter;
+}
+
+// Copies the values of P and [A_eq; A_ineq; A_pen] into the scaled P and A of the previous solve,
+// applying its scaling. False (leaving P and A to be rebuilt) when the sparsity pattern differs
+bool SparseQP :: restack(const Eigen :: SparseMatrix<double> &P, const Eigen :: SparseMatrix<double> &A_eq, const Eigen :: SparseMatrix<double> &A_ineq){
+    if(!setup || P.rows() != this->P.rows() || A_eq.cols() != this->A.cols() || A_eq.rows() != m_eq
+        || A_eq.rows() + A_ineq.rows() != m_hard || m_hard + A_pen.rows() != this->A.rows()
+        || P.nonZeros() != this->P.nonZeros() || A_eq.nonZeros() + A_ineq.nonZeros() + A_pen.nonZeros() != this->A.nonZeros())
+        return false;
+
+    for(int k = 0; k < P.outerSize(); k++){
+        int p = this->P.outerIndexPtr()[k];
+        for(Eigen :: SparseMatrix<double> :: InnerIterator it(P, k); it; ++it, p++){
+            if(p == this->P.outerIndexPtr()[k + 1] || this->P.innerIndexPtr()[p] != it.row())
+                return false;
+            this->P.valuePtr()[p] = c * D(it.row()) * D(k) * it.value();
+        }
+        if(p != this->P.outerIndexPtr()[k + 1])
+            return false;
+    }
+
+    const Eigen :: SparseMatrix<double> *blocks[3] = {&A_eq, &A_ineq, &A_pen};
+    int offset[3] = {0, m_eq, m_hard};
+    for(int k = 0; k < this->A.outerSize(); k++){
+        int p = this->A.outerIndexPtr()[k];
+        for(int b = 0; b < 3; b++)
+            for(Eigen :: SparseMatrix<double> :: InnerIterator it(*blocks[b], k); it; ++it, p++){
+                int row = offset[b] + it.row();
+                if(p == this->A.outerIndexPtr()[k + 1] || this->A.innerIndexPtr()[p] != row)
+                    return false;
+                this->A.valuePtr()[p] = E(row) * D(k) * it.value();
+            }
+        if(p != this->A.outerIndexPtr()[k + 1])
+            return false;
+    }
+    return true;
+}
+
+// Ruiz equilibration of the KKT matrix [P A^T; A 0] followed by a cost scaling c,
+// the scaled problem is in D^-1 x with constraints E A D and costs c D P D, c D q
+void SparseQP :: scale(){
+    int n = P.cols(), m = A.rows();
+    D = Eigen :: VectorXd :: Ones(n);
+    E = Eigen :: VectorXd :: Ones(m);
+    c = 1.0;
+
+    for(int k = 0; k < QP_SCALING_ITER; k++){
+        Eigen :: VectorXd d = scaleStep(colNormInf(P).cwiseMax(colNormInf(A)));
+        Eigen :: VectorXd e = scaleStep(rowNormInf(A));
+
+        P = d.asDiagonal() * P * d.asDiagonal();
+        A = e.asDiagonal() * A * d.asDiagonal();
+        q = q.cwiseProduct(d);
+        D = D.cwiseProduct(d);
+        E = E.cwiseProduct(e);
+
+        double cost_norm = std :: max(colNormInf(P).mean(), normInf(q));
+        double gamma = cost_norm < QP_SCALE_MIN ? 1.0 : 1.0/std :: min(cost_norm, QP_SCALE_MAX);
+        P *= gamma;
+        q *= gamma;
+        c *= gamma;
+    }
+}
+
+// Bounds and soft row charges of the scaled problem
+void SparseQP :: scaleBounds(){
+    int m = A.rows();
+    for(int i = 0; i < m; i++){
+        if(l(i) > -QP_INFTY) l(i) *= E(i);
+        if(u(i) < QP_INFTY) u(i) *= E(i);
+    }
+
+    // A violation t of soft row i is E_i t in the scaled row and its charge is scaled by c
+    pen_lin = Eigen :: VectorXd :: Zero(m);
+    pen_quad = Eigen :: VectorXd :: Zero(m);
+    for(int i = m_hard; i < m; i++){
+        pen_lin(i) = c * w_lin / E(i);
+        pen_quad(i) = c * w_quad / (E(i) * E(i));
+    }
+}
+
+// z update, projection on [l, u] for the constraint rows and the proximal step of the
+// penalty w_lin t + 0.5 w_quad t^2 on the violation t = z - u of the soft rows
+void SparseQP :: project(const Eigen :: VectorXd &v){
+    z = v.cwiseMax(l).cwiseMin(u);
+    for(int i = m_hard; i < z.size(); i++){
+        if(v(i) <= u(i))
+            z(i) = v(i);
+        else if(v(i) <= u(i) + pen_lin(i) / rho(i))
+            z(i) = u(i);
+        else
+            z(i) = (rho(i) * v(i) + pen_quad(i) * u(i) - pen_lin(i)) / (rho(i) + pen_quad(i));
+    }
+}
+
+// K keeps its pattern for a given pattern of P and A, so the ordering is only recomputed with analyze
+bool SparseQP :: factorize(bool analyze){
+    int n = P.cols();
+    Eigen :: SparseMatrix<double> I(n, n);
+    I.setIdentity();
+    K = P + QP_SIGMA * I + Eigen :: SparseMatrix<double>(A.transpose() * rho.asDiagonal() * A);
+    if(analyze)
+        ldlt.analyzePattern(K);
+    ldlt.factorize(K);
+    return ldlt.info() == Eigen :: Success;
+}
+
+// Residuals of the unscaled problem at a scaled point and the tolerances they are compared to
+void SparseQP :: residuals(const Eigen :: VectorXd &x, const Eigen :: VectorXd &z, const Eigen :: VectorXd &y,
+                            double &res_prim, double &res_dual, double &tol_prim, double &tol_dual) const{
+    Eigen :: VectorXd Ax = A * x, Px = P * x, Aty = A.transpose() * y;
+    Eigen :: VectorXd E_inv = E.cwiseInverse(), D_inv = D.cwiseInverse();
+
+    res_prim = normInf(E_inv.cwiseProduct(Ax - z));
+    res_dual = normInf(D_inv.cwiseProduct(Px + q + Aty)) / c;
+    tol_prim = settings.eps_abs + settings.eps_rel * std :: max(normInf(E_inv.cwiseProduct(Ax)), normInf(E_inv.cwiseProduct(z)));
+    tol_dual = settings.eps_abs + settings.eps_rel * std :: max(std :: max(normInf(D_inv.cwiseProduct(Px)), normInf(D_inv.cwiseProduct(Aty))),
+                                                                    normInf(D_inv.cwiseProduct(q))) / c;
+}
+
+// Solution polishing as in OSQP, guesses the active set from the multipliers and solves the
+// equality constrained QP on it. Soft rows are either active, inactive or penalized, the last
+// adding their quadratic charge to the cost. The iterate is replaced only when the polished
+// point meets the tolerances, so a wrong guess early in the solve leaves the ADMM state untouched
+bool SparseQP :: polish(){
+    const double delta = 1e-6;
+    int n = P.cols(), m = A.rows();
+
+    std :: vector<int> active;
+    std :: vector<bool> at_lower;
+    Eigen :: VectorXd b_active(m), pen_weight = Eigen :: VectorXd :: Zero(m), pen_grad = Eigen :: VectorXd :: Zero(m);
+    for(int i = 0; i < m; i++){
+        if(i >= m_hard && z(i) > u(i)){
+            pen_weight(i) = pen_quad(i);
+            pen_grad(i) = pen_lin(i) - pen_quad(i) * u(i);
+            continue;
+        }
+        bool lower = z(i) - l(i) < -y(i);
+        if(lower || u(i) - z(i) < y(i)){
+            b_active(active.size()) = lower ? l(i) : u(i);
+            active.push_back(i);
+            at_lower.push_back(lower);
+        }
+    }
+    int m_active = active.size();
+
+    // @ Quasi-definite KKT [P + A^T W A + delta I, A_act^T; A_act, -delta I], W the penalized rows
+    Eigen :: SparseMatrix<double> P_pol = P;
+    if(pen_weight.any())
+        P_pol += Eigen :: SparseMatrix<double>(A.transpose() * pen_weight.asDiagonal() * A);
+    Eigen :: VectorXd q_pol = q + A.transpose() * pen_grad;
+
+    std :: vector<int> row_of(m, -1);
+    for(int k = 0; k < m_active; k++)
+        row_of[active[k]] = n + k;
+
+    std :: vector<Eigen :: Triplet<double>> triplets;
+    triplets.reserve(P_pol.nonZeros() + 2*A.nonZeros() + n + m_active);
+    for(int k = 0; k < P_pol.outerSize(); k++)
+        for(Eigen :: SparseMatrix<double> :: InnerIterator it(P_pol, k); it; ++it)
+            triplets.emplace_back(it.row(), it.col(), it.value());
+    for(int k = 0; k < A.outerSize(); k++)
+        for(Eigen :: SparseMatrix<double> :: InnerIterator it(A, k); it; ++it)
+            if(row_of[it.row()] >= 0){
+                triplets.emplace_back(row_of[it.row()], it.col(), it.value());
+                triplets.emplace_back(it.col(), row_of[it.row()], it.value());
+            }
+
+    Eigen :: SparseMatrix<double> kkt(n + m_active, n + m_active), kkt_reg(n + m_active, n + m_active);
+    kkt.setFromTriplets(triplets.begin(), triplets.end());
+    for(int i = 0; i < n + m_active; i++)
+        triplets.emplace_back(i, i, i < n ? delta : -delta);
+    kkt_reg.setFromTriplets(triplets.begin(), triplets.end());
+
+    Eigen :: SimplicialLDLT<Eigen :: SparseMatrix<double>> kkt_ldlt(kkt_reg);
+    if(kkt_ldlt.info() != Eigen :: Success)
+        return false;
+
+    // Iterative refinement towards the unregularized system
+    Eigen :: VectorXd rhs(n + m_active);
+    rhs << -q_pol, b_active.head(m_active);
+    Eigen :: VectorXd sol = kkt_ldlt.solve(rhs);
+    for(int k = 0; k < 3; k++)
+        sol += kkt_ldlt.solve(rhs - kkt * sol);
+    if(normInf(sol) >= QP_INFTY)
+        return false;
+
+    // Multipliers of the guessed set must have the sign of their bound, otherwise it is not optimal
+    Eigen :: VectorXd x_pol = sol.head(n), y_pol = Eigen :: VectorXd :: Zero(m);
+    for(int k = 0; k < m_active; k++){
+        int i = active[k];
+        y_pol(i) = sol(n + k);
+        if(l(i) != u(i) && (at_lower[k] ? y_pol(i) > 0.0 : y_pol(i) < 0.0))
+            return false;
+        if(i >= m_hard && y_pol(i) > pen_lin(i))
+            return false;
+    }
+
+    // Soft rows are charged rather than bounded, their residual is the mismatch with the guess
+    Eigen :: VectorXd Ax = A * x_pol;
+    Eigen :: VectorXd z_pol = Ax.cwiseMax(l).cwiseMin(u);
+    for(int i = m_hard; i < m; i++){
+        if(pen_weight(i) > 0.0){
+            y_pol(i) = pen_lin(i) + pen_quad(i) * (Ax(i) - u(i));
+            z_pol(i) = std :: max(Ax(i), u(i));
+        }
+        else if(row_of[i] < 0)
+            z_pol(i) = std :: min(Ax(i), u(i));
+    }
+
+    double res_prim, res_dual, tol_prim, tol_dual;
+    residuals(x_pol, z_pol, y_pol, res_prim, res_dual, tol_prim, tol_dual);
+    if(res_prim > tol_prim || res_dual > tol_dual)
+        return false;
+
+    x = x_pol;
+    z = z_pol;
+    y = y_pol;
+    return true;
+}
+
+bool SparseQP :: solve(const Eigen :: SparseMatrix<double> &P, const Eigen :: VectorXd &q,
+                        const Eigen :: SparseMatrix<double> &A_eq, const Eigen :: VectorXd &b_eq,
+                        const Eigen :: SparseMatrix<double> &A_ineq, const Eigen :: VectorXd &b_ineq,
+                        const std :: vector<int> &dual_map){
+
+    int n = P.cols(), m_pen = A_pen.rows();
+    int m = A_eq.rows() + A_ineq.rows() + m_pen;
+
+    // @ l <= A x <= u with A = [A_eq; A_ineq; A_pen], the soft rows A_pen x <= b_pen last. The
+    // scaling of the previous solve is kept with its pattern, so it also applies to the new values
+    bool reuse = restack(P, A_eq, A_ineq);
+    if(reuse)
+        this->q = c * D.cwiseProduct(q);
+    else{
+        m_eq = A_eq.rows();
+        m_hard = m - m_pen;
+        std :: vector<Eigen :: Triplet<double>> triplets;
+        triplets.reserve(A_eq.nonZeros() + A_ineq.nonZeros() + A_pen.nonZeros());
+        for(int k = 0; k < A_eq.outerSize(); k++)
+            for(Eigen :: SparseMatrix<double> :: InnerIterator it(A_eq, k); it; ++it)
+                triplets.emplace_back(it.row(), it.col(), it.value());
+        for(int k = 0; k < A_ineq.outerSize(); k++)
+            for(Eigen :: SparseMatrix<double> :: InnerIterator it(A_ineq, k); it; ++it)
+                triplets.emplace_back(m_eq + it.row(), it.col(), it.value());
+        for(int k = 0; k < A_pen.outerSize(); k++)
+            for(Eigen :: SparseMatrix<double> :: InnerIterator it(A_pen, k); it; ++it)
+                triplets.emplace_back(m_hard + it.row(), it.col(), it.value());
+
+        this->A.resize(m, n);
+        this->A.setFromTriplets(triplets.begin(), triplets.end());
+        this->P = P;
+        this->P.makeCompressed();
+        this->q = q;
+        scale();
+    }
+    l = Eigen :: VectorXd(m);
+    u = Eigen :: VectorXd(m);
+    l << b_eq, Eigen :: VectorXd :: Constant(A_ineq.rows() + m_pen, -QP_INFTY);
+    u << b_eq, b_ineq, b_pen;
+    scaleBounds();
+
+    // @ Warm start from a converged previous solve, in the variables and rows the two have in common,
+    // otherwise from zero. Equality rows take a stiffer step so their multipliers settle quickly
+    x = Eigen :: VectorXd :: Zero(n);
+    y = Eigen :: VectorXd :: Zero(m);
+    if(status == 0){
+        int n_prev = std :: min<int>(n, x_out.size());
+        x.head(n_prev) = x_out.head(n_prev).cwiseQuotient(D.head(n_prev));
+        for(int i = 0; i < std :: min<int>(m_hard, dual_map.size()); i++)
+            if(dual_map[i] >= 0 && dual_map[i] < y_out.size())
+                y(i) = c * y_out(dual_map[i]) / E(i);
+    }
+    else
+        rho_ineq = settings.rho;
+    z = (this->A * x).cwiseMax(l).cwiseMin(u);
+    rho = Eigen :: VectorXd :: Constant(m, rho_ineq);
+    rho.head(m_eq) *= QP_RHO_EQ_FACTOR;
+
+    status = 1;
+    setup = false;
+    if(!factorize(!reuse)){
+        status = 2;
+        x_out = x;
+        return false;
+    }
+    setup = true;
+
+    Eigen :: VectorXd x_tilde, z_relax;
+    for(num_iter = 1; num_iter <= settings.max_iter; num_iter++){
+        // @ ADMM step
+        x_tilde = ldlt.solve(QP_SIGMA * x - this->q + this->A.transpose() * (rho.cwiseProduct(z) - y));
+        z_relax = QP_ALPHA * (this->A * x_tilde) + (1.0 - QP_ALPHA) * z;
+        x = QP_ALPHA * x_tilde + (1.0 - QP_ALPHA) * x;
+
+        project(z_relax + y.cwiseQuotient(rho));
+        y += rho.cwiseProduct(z_relax - z);
+
+        if(num_iter % QP_CHECK_EVERY != 0 && num_iter != settings.max_iter)
+            continue;
+
+        double res_prim, res_dual, tol_prim, tol_dual;
+        residuals(x, z, y, res_prim, res_dual, tol_prim, tol_dual);
+        if(res_prim <= tol_prim && res_dual <= tol_dual){
+            status = 0;
+            polish();
+            break;
+        }
+
+        // @ Step size adaptation, balances the relative primal and dual residuals of the scaled problem
+        Eigen :: VectorXd Ax = this->A * x, Px = this->P * x, Aty = this->A.transpose() * y;
+        double scaled_prim = normInf(Ax - z) / std :: max(std :: max(normInf(Ax), normInf(z)), 1e-10);
+        double scaled_dual = normInf(Px + this->q + Aty) / std :: max(std :: max(std :: max(normInf(Px), normInf(Aty)), normInf(this->q)), 1e-10);
+        double ratio = std :: sqrt(scaled_prim / std :: max(scaled_dual, 1e-10));
+        double rho_new = std :: min(std :: max(rho_ineq * ratio, QP_RHO_MIN), QP_RHO_MAX);
+        if(rho_new > 5.0 * rho_ineq || rho_new < 0.2 * rho_ineq){
+            rho *= rho_new / rho_ineq;
+            rho_ineq = rho_new;
+            if(!factorize(false)){
+                status = 2;
+                setup = false;
+                break;
+            }
+        }
+    }
+    num_iter = std :: min(num_iter, settings.max_iter);
+
+    x_out = D.cwiseProduct(x);
+    y_out = E.cwiseProduct(y) / c;
+    return status == 0;
+}
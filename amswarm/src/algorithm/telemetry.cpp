@@ -0,0 +1,64 @@
+#include "algorithm/amswarm/telemetry.hpp"
+
+void initTelemetry(telemetryRing &ring, int capacity)
+{
+    ring.records.assign(capacity, stepTelemetry());
+    ring.head = 0;
+    ring.count = 0;
+}
+
+void recordTelemetry(probData &prob_data)
+{
+    telemetryRing &ring = prob_data.telemetry;
+    if(ring.records.empty())
+        return;
+
+    // Timings were accumulated by the solver, the rest is the state it stopped in
+    stepTelemetry &rec = prob_data.step_telemetry;
+    rec.mpc_step = prob_data.mpc_step;
+    rec.num_iters = prob_data.num_iters;
+    rec.converged = prob_data.converged;
+
+    rec.res_static_obs = sqrt(pow(prob_data.res_x_static_obs_norm, 2) + pow(prob_data.res_y_static_obs_norm, 2));
+    rec.res_drone = sqrt(pow(prob_data.res_x_drone_norm, 2) + pow(prob_data.res_y_drone_norm, 2) + pow(prob_data.res_z_drone_norm, 2));
+    rec.res_vel = sqrt(pow(prob_data.res_x_vel_norm, 2) + pow(prob_data.res_y_vel_norm, 2) + pow(prob_data.res_z_vel_norm, 2));
+    rec.res_acc = sqrt(pow(prob_data.res_x_acc_norm, 2) + pow(prob_data.res_y_acc_norm, 2) + pow(prob_data.res_z_acc_norm, 2));
+    rec.res_jerk = sqrt(pow(prob_data.res_x_jerk_norm, 2) + pow(prob_data.res_y_jerk_norm, 2) + pow(prob_data.res_z_jerk_norm, 2));
+    rec.res_snap = sqrt(pow(prob_data.res_x_snap_norm, 2) + pow(prob_data.res_y_snap_norm, 2) + pow(prob_data.res_z_snap_norm, 2));
+    rec.res_ineq = sqrt(pow(prob_data.res_x_ineq_norm, 2) + pow(prob_data.res_y_ineq_norm, 2) + pow(prob_data.res_z_ineq_norm, 2));
+
+    rec.rho_static_obs = prob_data.rho_static_obs;
+    rec.rho_drone = prob_data.rho_drone;
+    rec.rho_vel = prob_data.rho_vel;
+    rec.rho_acc = prob_data.rho_acc;
+    rec.rho_jerk = prob_data.rho_jerk;
+    rec.rho_snap = prob_data.rho_snap;
+    rec.rho_ineq = prob_data.rho_ineq;
+
+    ring.records[ring.head] = rec;
+    ring.head = (ring.head + 1) % ring.records.size();
+    if(ring.count < ring.records.size())
+        ring.count++;
+}
+
+void writeTelemetryCSV(std :: ofstream &out, const telemetryRing &ring, int agent_id, bool header)
+{
+    if(header){
+        out << "agent,mpc_step,num_iters,converged,"
+            << "res_static_obs,res_drone,res_vel,res_acc,res_jerk,res_snap,res_ineq,"
+            << "rho_static_obs,rho_drone,rho_vel,rho_acc,rho_jerk,rho_snap,rho_ineq,"
+            << "time_polar,time_solve,time_residual,time_total\n";
+    }
+
+    // Oldest first
+    size_t start = (ring.head + ring.records.size() - ring.count) % std :: max(ring.records.size(), (size_t)1);
+    for(size_t k = 0; k < ring.count; k++){
+        const stepTelemetry &rec = ring.records[(start + k) % ring.records.size()];
+        out << agent_id << "," << rec.mpc_step << "," << rec.num_iters << "," << rec.converged << ","
+            << rec.res_static_obs << "," << rec.res_drone << "," << rec.res_vel << "," << rec.res_acc << ","
+            << rec.res_jerk << "," << rec.res_snap << "," << rec.res_ineq << ","
+            << rec.rho_static_obs << "," << rec.rho_drone << "," << rec.rho_vel << "," << rec.rho_acc << ","
+            << rec.rho_jerk << "," << rec.rho_snap << "," << rec.rho_ineq << ","
+            << rec.time_polar << "," << rec.time_solve << "," << rec.time_residual << "," << rec.time_total << "\n";
+    }
+}
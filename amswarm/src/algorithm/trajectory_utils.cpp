@@ -170,4 +170,228 @@ five_var computeBernstein(Eigen :: ArrayXXf tot_time, float t_fin, int num)
     five_var PPP;
     PPP = bernsteinCoeffOrder10(10.0, tot_time(0), t_fin, tot_time, num);
     return PPP;
+}
+void reserveWorkspace(probData &prob_data, int num_blocks)
+{
+    // Grows only, a steady-state MPC step finds everything already sized
+    amWorkspace &ws = prob_data.ws;
+    const basisCache &basis = *prob_data.basis;
+    
+    if(ws.lincost.rows() != prob_data.nvar || ws.res_vel.rows() != prob_data.num){
+        ws.objective_xy.resize(prob_data.nvar, prob_data.nvar);
+        ws.objective_z.resize(prob_data.nvar, prob_data.nvar);
+        ws.cost_drone.resize(prob_data.nvar, prob_data.nvar);
+        ws.cost_static_obs.resize(prob_data.nvar, prob_data.nvar);
+
+        ws.lincost.resize(prob_data.nvar, 3);
+        ws.sol.resize(prob_data.nvar, 3);
+        ws.b_eq.resize(basis.A_eq.rows(), 3);
+
+        ws.res_ineq.resize(basis.A_ineq.rows(), 3);
+        ws.ineq_tmp.resize(basis.A_ineq.rows(), 1);
+        ws.res_vel.resize(prob_data.num, 3);
+        ws.res_acc.resize(prob_data.num, 3);
+        ws.res_jerk.resize(prob_data.num, 3);
+        ws.res_snap.resize(prob_data.num, 3);
+        ws.res_box.resize(2*prob_data.num, 3);
+    }
+
+    if(num_blocks > ws.max_blocks || ws.temp_x.rows() != prob_data.num){
+        ws.max_blocks = std :: max(num_blocks, ws.max_blocks);
+        ws.temp_x.resize(prob_data.num, ws.max_blocks);
+        ws.temp_y.resize(prob_data.num, ws.max_blocks);
+        ws.temp_z.resize(prob_data.num, ws.max_blocks);
+    }
+}
+
+void initRepeatedBlock(repeatedBlock &A, const Eigen :: ArrayXXf &block, const Eigen :: MatrixXf &gram, int num_blocks)
+{
+    A.num_blocks = num_blocks;
+    A.block = &block;
+    A.gram = &gram;
+    A.block_sum.resize(block.rows());
+}
+Eigen :: ArrayXXf repeatedGram(const repeatedBlock &A)
+{
+    // [P; P; ...; P]^T [P; P; ...; P] = num_blocks * P^T P
+    return A.num_blocks * A.gram->array();
+}
+Eigen :: ArrayXXf repeatedTransposeTimes(repeatedBlock &A, const Eigen :: ArrayXXf &b)
+{
+    // b is the flattened (num_blocks*num) vector, column k of the map is the k-th block
+    Eigen :: Map<const Eigen :: MatrixXf> b_blocks(b.data(), A.block->rows(), A.num_blocks);
+    A.block_sum.noalias() = b_blocks.rowwise().sum();
+    return (A.block->matrix().transpose() * A.block_sum).array();
+}
+void subRepeatedTransposeTimes(repeatedBlock &A, float alpha, const Eigen :: Ref<const Eigen :: VectorXf> &b, Eigen :: Ref<Eigen :: MatrixXf> out)
+{
+    // out -= alpha * A^T b without temporaries, for the preallocated AM iterations
+    Eigen :: Map<const Eigen :: MatrixXf> b_blocks(b.data(), A.block->rows(), A.num_blocks);
+    A.block_sum.noalias() = b_blocks.rowwise().sum();
+    out.noalias() -= alpha * (A.block->matrix().transpose() * A.block_sum);
+}
+void buildGrid(spatialGrid &grid, const Eigen :: ArrayXXf &boxes, float cell)
+{
+    grid.boxes = boxes;
+    grid.nx = grid.ny = 0;
+    if(boxes.rows() == 0 || cell <= 0)
+        return;
+
+    // Cap the table at 1024 x 1024 cells, coarser cells for very large maps
+    grid.x_min = boxes.col(0).minCoeff();
+    grid.y_min = boxes.col(1).minCoeff();
+    float extent = std :: max(boxes.col(2).maxCoeff() - grid.x_min, boxes.col(3).maxCoeff() - grid.y_min);
+    grid.cell = std :: max(cell, extent / 1024);
+    grid.nx = (int)((boxes.col(2).maxCoeff() - grid.x_min) / grid.cell) + 1;
+    grid.ny = (int)((boxes.col(3).maxCoeff() - grid.y_min) / grid.cell) + 1;
+
+    // Counting sort of the items into the cells their boxes overlap
+    grid.cell_start.assign(grid.nx * grid.ny + 1, 0);
+    for(int pass = 0; pass < 2; pass++){
+        for(int i = 0; i < boxes.rows(); i++){
+            int cx_min = (int)((boxes(i, 0) - grid.x_min) / grid.cell), cx_max = std :: min((int)((boxes(i, 2) - grid.x_min) / grid.cell), grid.nx - 1);
+            int cy_min = (int)((boxes(i, 1) - grid.y_min) / grid.cell), cy_max = std :: min((int)((boxes(i, 3) - grid.y_min) / grid.cell), grid.ny - 1);
+            for(int cy = cy_min; cy <= cy_max; cy++)
+                for(int cx = cx_min; cx <= cx_max; cx++){
+                    if(pass == 0)
+                        grid.cell_start[cy * grid.nx + cx + 1]++;
+                    else
+                        grid.items[grid.cell_start[cy * grid.nx + cx]++] = i;
+                }
+        }
+        if(pass == 0){
+            for(int c = 0; c < grid.nx * grid.ny; c++)
+                grid.cell_start[c + 1] += grid.cell_start[c];
+            grid.items.resize(grid.cell_start.back());
+        }
+    }
+    // The fill pass advanced every start to the next cell's, shift back
+    for(int c = grid.nx * grid.ny; c > 0; c--)
+        grid.cell_start[c] = grid.cell_start[c - 1];
+    grid.cell_start[0] = 0;
+}
+void queryGrid(const spatialGrid &grid, float x_min, float y_min, float x_max, float y_max, std :: vector<int> &out)
+{
+    // Items whose box overlaps the query box, ascending and without duplicates
+    out.clear();
+    if(grid.nx == 0)
+        return;
+
+    int cx_min = std :: max((int)std :: floor((x_min - grid.x_min) / grid.cell), 0), cx_max = std :: min((int)std :: floor((x_max - grid.x_min) / grid.cell), grid.nx - 1);
+    int cy_min = std :: max((int)std :: floor((y_min - grid.y_min) / grid.cell), 0), cy_max = std :: min((int)std :: floor((y_max - grid.y_min) / grid.cell), grid.ny - 1);
+    for(int cy = cy_min; cy <= cy_max; cy++)
+        for(int cx = cx_min; cx <= cx_max; cx++)
+            for(int j = grid.cell_start[cy * grid.nx + cx]; j < grid.cell_start[cy * grid.nx + cx + 1]; j++){
+                int i = grid.items[j];
+                if(grid.boxes(i, 0) <= x_max && grid.boxes(i, 2) >= x_min && grid.boxes(i, 1) <= y_max && grid.boxes(i, 3) >= y_min)
+                    out.push_back(i);
+            }
+    std :: sort(out.begin(), out.end());
+    out.erase(std :: unique(out.begin(), out.end()), out.end());
+}
+static int buildBVHNode(obstacleBVH &bvh, int start, int count)
+{
+    bvhNode node;
+    node.x_min = node.y_min = std :: numeric_limits<float> :: max();
+    node.x_max = node.y_max = -std :: numeric_limits<float> :: max();
+    for(int j = start; j < start + count; j++){
+        int i = bvh.items[j];
+        node.x_min = std :: min(node.x_min, bvh.boxes(i, 0));
+        node.y_min = std :: min(node.y_min, bvh.boxes(i, 1));
+        node.x_max = std :: max(node.x_max, bvh.boxes(i, 2));
+        node.y_max = std :: max(node.y_max, bvh.boxes(i, 3));
+    }
+    node.left = node.right = -1;
+    node.start = start;
+    node.count = count;
+
+    int id = bvh.nodes.size();
+    bvh.nodes.push_back(node);
+    if(count <= 4)
+        return id;
+
+    // Median split of the box centres along the longer side
+    int axis = node.x_max - node.x_min >= node.y_max - node.y_min ? 0 : 1;
+    int half = count / 2;
+    std :: nth_element(bvh.items.begin() + start, bvh.items.begin() + start + half, bvh.items.begin() + start + count,
+                        [&](int a, int b){ return bvh.boxes(a, axis) + bvh.boxes(a, axis + 2) < bvh.boxes(b, axis) + bvh.boxes(b, axis + 2); });
+    int left = buildBVHNode(bvh, start, half);
+    int right = buildBVHNode(bvh, start + half, count - half);
+    bvh.nodes[id].left = left;
+    bvh.nodes[id].right = right;
+    return id;
+}
+void buildBVH(obstacleBVH &bvh, const Eigen :: ArrayXXf &boxes)
+{
+    bvh.boxes = boxes;
+    bvh.nodes.clear();
+    bvh.items.resize(boxes.rows());
+    for(int i = 0; i < boxes.rows(); i++)
+        bvh.items[i] = i;
+    if(boxes.rows() != 0)
+        buildBVHNode(bvh, 0, boxes.rows());
+}
+void queryBVH(const obstacleBVH &bvh, float x_min, float y_min, float x_max, float y_max, std :: vector<int> &out)
+{
+    // Items whose box overlaps the query box, ascending
+    out.clear();
+    if(bvh.nodes.empty())
+        return;
+
+    int stack[64], top = 0;
+    stack[top++] = 0;
+    while(top > 0){
+        const bvhNode &node = bvh.nodes[stack[--top]];
+        if(node.x_min > x_max || node.x_max < x_min || node.y_min > y_max || node.y_max < y_min)
+            continue;
+        if(node.left < 0){
+            for(int j = node.start; j < node.start + node.count; j++){
+                int i = bvh.items[j];
+                if(bvh.boxes(i, 0) <= x_max && bvh.boxes(i, 2) >= x_min && bvh.boxes(i, 1) <= y_max && bvh.boxes(i, 3) >= y_min)
+                    out.push_back(i);
+            }
+        }
+        else{
+            stack[top++] = node.left;
+            stack[top++] = node.right;
+        }
+    }
+    std :: sort(out.begin(), out.end());
+}
+void initBoard(trajectoryBoard &board, int num_agents, int num, float grid_cell)
+{
+    for(int i = 0; i < 2; i++){
+        board.x[i] = Eigen :: ArrayXXf :: Zero(num_agents, num);
+        board.y[i] = Eigen :: ArrayXXf :: Zero(num_agents, num);
+        board.z[i] = Eigen :: ArrayXXf :: Zero(num_agents, num);
+    }
+    board.grid_cell = grid_cell;
+    board.epoch = 0;
+}
+void publishTrajectory(trajectoryBoard &board, int id, const Eigen :: ArrayXXf &x, const Eigen :: ArrayXXf &y, const Eigen :: ArrayXXf &z)
+{
+    // One row per axis into the back buffer, readers of the front are unaffected
+    int back = 1 - boardFront(board);
+    board.x[back].row(id) = x.col(0).transpose();
+    board.y[back].row(id) = y.col(0).transpose();
+    board.z[back].row(id) = z.col(0).transpose();
+}
+void flipBoard(trajectoryBoard &board)
+{
+    board.epoch++;
+
+    // Swept xy box of every agent's horizon, indexed once per step for all agents' queries
+    int front = boardFront(board);
+    if(board.grid_cell > 0){
+        Eigen :: ArrayXXf boxes(board.x[front].rows(), 4);
+        boxes.col(0) = board.x[front].rowwise().minCoeff();
+        boxes.col(1) = board.y[front].rowwise().minCoeff();
+        boxes.col(2) = board.x[front].rowwise().maxCoeff();
+        boxes.col(3) = board.y[front].rowwise().maxCoeff();
+        buildGrid(board.grid[front], boxes, board.grid_cell);
+    }
+}
+int boardFront(const trajectoryBoard &board)
+{
+    return board.epoch & 1;
 }
\ No newline at end of file
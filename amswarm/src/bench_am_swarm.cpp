@@ -0,0 +1,272 @@
+#define _USE_MATH_DEFINES
+#include <cstdlib>
+#include <benchmark/benchmark.h>
+
+#include "algorithm/amswarm/run_trajectory_optimizer.hpp"
+
+/**
+ * Micro-benchmarks for the AM planner kernels, no ROS master or package path needed.
+ * Solver parameters, obstacle sizes and the start/goal of agent 0 come from the shipped
+ * config_am_swarm.yaml (AMSWARM_PARAMS_DIR, overridable through the environment); neighbours
+ * and obstacles are then synthesized around agent 0 so that all of them pass the proximity
+ * filters and the requested counts are the counts the solver actually sees.
+ *
+ * Run:  bench_am_swarm --benchmark_filter=computeXYZ --benchmark_repetitions=5
+ */
+
+#ifndef AMSWARM_PARAMS_DIR
+#define AMSWARM_PARAMS_DIR "params"
+#endif
+
+static YAML :: Node loadParams(int num, int num_obs, bool axis_wise)
+{
+    const char *dir = std :: getenv("AMSWARM_PARAMS_DIR");
+    YAML :: Node params = YAML :: LoadFile(std :: string(dir ? dir : AMSWARM_PARAMS_DIR) + "/config_am_swarm.yaml");
+
+    params["num"] = num;
+    params["free_space"] = num_obs == 0;
+    params["axis_wise"] = axis_wise;
+    params["verbose"] = 0;
+    params["telemetry_capacity"] = 0;
+    return params;
+}
+
+// @ Agent 0 of the loaded config with num_drone neighbours and num_obs obstacles, initialized as at MPC step 0
+static void initAgent(probData &prob_data, const YAML :: Node &params, int num_drone, int num_obs)
+{
+    std :: vector<std :: vector<float>> init_drone = params["init_drone"].as<std :: vector<std :: vector<float>>>();
+    std :: vector<std :: vector<float>> goal_drone = params["goal_drone"].as<std :: vector<std :: vector<float>>>();
+    std :: vector<std :: vector<float>> dim_static_obs = params["dim_static_obs"].as<std :: vector<std :: vector<float>>>();
+
+    prob_data.id_badge = 0;
+    prob_data.num_drone = num_drone;
+    prob_data.x_init = init_drone[0][0];
+    prob_data.y_init = init_drone[0][1];
+    prob_data.z_init = init_drone[0][2];
+
+    prob_data.x_goal = goal_drone[0][0];
+    prob_data.y_goal = goal_drone[0][1];
+    prob_data.z_goal = goal_drone[0][2];
+
+    // Obstacles on a half ring behind agent 0 (goal side left open), just outside their
+    // inflated footprint and inside prox_obs
+    float inflate = params["buffer"].as<float>() + params["a_drone"].as<float>() + 0.1;
+    float heading = atan2(prob_data.y_goal - prob_data.y_init, prob_data.x_goal - prob_data.x_init);
+    prob_data.pos_static_obs.clear();
+    prob_data.dim_static_obs.clear();
+    for(int i = 0; i < num_obs; i++){
+        std :: vector<float> dim = dim_static_obs[i % dim_static_obs.size()];
+        float theta = heading + M_PI_2 + M_PI * (i + 0.5) / num_obs;
+        float r = dim[0] + inflate;
+        prob_data.pos_static_obs.push_back({prob_data.x_init + r * (float)cos(theta), prob_data.y_init + r * (float)sin(theta), 0.0});
+        prob_data.dim_static_obs.push_back(dim);
+    }
+
+    prob_data.params = params;
+    prob_data.mpc_step = 0;
+    prob_data.use_model = false;
+    prob_data.mean = 0.0;
+    prob_data.stdev = 0.0;
+
+    initializeOptimizer(prob_data, 0);
+}
+
+static void initAgent(probData &prob_data, int num, int num_drone, int num_obs, bool axis_wise)
+{
+    initAgent(prob_data, loadParams(num, num_obs, axis_wise), num_drone, num_obs);
+}
+
+// @ Neighbour predictions, closing in from a unit ring to within prox_agent of agent 0's prediction
+static void shareAgents(probData &prob_data, trajectoryBoard &board, int num_drone)
+{
+    int num = prob_data.num;
+    float r_end = 2 * prob_data.lx_drone + 0.5 * prob_data.prox_agent;
+
+    initBoard(board, num_drone + 1, num, prob_data.params["grid_cell"].as<float>());
+    publishTrajectory(board, 0, prob_data.x, prob_data.y, prob_data.z);
+
+    Eigen :: ArrayXXf s = Eigen :: ArrayXf :: LinSpaced(num, 0.0, 1.0);
+    for(int i = 1; i <= num_drone; i++){
+        float theta = 2 * M_PI * i / num_drone;
+        float phi = 0.3 * sin(3 * theta);
+        Eigen :: ArrayXXf rad = 1.0 + (r_end - 1.0) * s;
+
+        publishTrajectory(board, i, prob_data.x + rad * cos(theta) * cos(phi),
+                                    prob_data.y + rad * sin(theta) * cos(phi),
+                                    prob_data.z + rad * sin(phi));
+    }
+    flipBoard(board);
+    prob_data.board = &board;
+    prob_data.board_epoch = board.epoch;
+}
+
+static void computeStep(probData &prob_data, int VERBOSE)
+{
+    if(prob_data.axis_wise)
+        computeXYZAxis(prob_data, VERBOSE);
+    else
+        computeXYZ(prob_data, VERBOSE);
+}
+
+// @ Agent 0 at MPC step 1: step 0 solved, neighbours and obstacles shared but not yet filtered
+static void initStep(probData &prob_data, trajectoryBoard &board, int num, int num_drone, int num_obs, bool axis_wise)
+{
+    initAgent(prob_data, num, num_drone, num_obs, axis_wise);
+    computeStep(prob_data, 0);
+
+    prob_data.mpc_step = 1;
+    shareAgents(prob_data, board, num_drone);
+}
+
+static void selectNeighbours(probData &prob_data)
+{
+    if(!prob_data.free_space)
+        initObstacles(prob_data, 0);
+    neigbhoringAgents(prob_data, 0);
+}
+
+
+// @ Kernels
+static void BM_bernsteinCoeffOrder10(benchmark :: State &state)
+{
+    int num = state.range(0);
+    Eigen :: ArrayXXf tot_time = Eigen :: ArrayXf :: LinSpaced(num, 0.0, 3.0);
+    for(auto _ : state){
+        five_var PPP = bernsteinCoeffOrder10(10.0, 0.0, 3.0, tot_time, num);
+        benchmark :: DoNotOptimize(PPP.a.data());
+    }
+}
+
+// Config loaded once, the basis comes from the cache entry that warm keeps alive
+static void BM_initializeOptimizer(benchmark :: State &state)
+{
+    int num = state.range(0), num_drone = state.range(1), num_obs = state.range(2);
+    YAML :: Node params = loadParams(num, num_obs, false);
+    probData warm;
+    initAgent(warm, params, num_drone, num_obs);
+
+    for(auto _ : state){
+        probData prob_data;
+        initAgent(prob_data, params, num_drone, num_obs);
+        benchmark :: DoNotOptimize(prob_data.basis.get());
+    }
+}
+
+// Bernstein bases and constant costs as built on a cache miss
+static void BM_computeBasis(benchmark :: State &state)
+{
+    int num = state.range(0);
+    probData prob_data;
+    initAgent(prob_data, num, 1, 0, false);
+    int order_smoothness = prob_data.params["order_smoothness"].as<int>();
+
+    for(auto _ : state){
+        basisCache basis;
+        computeBasis(basis, prob_data.num, prob_data.num_up, prob_data.t_plan, prob_data.kappa, order_smoothness, prob_data.axis_wise);
+        benchmark :: DoNotOptimize(basis.cost_smoothness.data());
+    }
+}
+
+static void BM_neigbhoringAgents(benchmark :: State &state)
+{
+    int num = state.range(0), num_drone = state.range(1);
+    probData prob_data;
+    trajectoryBoard board;
+    initStep(prob_data, board, num, num_drone, 0, false);
+
+    for(auto _ : state){
+        neigbhoringAgents(prob_data, 0);
+        benchmark :: DoNotOptimize(prob_data.x_drone.data());
+    }
+    state.counters["neighbours"] = prob_data.num_drone;
+}
+
+static void BM_initObstacles(benchmark :: State &state)
+{
+    int num = state.range(0), num_obs = state.range(1);
+    probData prob_data;
+    trajectoryBoard board;
+    initStep(prob_data, board, num, 0, num_obs, false);
+
+    for(auto _ : state){
+        initObstacles(prob_data, 0);
+        benchmark :: DoNotOptimize(prob_data.x_static_obs.data());
+    }
+    state.counters["obstacles"] = prob_data.num_static_obs;
+}
+
+static void BM_initAlphaBeta(benchmark :: State &state)
+{
+    int num = state.range(0), num_drone = state.range(1), num_obs = state.range(2);
+    probData prob_data;
+    trajectoryBoard board;
+    initStep(prob_data, board, num, num_drone, num_obs, false);
+    selectNeighbours(prob_data);
+
+    for(auto _ : state){
+        initAlphaBeta(prob_data, 0);
+        benchmark :: DoNotOptimize(prob_data.d_drone.data());
+    }
+    state.counters["neighbours"] = prob_data.num_drone;
+    state.counters["obstacles"] = prob_data.num_static_obs;
+}
+
+// Full MPC step solve, every repetition starts from the same state (copy excluded from the timing)
+static void benchComputeXYZ(benchmark :: State &state, bool axis_wise, bool fixed_basis = true)
+{
+    int num = state.range(0), num_drone = state.range(1), num_obs = state.range(2);
+    probData init_data;
+    trajectoryBoard board;
+    initStep(init_data, board, num, num_drone, num_obs, axis_wise);
+    selectNeighbours(init_data);
+    initAlphaBeta(init_data, 0);
+    init_data.fixed_basis = init_data.fixed_basis && fixed_basis;
+
+    probData prob_data;
+    int num_iters = 0;
+    for(auto _ : state){
+        state.PauseTiming();
+        prob_data = init_data;
+        state.ResumeTiming();
+
+        computeStep(prob_data, 0);
+        num_iters = prob_data.num_iters;
+    }
+    state.counters["neighbours"] = init_data.num_drone;
+    state.counters["obstacles"] = init_data.num_static_obs;
+    state.counters["iters"] = num_iters;
+}
+
+static void BM_computeXYZ(benchmark :: State &state)
+{
+    benchComputeXYZ(state, false);
+}
+
+// computeXYZ without the fixed-size specialization, at num 30 the baseline for BM_computeXYZ
+static void BM_computeXYZDynamic(benchmark :: State &state)
+{
+    benchComputeXYZ(state, false, false);
+}
+
+static void BM_computeXYZAxis(benchmark :: State &state)
+{
+    benchComputeXYZ(state, true);
+}
+
+
+// @ Parameter sweeps: num, neighbours (0-100), obstacles
+static const std :: vector<int64_t> nums = {20, 30, 50};
+static const std :: vector<int64_t> neighbours = {0, 10, 25, 50, 100};
+static const std :: vector<int64_t> obstacles = {0, 8, 16, 32};
+
+BENCHMARK(BM_bernsteinCoeffOrder10) -> ArgNames({"num"}) -> Arg(20) -> Arg(30) -> Arg(50) -> Arg(300);
+BENCHMARK(BM_computeBasis) -> ArgNames({"num"}) -> Arg(20) -> Arg(30) -> Arg(50) -> Unit(benchmark :: kMicrosecond);
+BENCHMARK(BM_initializeOptimizer) -> ArgNames({"num", "neighbours", "obstacles"}) -> ArgsProduct({nums, {1, 10, 100}, {0, 16}}) -> Unit(benchmark :: kMicrosecond);
+BENCHMARK(BM_neigbhoringAgents) -> ArgNames({"num", "neighbours"}) -> ArgsProduct({nums, neighbours}) -> Unit(benchmark :: kMicrosecond);
+BENCHMARK(BM_initObstacles) -> ArgNames({"num", "obstacles"}) -> ArgsProduct({nums, {8, 16, 32}}) -> Unit(benchmark :: kMicrosecond);
+BENCHMARK(BM_initAlphaBeta) -> ArgNames({"num", "neighbours", "obstacles"}) -> ArgsProduct({nums, neighbours, obstacles}) -> Unit(benchmark :: kMicrosecond);
+BENCHMARK(BM_computeXYZ) -> ArgNames({"num", "neighbours", "obstacles"}) -> ArgsProduct({nums, neighbours, obstacles}) -> Unit(benchmark :: kMillisecond);
+BENCHMARK(BM_computeXYZDynamic) -> ArgNames({"num", "neighbours", "obstacles"}) -> ArgsProduct({{30}, neighbours, obstacles}) -> Unit(benchmark :: kMillisecond);
+BENCHMARK(BM_computeXYZAxis) -> ArgNames({"num", "neighbours", "obstacles"}) -> ArgsProduct({nums, neighbours, obstacles}) -> Unit(benchmark :: kMillisecond);
+
+BENCHMARK_MAIN();
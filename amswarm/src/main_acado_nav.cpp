@@ -1,6 +1,9 @@
 #include <iostream>
 #include <fstream>
 #include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 #include <chrono>
 #include <vector>
 #include "yaml-cpp/yaml.h"
@@ -39,9 +42,8 @@ struct probData{
 
     float a_drone, b_drone, c_drone, buffer, slack_norm;
     float x_goal, y_goal, z_goal;
-    int max_iter, mpc_step, id_badge, num_drone, max_drone, state;
+    int max_iter, mpc_step, id_badge, num_drone, max_drone;
 
-    bool run;
     Eigen :: ArrayXXf agents_x, agents_y, agents_z; 
 
     std :: vector<float> smoothness, arc_length, inter_agent_dist, inter_agent_dist_min;
@@ -49,6 +51,56 @@ struct probData{
     YAML :: Node params;
 };
 
+/**
+ * Step barrier between the main loop and the agent threads. The ACADO workspace is
+ * thread local, so every agent keeps its own thread, and blocks here while idle
+ */
+struct stepSync{
+    std :: mutex mtx;
+    std :: condition_variable cv_agents, cv_main;
+    std :: atomic<int> num_done;
+    int num_agents = 0, epoch = 0;
+    bool run = true;
+
+    // Agent side: wait for the step after seen, false once the simulation is over
+    bool waitStep(int &seen){
+        std :: unique_lock<std :: mutex> lock(mtx);
+        cv_agents.wait(lock, [&]{ return !run || epoch != seen; });
+        seen = epoch;
+        return run;
+    }
+
+    void arrive(){
+        if(++num_done == num_agents){
+            std :: lock_guard<std :: mutex> lock(mtx);
+            cv_main.notify_one();
+        }
+    }
+
+    // Main side: start the next step on every agent, then wait for all of them
+    void release(){
+        {
+            std :: lock_guard<std :: mutex> lock(mtx);
+            num_done = 0;
+            epoch++;
+        }
+        cv_agents.notify_all();
+    }
+
+    void waitAll(){
+        std :: unique_lock<std :: mutex> lock(mtx);
+        cv_main.wait(lock, [&]{ return num_done == num_agents; });
+    }
+
+    void stop(){
+        {
+            std :: lock_guard<std :: mutex> lock(mtx);
+            run = false;
+        }
+        cv_agents.notify_all();
+    }
+};
+
 void distToAgents(probData &prob_data){
     prob_data.inter_agent_dist.clear();
 
@@ -120,7 +172,7 @@ void initOtherAgents(probData &prob_data){
         acadoVariables.od[i * NOD + (prob_data.max_drone-1)*6] = prob_data.gamma;
     }
 }
-int deployAgent(probData &prob_data){
+int deployAgent(probData &prob_data, stepSync &sync){
     
     YAML :: Node params = prob_data.params;
 
@@ -142,7 +194,6 @@ int deployAgent(probData &prob_data){
     prob_data.buffer = params["buffer"].as<float>();
 
     prob_data.gamma = params["gamma"].as<float>();
-    prob_data.run = true;
 
     acado_timer t;    
     acado_initializeSolver();
@@ -189,8 +240,10 @@ int deployAgent(probData &prob_data){
     
     
     
-    while(prob_data.run){
-        if(prob_data.state == 1){
+    int step = 0;
+    while(sync.waitStep(step)){
+        // @ Solve
+        {
             
             initOtherAgents(prob_data);
             distToAgents(prob_data);
@@ -238,12 +291,12 @@ int deployAgent(probData &prob_data){
             }
             prob_data.slack_norm = sqrt(slack_temp);
             
-            prob_data.state = 2;
             prob_data.max_iter = 1;
             prob_data.mpc_step++;
                         
         }
-        else if(prob_data.state == 2){
+        // @ Publish the new trajectory
+        {
             
             for(int i = 1; i < N+1; i++){
                 prob_data.agents_x(prob_data.id_badge, i-1) = acadoVariables.x[i*NX + 0];
@@ -253,12 +306,10 @@ int deployAgent(probData &prob_data){
             prob_data.agents_x(prob_data.id_badge, N) =  acadoVariables.x[N*NX + 0] - acadoVariables.x[(N-1)*NX + 0];
             prob_data.agents_y(prob_data.id_badge, N) =  acadoVariables.x[N*NX + 1] - acadoVariables.x[(N-1)*NX + 1];
             prob_data.agents_z(prob_data.id_badge, N) =  acadoVariables.x[N*NX + 2] - acadoVariables.x[(N-1)*NX + 2];
-            prob_data.state = 3;
-        }
-        else{
-            sleep(0.0001);
         }
+        sync.arrive();
     }
+    return 0;
 }
 
 int main( )
@@ -336,15 +387,13 @@ int main( )
 
         prob_data[i].params = params;
         prob_data[i].max_drone = max_drone;
-
-        prob_data[i].state = 1;        
     }
     
+    stepSync sync;
+    sync.num_agents = num_drone;
+    sync.num_done = 0;
     for(int i = 0; i < num_drone; i++)
-        agent_thread[i] = std :: thread(deployAgent, std::ref(prob_data[i]));
-        
-    for(int i = 0; i < num_drone; i++)
-        agent_thread[i].detach();
+        agent_thread[i] = std :: thread(deployAgent, std::ref(prob_data[i]), std::ref(sync));
 
     ROS_INFO_STREAM("Threads started");
     
@@ -359,17 +408,12 @@ int main( )
     
 
     save_data.open(path+"/data/sim_data_acado.txt");
+    sync.release();
     for(sim_iter = 0; sim_iter < max_time/dt;){
 
-        int state_sum  = 0;
-        for(int i = 0; i < num_drone; i++){
-            if(prob_data[i].state == 3)
-                state_sum += 1;
-            else
-                state_sum = 0;
-        }
-
-        if(state_sum == num_drone){
+        // Blocks until every agent has solved and published this step
+        sync.waitAll();
+        {
             
             mission_time = (sim_iter+1)*dt; 
             sim_iter++;
@@ -406,23 +450,18 @@ int main( )
             if((dist_to_goal.topRows(num_drone) < dist_stop).all())
                 break;
 
-            for(int i = 0; i < num_drone; i++)
-                prob_data[i].state = 1;
-
             save_data << (agents_x.leftCols(N)).topRows(num_drone) << "\n" << (agents_y.leftCols(N)).topRows(num_drone) << "\n" << (agents_z.leftCols(N)).topRows(num_drone) << "\n";
             t1 = std :: chrono :: high_resolution_clock::now();
-               
+            sync.release();
         }
-         sleep(0.00001);
     }
     end = std :: chrono :: high_resolution_clock::now();
     std :: chrono :: duration<double, std::milli> total_time = end - start;
     save_data.close();
 
-
-    for(int i = 0; i < num_drone; i++){
-        prob_data[i].run = false;
-    }
+    sync.stop();
+    for(int i = 0; i < num_drone; i++)
+        agent_thread[i].join();
 
     save_data.open(path+"/data/acado_cbf/sim_results_acado"+ std::to_string(num_drone)+".txt");
     std :: vector <float> smoothness_agent, traj_length_agent;
@@ -1,40 +1,137 @@
 #define _USE_MATH_DEFINES
 #include <iostream>
+#include <cstdio>
+#include <map>
+#include <set>
+#include <unistd.h>
 #include <ros/package.h>
 #include <ros/ros.h>
 
 #include "simulator/sim_am_swarm.hpp"
 
+struct scenarioResult
+{
+    int num_drone, config;
+    bool success;
+    float mission_time, comp_time, am_iters;
+};
+
+// @ Rows of an earlier (possibly interrupted) sweep, one per finished scenario
+static std :: vector<scenarioResult> loadResults(const std :: string &file_name, long &file_size)
+{
+    // file_size is set to the end of the last complete line, a row cut short by the interruption is
+    // dropped (it may still parse, with truncated numbers) so the resumed sweep rewrites it
+    std :: vector<scenarioResult> results;
+    std :: ifstream file(file_name);
+    std :: string line;
+    file_size = 0;
+    if(!std :: getline(file, line) || file.eof())
+        return results;
+    file_size = file.tellg();
+    while(std :: getline(file, line) && !file.eof()){
+        file_size = file.tellg();
+        scenarioResult res;
+        int success;
+        if(sscanf(line.c_str(), "%d,%d,%d,%f,%f,%f", &res.num_drone, &res.config, &success, &res.mission_time, &res.comp_time, &res.am_iters) == 6){
+            res.success = success;
+            results.push_back(res);
+        }
+    }
+    return results;
+}
+
 int main()
 {
     std :: string path = ros :: package::getPath("amswarm");
     YAML :: Node params = YAML :: LoadFile(path+"/params/config_sim_swarm.yaml");
 
-    int start_config = params["start_config"].as<int>(); 
-    int end_config = params["end_config"].as<int>(); 
+    int start_config = params["start_config"].as<int>();
+    int end_config = params["end_config"].as<int>();
     bool read_config = params["read_config"].as<bool>();
     bool use_model = params["use_model"].as<bool>();
     std :: vector<float> noise = params["noise"].as<std::vector<float>>();
     std :: vector<float> num_drones = params["num_drones"].as<std::vector<float>>();
+    int num_workers = params["num_workers"].as<int>();
+    bool resume = params["resume"].as<bool>();
 
-    for(int j = 0; j < num_drones.size(); j++){
-        if(read_config)
-            ROS_INFO_STREAM("Agent size = " << num_drones[j] << " Configuration numbers = " << end_config - start_config + 1);
+    // @ Scenarios (swarm size, config), a single one from config_am_swarm.yaml without read_config
+    std :: vector<std :: pair<int, int>> scenarios;
+    if(read_config){
+        for(int j = 0; j < num_drones.size(); j++)
+            for(int i = start_config; i < end_config; i++)
+                scenarios.push_back({(int)num_drones[j], i});
+    }
+    else
+        scenarios.push_back({(int)num_drones[0], start_config});
+
+    // @ Results table, resumed runs skip the scenarios it already lists
+    std :: string file_name = path + "/data/sweep_results_am.csv";
+    std :: vector<scenarioResult> results;
+    long file_size = 0;
+    if(read_config && resume)
+        results = loadResults(file_name, file_size);
+
+    std :: set<std :: pair<int, int>> done;
+    for(auto &res : results)
+        done.insert({res.num_drone, res.config});
+    std :: vector<std :: pair<int, int>> pending;
+    for(auto &scenario : scenarios)
+        if(!done.count(scenario))
+            pending.push_back(scenario);
+
+    std :: ofstream save_results;
+    if(read_config){
+        if(results.empty()){
+            save_results.open(file_name);
+            save_results << "num_drone,config,success,mission_time,comp_time,am_iters\n";
+        }
+        else{
+            if(truncate(file_name.c_str(), file_size) != 0)
+                ROS_WARN_STREAM("Could not drop the incomplete last row of " << file_name);
+            save_results.open(file_name, std :: ios :: app);
+        }
+    }
+    if(!results.empty())
+        ROS_INFO_STREAM("Resuming sweep, " << results.size() << " of " << scenarios.size() << " scenarios done");
+
+    // @ Independent scenarios on a bounded pool, with more than one worker the agents of a scenario are solved serially
+    std :: mutex mtx;
+    AgentPool workers(std :: max(1, num_workers), pending.size(), false);
+    workers.run(pending.size(), [&](int k){
+        Simulator sim(pending[k].second, read_config, pending[k].first, use_model, noise, workers.size() > 1 ? 1 : -1);
+        sim.runSimulation();
+        sim.saveMetrics();
+
+        scenarioResult res = {pending[k].first, pending[k].second, sim.success, sim.mission_time, sim.comp_time, sim.am_iters};
+        std :: lock_guard<std :: mutex> lock(mtx);
+        results.push_back(res);
+        if(read_config){
+            save_results << res.num_drone << "," << res.config << "," << res.success << ","
+                        << res.mission_time << "," << res.comp_time << "," << res.am_iters << std :: endl;
+        }
+    });
+
+    // @ Per swarm size: success rate, mission and compute time averaged over the successful scenarios
+    std :: map<int, std :: vector<scenarioResult>> sizes;
+    for(auto &res : results)
+        sizes[res.num_drone].push_back(res);
+    for(auto &size : sizes){
         int success_trials = 0;
-        for(int i = start_config; i < end_config; i++){
-            Simulator sim = Simulator(i, read_config, num_drones[j], use_model, noise);
-            sim.runSimulation();
-            sim.saveMetrics();
-
-            if(sim.success)
-                success_trials += 1;
-            if(!read_config)
-                break;
-            // ROS_INFO_STREAM("Success Trials = " << success_trials << " out of " << i+1);
+        float mission_time = 0.0, comp_time = 0.0;
+        for(auto &res : size.second){
+            if(!res.success)
+                continue;
+            success_trials++;
+            mission_time += res.mission_time;
+            comp_time += res.comp_time;
+        }
+        if(read_config)
+            ROS_INFO_STREAM("Agent size = " << size.first << " Configuration numbers = " << size.second.size());
+        ROS_INFO_STREAM("Success Trials = " << success_trials << " out of " << size.second.size());
+        if(success_trials != 0 && read_config){
+            ROS_INFO_STREAM("Average mission time = " << mission_time/success_trials << " s");
+            ROS_INFO_STREAM("Average compute time per agent = " << comp_time/success_trials << " s");
         }
-        ROS_INFO_STREAM("Success Trials = " << success_trials << " out of " << end_config);
-        if(!read_config)
-            break;
     }
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,99 @@
+#include "simulator/agent_pool.hpp"
+#include <algorithm>
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+AgentPool :: AgentPool(int num_threads, int max_tasks, bool pin_threads){
+    if(num_threads <= 0)
+        num_threads = std :: max(1u, std :: thread :: hardware_concurrency());
+    num_threads = std :: max(1, std :: min(num_threads, max_tasks));
+
+    step_task = nullptr;
+    step_size = 0;
+    num_done = 0;
+    num_active = 0;
+    epoch = 0;
+    stop = false;
+    next_task = 0;
+
+    for(int i = 0; i < num_threads; i++)
+        workers.push_back(std :: thread(&AgentPool :: work, this, i, pin_threads));
+}
+
+AgentPool :: ~AgentPool(){
+    {
+        std :: lock_guard<std :: mutex> lock(mtx);
+        stop = true;
+    }
+    cv_start.notify_all();
+    for(auto &worker : workers)
+        worker.join();
+}
+
+int AgentPool :: size() const{
+    return workers.size();
+}
+
+void AgentPool :: run(int num_tasks, const std :: function<void(int)> &task){
+    if(num_tasks <= 0)
+        return;
+    std :: unique_lock<std :: mutex> lock(mtx);
+    // A worker that woke late for the previous step may still be leaving the claim loop
+    cv_done.wait(lock, [&]{ return num_active == 0; });
+    step_task = &task;
+    step_size = num_tasks;
+    num_done = 0;
+    next_task = 0;
+    epoch++;
+    lock.unlock();
+    cv_start.notify_all();
+
+    // Barrier, every task done and no worker still inside the claim loop
+    lock.lock();
+    cv_done.wait(lock, [&]{ return num_done == step_size && num_active == 0; });
+    step_task = nullptr;
+}
+
+void AgentPool :: work(int id, bool pin_thread){
+#ifdef __linux__
+    if(pin_thread){
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(id % std :: max(1u, std :: thread :: hardware_concurrency()), &cpus);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpus);
+    }
+#endif
+
+    size_t seen = 0;
+    while(true){
+        const std :: function<void(int)> *task;
+        int num_tasks;
+        {
+            std :: unique_lock<std :: mutex> lock(mtx);
+            cv_start.wait(lock, [&]{ return stop || epoch != seen; });
+            if(stop)
+                return;
+            seen = epoch;
+            task = step_task;
+            num_tasks = step_size;
+            num_active++;
+        }
+
+        int done = 0;
+        for(int i = next_task++; i < num_tasks; i = next_task++){
+            (*task)(i);
+            done++;
+        }
+
+        bool finished;
+        {
+            std :: lock_guard<std :: mutex> lock(mtx);
+            num_done += done;
+            num_active--;
+            finished = num_active == 0;
+        }
+        if(finished)
+            cv_done.notify_one();
+    }
+}
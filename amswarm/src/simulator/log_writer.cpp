@@ -0,0 +1,73 @@
+#include "simulator/log_writer.hpp"
+#include <algorithm>
+#include <chrono>
+
+// Back-off of an idle writer or a producer waiting on a full ring
+static const std :: chrono :: microseconds LOG_WRITER_WAIT(200);
+
+LogWriter :: LogWriter(int frame_size, int queue_frames, bool block,
+                        const std :: function<void(const float*)> &write_frame, const std :: function<void()> &flush){
+    this->frame_size = frame_size;
+    this->capacity = std :: max(queue_frames, 1);
+    this->block = block;
+    this->write_frame = write_frame;
+    this->flush = flush;
+    ring.resize(capacity*frame_size);
+
+    head = 0;
+    tail = 0;
+    stop = false;
+    num_dropped = 0;
+    worker = std :: thread(&LogWriter :: work, this);
+}
+
+LogWriter :: ~LogWriter(){
+    close();
+}
+
+float *LogWriter :: acquire(){
+    size_t h = head.load(std :: memory_order_relaxed);
+    while(h - tail.load(std :: memory_order_acquire) == capacity){
+        if(!block){
+            num_dropped++;
+            return nullptr;
+        }
+        std :: this_thread :: sleep_for(LOG_WRITER_WAIT);
+    }
+    return ring.data() + (h % capacity)*frame_size;
+}
+
+void LogWriter :: publish(){
+    head.store(head.load(std :: memory_order_relaxed) + 1, std :: memory_order_release);
+}
+
+void LogWriter :: close(){
+    if(!worker.joinable())
+        return;
+    stop.store(true, std :: memory_order_release);
+    worker.join();
+}
+
+size_t LogWriter :: dropped() const{
+    return num_dropped;
+}
+
+void LogWriter :: work(){
+    size_t t = tail.load(std :: memory_order_relaxed);
+    while(true){
+        // stop is read before head, so frames published before close() are always drained
+        bool stopping = stop.load(std :: memory_order_acquire);
+        size_t h = head.load(std :: memory_order_acquire);
+        if(h == t){
+            if(stopping)
+                break;
+            std :: this_thread :: sleep_for(LOG_WRITER_WAIT);
+            continue;
+        }
+        for(; t != h; t++){
+            write_frame(ring.data() + (t % capacity)*frame_size);
+            tail.store(t + 1, std :: memory_order_release);
+        }
+        flush();
+    }
+}
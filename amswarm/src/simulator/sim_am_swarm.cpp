@@ -4,7 +4,7 @@
 #include <ros/ros.h>
 
 
-Simulator :: Simulator(int cf_num, bool read_cf, int num_drones, bool use_model, std::vector<float> noise){
+Simulator :: Simulator(int cf_num, bool read_cf, int num_drones, bool use_model, std::vector<float> noise, int pool_size){
 
     path = ros :: package::getPath("amswarm");
     params = YAML :: LoadFile(path+"/params/config_am_swarm.yaml");
@@ -33,15 +33,32 @@ Simulator :: Simulator(int cf_num, bool read_cf, int num_drones, bool use_model,
     dt = t_plan/num;
 
     success = false;
+    mission_time = 0.0;
+    comp_time = 0.0;
+    am_iters = 0.0;
     collision_agent = false;
     collision_obstacle = false;
 
-    prob_data = new probData[num_drone];
+    prob_data.reset(new probData[num_drone]);
+
+    // Persistent workers for the agent solves, no more than one per agent
+    if(pool_size < 0)
+        pool_size = params["pool_size"].as<int>();
+    pool.reset(new AgentPool(pool_size, num_drone, params["pin_threads"].as<bool>()));
     
 
-    agents_x = Eigen :: ArrayXXf(num_drone, num); 
-    agents_y = Eigen :: ArrayXXf(num_drone, num); 
-    agents_z = Eigen :: ArrayXXf(num_drone, num);
+    // Trajectory log format, shared with the other simulation settings
+    YAML :: Node sim_params = YAML :: LoadFile(path+"/params/config_sim_swarm.yaml");
+    binary_log = sim_params["log_format"].as<std :: string>() == "binary";
+    log_chunk_frames = sim_params["log_chunk_frames"].as<int>();
+    if(!binary_log && sim_params["log_format"].as<std :: string>() != "text")
+        ROS_WARN_STREAM("Unknown log_format " << sim_params["log_format"].as<std :: string>() << ", writing text");
+    log_async = sim_params["log_async"].as<bool>();
+    log_queue_frames = sim_params["log_queue_frames"].as<int>();
+    log_block = sim_params["log_queue_full"].as<std :: string>() != "drop";
+
+    board.reset(new trajectoryBoard);
+    initBoard(*board, num_drone, num, params["grid_cell"].as<float>());
 
     smoothness = Eigen :: ArrayXf(num_drone);
     arc_length = Eigen :: ArrayXf(num_drone);
@@ -154,33 +171,25 @@ Simulator :: Simulator(int cf_num, bool read_cf, int num_drones, bool use_model,
 }
 
 void Simulator :: shareInformation(){
-    // Update common variable
-    for(int i = 0; i < num_drone; i++){
-        if(sim_iter == 0){
-            agents_x.row(i) = Eigen :: ArrayXXf :: Ones(1, num) * _init_drone[i][0];
-            agents_y.row(i) = Eigen :: ArrayXXf :: Ones(1, num) * _init_drone[i][1];
-            agents_z.row(i) = Eigen :: ArrayXXf :: Ones(1, num) * _init_drone[i][2];
-        }
-        else{
-            agents_x.row(i) = prob_data[i].x.transpose();
-            agents_y.row(i) = prob_data[i].y.transpose();
-            agents_z.row(i) = prob_data[i].z.transpose();
-        }
-    }
-
-    // Share information
+    // Publish every agent's trajectory to the board, agents read it in place
     for(int i = 0; i < num_drone; i++){
-        prob_data[i].agents_x = Eigen :: ArrayXXf(num_drone, num);
-        prob_data[i].agents_y = Eigen :: ArrayXXf(num_drone, num);
-        prob_data[i].agents_z = Eigen :: ArrayXXf(num_drone, num);
-
-        prob_data[i].agents_x = agents_x;
-        prob_data[i].agents_y = agents_y;
-        prob_data[i].agents_z = agents_z;
+        if(sim_iter == 0)
+            publishTrajectory(*board, i, Eigen :: ArrayXXf :: Ones(num, 1) * _init_drone[i][0], 
+                                        Eigen :: ArrayXXf :: Ones(num, 1) * _init_drone[i][1], 
+                                        Eigen :: ArrayXXf :: Ones(num, 1) * _init_drone[i][2]);
+        else
+            publishTrajectory(*board, i, prob_data[i].x, prob_data[i].y, prob_data[i].z);
+        
+        prob_data[i].board = board.get();
     }
+    flipBoard(*board);
 }
 
 void Simulator :: checkCollision(){
+    const Eigen :: ArrayXXf &agents_x = board->x[boardFront(*board)];
+    const Eigen :: ArrayXXf &agents_y = board->y[boardFront(*board)];
+    const Eigen :: ArrayXXf &agents_z = board->z[boardFront(*board)];
+
     // Collision check
     for(int i = 0; i < num_drone; i++){
         Eigen :: ArrayXf coll;
@@ -226,24 +235,27 @@ void Simulator :: checkAtGoal(){
 
 void Simulator :: runAlgorithm(){
 
-    std :: thread agent_thread[num_drone];
-
-    // Start Threads
+    // One task per agent on the persistent pool, returns once every agent has solved this step
     auto start = std :: chrono :: high_resolution_clock::now(); 
-    for(int i = 0; i < num_drone; i++){
-        agent_thread[i] = std :: thread(deployAgent, std::ref(prob_data[i]), VERBOSE);
-    }
-
-    // Waiting for threads to terminate
-    for(int i = 0; i < num_drone; i++)
-        agent_thread[i].join();
+    pool->run(num_drone, [&](int i){ deployAgent(prob_data[i], VERBOSE); });
     auto end = std :: chrono :: high_resolution_clock::now();
     std :: chrono :: duration<double, std::milli> total_time = end - start;
     
     comp_time_agent.push_back(total_time.count()/1000.0/num_drone);
 
-    if(VERBOSE == 4)
+    float num_iters = 0.0;
+    for(int i = 0; i < num_drone; i++) num_iters += prob_data[i].num_iters;
+    iter_agent.push_back(num_iters/num_drone);
+
+    if(VERBOSE == 4){
         ROS_INFO_STREAM("Time to compute = " << total_time.count()/1000.0 << " s, Planning Frequency = " << 1000.0/total_time.count());
+        ROS_INFO_STREAM("AM iterations per agent = " << iter_agent.back());
+        if(allocCountEnabled()){
+            size_t num_allocs = 0;
+            for(int i = 0; i < num_drone; i++) num_allocs += prob_data[i].num_allocs;
+            ROS_INFO_STREAM("Heap allocations in the optimizer = " << num_allocs);
+        }
+    }
 }
 
 void Simulator :: checkViolation(){
@@ -300,22 +312,7 @@ void Simulator :: checkViolation(){
 
 void Simulator :: runSimulation(){
     
-    if(read_config){
-        if(params["axis_wise"].as<bool>()){
-            save_data.open(path+"/data/point_to_point/config_data/varying_agents/obs_" + std::to_string(num_obs) +"/results_am_ax"+folder_name.str()+"/sim_data_drone_" +std :: to_string(num_drone)+"_config_"+std :: to_string(config_num)+".txt");
-            save_data_2.open(path+"/data/point_to_point/config_data/varying_agents/obs_" + std::to_string(num_obs) +"/results_am_ax"+folder_name.str()+"/sim_residue_drone_" +std :: to_string(num_drone)+"_config_"+std :: to_string(config_num)+".txt");       
-            }
-        else{
-            save_data.open(path+"/data/point_to_point/config_data/varying_agents/obs_" + std::to_string(num_obs) +"/results_am_qd"+folder_name.str()+"/sim_data_drone_" +std :: to_string(num_drone)+"_config_"+std :: to_string(config_num)+".txt");
-            save_data_2.open(path+"/data/point_to_point/config_data/varying_agents/obs_" + std::to_string(num_obs) +"/results_am_qd"+folder_name.str()+"/sim_residue_drone_" +std :: to_string(num_drone)+"_config_"+std :: to_string(config_num)+".txt");
-        }
-    }
-    else{
-        save_data.open(path+"/data/sim_data.txt");
-        save_data_2.open(path+"/data/sim_data_upsampled_x.txt");
-        save_data_3.open(path+"/data/sim_data_upsampled_y.txt");
-        save_data_4.open(path+"/data/sim_data_upsampled_z.txt");
-    }
+    Simulator :: openLogs();
     auto start = std :: chrono :: high_resolution_clock::now();            
     
     for(sim_iter = 0; sim_iter < max_time/dt; sim_iter++){
@@ -329,33 +326,7 @@ void Simulator :: runSimulation(){
         Simulator :: checkAtGoal();
         Simulator :: calculateDistances();
         mission_time = (sim_iter+1)*dt; 
-        save_data << agents_x << "\n" << agents_y << "\n" << agents_z << "\n";
-        
-        Eigen :: ArrayXXf temp_x_upsampled((int)(num_up/num), num_drone), 
-                          temp_y_upsampled((int)(num_up/num), num_drone), 
-                          temp_z_upsampled((int)(num_up/num), num_drone),
-                          temp_vx_upsampled((int)(num_up/num), num_drone), 
-                          temp_vy_upsampled((int)(num_up/num), num_drone), 
-                          temp_vz_upsampled((int)(num_up/num), num_drone),
-                          temp_ax_upsampled((int)(num_up/num), num_drone), 
-                          temp_ay_upsampled((int)(num_up/num), num_drone), 
-                          temp_az_upsampled((int)(num_up/num), num_drone);
-        for(int i = 0; i < num_drone; i++){
-            temp_x_upsampled.col(i) = prob_data[i].x_up.topRows((int)(num_up/num));
-            temp_y_upsampled.col(i) = prob_data[i].y_up.topRows((int)(num_up/num));
-            temp_z_upsampled.col(i) = prob_data[i].z_up.topRows((int)(num_up/num));
-
-            temp_vx_upsampled.col(i) = prob_data[i].xdot_up.topRows((int)(num_up/num));
-            temp_vy_upsampled.col(i) = prob_data[i].ydot_up.topRows((int)(num_up/num));
-            temp_vz_upsampled.col(i) = prob_data[i].zdot_up.topRows((int)(num_up/num));
-
-            temp_ax_upsampled.col(i) = prob_data[i].xddot_up.topRows((int)(num_up/num));
-            temp_ay_upsampled.col(i) = prob_data[i].yddot_up.topRows((int)(num_up/num));
-            temp_az_upsampled.col(i) = prob_data[i].zddot_up.topRows((int)(num_up/num));
-        }
-        save_data_2 << temp_x_upsampled.transpose() << "\n" << temp_vx_upsampled.transpose() << "\n" << temp_ax_upsampled.transpose() << "\n"; 
-        save_data_3 << temp_y_upsampled.transpose() << "\n" << temp_vy_upsampled.transpose() << "\n" << temp_ay_upsampled.transpose() << "\n";
-        save_data_4 << temp_z_upsampled.transpose() << "\n" << temp_vz_upsampled.transpose() << "\n" << temp_az_upsampled.transpose() << "\n";
+        Simulator :: logStep();
 
         // for(int i = 0; i < num_drone; i++){
         //     save_data_2 << prob_data[i].res_x_static_obs_norm << " " << prob_data[i].res_y_static_obs_norm 
@@ -380,10 +351,144 @@ void Simulator :: runSimulation(){
     }
     auto end = std :: chrono :: high_resolution_clock::now();
     total_time = end - start;
+    comp_time = std :: accumulate(comp_time_agent.begin(), comp_time_agent.end(), 0.0)/std :: max<size_t>(comp_time_agent.size(), 1);
+    am_iters = std :: accumulate(iter_agent.begin(), iter_agent.end(), 0.0)/std :: max<size_t>(iter_agent.size(), 1);
+    Simulator :: closeLogs();
+
+    Simulator :: saveTelemetry();
+}
+void Simulator :: openLogs(){
+    if(binary_log){
+        std :: string file_name;
+        if(read_config)
+            file_name = path+"/data/point_to_point/config_data/varying_agents/obs_" + std::to_string(num_obs) +(params["axis_wise"].as<bool>() ? "/results_am_ax" : "/results_am_qd")+folder_name.str()+"/sim_data_drone_" +std :: to_string(num_drone)+"_config_"+std :: to_string(config_num)+".bin";
+        else
+            file_name = path+"/data/sim_data.bin";
+
+        trajLogInfo info = {num_drone, num, num_up, (int)(num_up/num), num_obs, dt, a_drone, b_drone, c_drone,
+                            _init_drone, _goal_drone, _pos_static_obs, _dim_static_obs};
+        traj_log.reset(new TrajectoryLog(file_name, info, log_chunk_frames));
+    }
+    else if(read_config){
+        if(params["axis_wise"].as<bool>()){
+            save_data.open(path+"/data/point_to_point/config_data/varying_agents/obs_" + std::to_string(num_obs) +"/results_am_ax"+folder_name.str()+"/sim_data_drone_" +std :: to_string(num_drone)+"_config_"+std :: to_string(config_num)+".txt");
+            save_data_2.open(path+"/data/point_to_point/config_data/varying_agents/obs_" + std::to_string(num_obs) +"/results_am_ax"+folder_name.str()+"/sim_residue_drone_" +std :: to_string(num_drone)+"_config_"+std :: to_string(config_num)+".txt");       
+            save_steps.open(path+"/data/point_to_point/config_data/varying_agents/obs_" + std::to_string(num_obs) +"/results_am_ax"+folder_name.str()+"/sim_steps_drone_" +std :: to_string(num_drone)+"_config_"+std :: to_string(config_num)+".txt");
+            }
+        else{
+            save_data.open(path+"/data/point_to_point/config_data/varying_agents/obs_" + std::to_string(num_obs) +"/results_am_qd"+folder_name.str()+"/sim_data_drone_" +std :: to_string(num_drone)+"_config_"+std :: to_string(config_num)+".txt");
+            save_data_2.open(path+"/data/point_to_point/config_data/varying_agents/obs_" + std::to_string(num_obs) +"/results_am_qd"+folder_name.str()+"/sim_residue_drone_" +std :: to_string(num_drone)+"_config_"+std :: to_string(config_num)+".txt");
+            save_steps.open(path+"/data/point_to_point/config_data/varying_agents/obs_" + std::to_string(num_obs) +"/results_am_qd"+folder_name.str()+"/sim_steps_drone_" +std :: to_string(num_drone)+"_config_"+std :: to_string(config_num)+".txt");
+        }
+    }
+    else{
+        save_data.open(path+"/data/sim_data.txt");
+        save_data_2.open(path+"/data/sim_data_upsampled_x.txt");
+        save_data_3.open(path+"/data/sim_data_upsampled_y.txt");
+        save_data_4.open(path+"/data/sim_data_upsampled_z.txt");
+        save_steps.open(path+"/data/sim_steps.txt");
+    }
+
+    int frame_size = 1 + 3*num_drone*num + 9*num_drone*(int)(num_up/num);
+    if(log_async)
+        log_writer.reset(new LogWriter(frame_size, log_queue_frames, log_block,
+                                        [this](const float *frame){ writeFrame(frame); }, [this](){ flushLogs(); }));
+    else
+        log_frame.resize(frame_size);
+}
+
+void Simulator :: closeLogs(){
+    if(log_writer){
+        log_writer->close();
+        if(log_writer->dropped() > 0)
+            ROS_WARN_STREAM("Log queue full, " << log_writer->dropped() << " MPC steps were not written");
+        log_writer.reset();
+    }
     save_data.close();
     save_data_2.close();
     save_data_3.close();
     save_data_4.close();
+    save_steps.close();
+    if(traj_log)
+        traj_log->close();
+}
+
+void Simulator :: logStep(){
+    if(!log_writer){
+        packFrame(log_frame.data());
+        writeFrame(log_frame.data());
+        return;
+    }
+    float *frame = log_writer->acquire();
+    if(frame == nullptr)
+        return;
+    packFrame(frame);
+    log_writer->publish();
+}
+
+void Simulator :: packFrame(float *frame){
+    // MPC step index, board trajectories, then the upsampled commands as [axis][pos, vel, acc][agent], one row per agent as in the text dumps
+    typedef Eigen :: Array<float, Eigen :: Dynamic, Eigen :: Dynamic, Eigen :: RowMajor> rowArray;
+    int up_steps = (int)(num_up/num);
+    *frame++ = sim_iter;
+    Eigen :: Map<rowArray>(frame, num_drone, num) = board->x[boardFront(*board)];
+    Eigen :: Map<rowArray>(frame + num_drone*num, num_drone, num) = board->y[boardFront(*board)];
+    Eigen :: Map<rowArray>(frame + 2*num_drone*num, num_drone, num) = board->z[boardFront(*board)];
+
+    float *frame_up = frame + 3*num_drone*num;
+    for(int i = 0; i < num_drone; i++){
+        const Eigen :: ArrayXXf *up[9] = {&prob_data[i].x_up, &prob_data[i].xdot_up, &prob_data[i].xddot_up,
+                                        &prob_data[i].y_up, &prob_data[i].ydot_up, &prob_data[i].yddot_up,
+                                        &prob_data[i].z_up, &prob_data[i].zdot_up, &prob_data[i].zddot_up};
+        for(int k = 0; k < 9; k++)
+            Eigen :: Map<Eigen :: ArrayXf>(frame_up + (k*num_drone + i)*up_steps, up_steps) = up[k]->topRows(up_steps);
+    }
+}
+
+void Simulator :: writeFrame(const float *frame){
+    if(traj_log){
+        traj_log->writeFrame(frame);
+        return;
+    }
+
+    typedef Eigen :: Map<const Eigen :: Array<float, Eigen :: Dynamic, Eigen :: Dynamic, Eigen :: RowMajor>> rowMap;
+    int up_steps = (int)(num_up/num), board_size = num_drone*num, up_size = num_drone*up_steps;
+    save_steps << (int)*frame++ << "\n";
+    const float *frame_up = frame + 3*board_size;
+    save_data << rowMap(frame, num_drone, num) << "\n" << rowMap(frame + board_size, num_drone, num) << "\n" << rowMap(frame + 2*board_size, num_drone, num) << "\n";
+
+    save_data_2 << rowMap(frame_up, num_drone, up_steps) << "\n" << rowMap(frame_up + up_size, num_drone, up_steps) << "\n" << rowMap(frame_up + 2*up_size, num_drone, up_steps) << "\n"; 
+    save_data_3 << rowMap(frame_up + 3*up_size, num_drone, up_steps) << "\n" << rowMap(frame_up + 4*up_size, num_drone, up_steps) << "\n" << rowMap(frame_up + 5*up_size, num_drone, up_steps) << "\n";
+    save_data_4 << rowMap(frame_up + 6*up_size, num_drone, up_steps) << "\n" << rowMap(frame_up + 7*up_size, num_drone, up_steps) << "\n" << rowMap(frame_up + 8*up_size, num_drone, up_steps) << "\n";
+}
+
+void Simulator :: flushLogs(){
+    if(traj_log)
+        traj_log->flush();
+    else{
+        save_data.flush();
+        save_data_2.flush();
+        save_data_3.flush();
+        save_data_4.flush();
+        save_steps.flush();
+    }
+}
+void Simulator :: saveTelemetry(){
+    if(prob_data[0].telemetry.records.empty())
+        return;
+
+    if(read_config){
+        if(prob_data[0].axis_wise)
+            save_data.open(path+"/data/point_to_point/config_data/varying_agents/obs_" + std::to_string(num_obs) +"/results_am_ax"+folder_name.str()+"/sim_telemetry_drone_" +std :: to_string(num_drone)+"_config_"+std :: to_string(config_num)+".csv");
+        else
+            save_data.open(path+"/data/point_to_point/config_data/varying_agents/obs_" + std::to_string(num_obs) +"/results_am_qd"+folder_name.str()+"/sim_telemetry_drone_" +std :: to_string(num_drone)+"_config_"+std :: to_string(config_num)+".csv");
+    }
+    else
+        save_data.open(path+"/data/telemetry.csv");
+
+    for(int i = 0; i < num_drone; i++)
+        writeTelemetryCSV(save_data, prob_data[i].telemetry, i, i == 0);
+    save_data.close();
 }
 void Simulator :: calculateDistances(){
     std :: vector <float> temp_inter_agent, temp_agent_obs;
@@ -395,9 +500,9 @@ void Simulator :: calculateDistances(){
         }
 
         for(int j = 0; j < prob_data[0].x_static_obs_og.rows(); j++){
-            temp_agent_obs.push_back(sqrt(pow(prob_data[i].x_init - prob_data[i].x_static_obs_og(j, 0), 2) 
-                                            + pow(prob_data[i].y_init - prob_data[i].y_static_obs_og(j, 0), 2)) 
-                                            - prob_data[i].a_static_obs_og(j, 0) 
+            temp_agent_obs.push_back(sqrt(pow(prob_data[i].x_init - prob_data[i].x_static_obs_og(j), 2) 
+                                            + pow(prob_data[i].y_init - prob_data[i].y_static_obs_og(j), 2)) 
+                                            - prob_data[i].a_static_obs_og(j) 
                                             + prob_data[i].lx_drone + prob_data[i].buffer);
         }
     }
@@ -488,6 +593,7 @@ void Simulator :: saveMetrics(){
         ROS_INFO_STREAM("Total time to compute = " << total_time.count()/1000.0 << " s");
         ROS_INFO_STREAM("Average time to compute = " << total_time.count()/1000.0/prob_data[0].mpc_step << " s");
         ROS_INFO_STREAM("Average run time per agent = " << total_time.count()/1000.0/prob_data[0].mpc_step/num_drone << " s");
+        ROS_INFO_STREAM("Average AM iterations per agent = " << std :: accumulate(iter_agent.begin(), iter_agent.end(), 0.0)/iter_agent.size());
         ROS_INFO_STREAM("Average smoothness = " << avg_smoothness << " ms^-2");
         ROS_INFO_STREAM("Average trajectory length = " << avg_traj_length << " m");
         ROS_INFO_STREAM("Average inter-agent dist = " << avg_inter_agent_dist << " m");
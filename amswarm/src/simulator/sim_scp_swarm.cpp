@@ -34,7 +34,10 @@ Simulator :: Simulator(int cf_num, bool read_cf, int num_drones, bool use_model,
     collision_agent = false;
     collision_obstacle = false;
 
-    prob_data = new probData[num_drone];
+    prob_data.reset(new probData[num_drone]);
+
+    // Persistent workers for the agent solves, no more than one per agent
+    pool.reset(new AgentPool(params["pool_size"].as<int>(), num_drone, params["pin_threads"].as<bool>()));
     
 
     agents_x = Eigen :: ArrayXXf(num_drone, num); 
@@ -214,18 +217,9 @@ void Simulator :: checkAtGoal(){
 
 void Simulator :: runAlgorithm(){
 
-    std :: thread agent_thread[num_drone];
-
-    // Start Threads 
+    // One task per agent on the persistent pool, returns once every agent has solved this step
     auto start = std :: chrono :: high_resolution_clock::now(); 
-    for(int i = 0; i < num_drone; i++){
-        // start thread for each agent, depolyAgent is the function, std::ref is the parameter
-        agent_thread[i] = std :: thread(deployAgent, std::ref(prob_data[i]), VERBOSE);
-    }
-
-    // Waiting for threads to terminate
-    for(int i = 0; i < num_drone; i++)
-        agent_thread[i].join();
+    pool->run(num_drone, [&](int i){ deployAgent(prob_data[i], VERBOSE); });
     auto end = std :: chrono :: high_resolution_clock::now();
     std :: chrono :: duration<double, std::milli> total_time = end - start;
     
@@ -313,6 +307,19 @@ void Simulator :: runSimulation(){
     }
     else
         save_data.open(path+"/data/sim_data.txt");
+    
+    // Row "sim_iter agent changes..." per MPC step and agent, one entry per QP solve of the step
+    bool log_qp = params["solver"].as<std::string>() == "qpoases";
+    if(log_qp){
+        if(read_config){
+            if(params["on_demand"].as<bool>())
+                save_qp.open(path+"/data/point_to_point/config_data/varying_agents/obs_" + std::to_string(num_obs) +"/results_on/sim_qp_changes_drone_" +std :: to_string(num_drone)+"_config_"+std :: to_string(config_num)+".txt");
+            else
+                save_qp.open(path+"/data/point_to_point/config_data/varying_agents/obs_" + std::to_string(num_obs) +"/results_ca/sim_qp_changes_drone_" +std :: to_string(num_drone)+"_config_"+std :: to_string(config_num)+".txt");
+        }
+        else
+            save_qp.open(path+"/data/sim_qp_changes.txt");
+    }
     auto start = std :: chrono :: high_resolution_clock::now();            
     
     for(sim_iter = 0; sim_iter < max_time/dt; sim_iter++){
@@ -327,6 +334,15 @@ void Simulator :: runSimulation(){
 
         mission_time = (sim_iter+1)*dt; 
         save_data << agents_x << "\n" << agents_y << "\n" << agents_z << "\n";
+        if(log_qp){
+            for(int i = 0; i < num_drone; i++){
+                const std :: vector<int> &changes = prob_data[i].qp_changes;
+                save_qp << sim_iter << " " << i;
+                for(size_t k = changes.size() - prob_data[i].scp_iters.back(); k < changes.size(); k++)
+                    save_qp << " " << changes[k];
+                save_qp << "\n";
+            }
+        }
         
         if(VERBOSE == 2){
             ROS_INFO_STREAM("Simulation time = " << sim_iter);
@@ -356,6 +372,7 @@ void Simulator :: runSimulation(){
     auto end = std :: chrono :: high_resolution_clock::now();
     total_time = end - start;
     save_data.close();
+    save_qp.close();
 }
 void Simulator :: calculateDistances(){
     std :: vector <float> temp_inter_agent, temp_agent_obs;
@@ -463,6 +480,31 @@ void Simulator :: saveMetrics(){
         ROS_INFO_STREAM("Smallest inter-agent dist = " << min_inter_agent_dist << " m");
         ROS_INFO_STREAM("Average obs-agent dist = " << avg_agent_obs_dist << " m");
         ROS_INFO_STREAM("Smallest obs-agent dist = " << min_agent_obs_dist << " m");
+
+        int num_qp = 0, num_changes = 0, num_fallback = 0;
+        for(int i = 0; i < num_drone; i++){
+            for(int changes : prob_data[i].qp_changes){
+                if(changes < 0){
+                    num_fallback++;
+                    continue;
+                }
+                num_qp++;
+                num_changes += changes;
+            }
+        }
+        if(num_qp != 0)
+            ROS_INFO_STREAM("Average active-set changes per QP = " << (float)num_changes/num_qp);
+        if(num_fallback != 0)
+            ROS_WARN_STREAM(num_fallback << " QPs too large for qpoases were solved by quadprog");
+
+        int num_steps = 0, num_iters = 0;
+        for(int i = 0; i < num_drone; i++){
+            num_steps += prob_data[i].scp_iters.size();
+            for(int iters : prob_data[i].scp_iters)
+                num_iters += iters;
+        }
+        if(num_steps != 0)
+            ROS_INFO_STREAM("Average SCP linearizations per MPC step = " << (float)num_iters/num_steps);
     }
     else{
         success = false;
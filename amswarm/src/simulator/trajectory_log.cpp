@@ -0,0 +1,93 @@
+#include "simulator/trajectory_log.hpp"
+#include <algorithm>
+#include <cstring>
+#include <ros/ros.h>
+#ifdef AMSWARM_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+static const int32_t TRAJ_LOG_VERSION = 2;
+
+static void writeInts(std :: ofstream &file, std :: initializer_list<int32_t> values){
+    for(int32_t value : values)
+        file.write(reinterpret_cast<const char*>(&value), sizeof(int32_t));
+}
+
+static void writeFloats(std :: ofstream &file, std :: initializer_list<float> values){
+    for(float value : values)
+        file.write(reinterpret_cast<const char*>(&value), sizeof(float));
+}
+
+static void writeRows(std :: ofstream &file, const std :: vector<std :: vector<float>> &rows, int num_rows){
+    for(int i = 0; i < num_rows; i++)
+        writeFloats(file, {rows[i][0], rows[i][1], rows[i][2]});
+}
+
+TrajectoryLog :: TrajectoryLog(const std :: string &file_name, const trajLogInfo &info, int chunk_frames){
+#ifndef AMSWARM_HAVE_ZLIB
+    if(chunk_frames > 0){
+        ROS_WARN_STREAM("Built without zlib, the trajectory log is written uncompressed");
+        chunk_frames = 0;
+    }
+#endif
+    this->chunk_frames = std :: max(chunk_frames, 0);
+    frame_size = 1 + 3*info.num_drone*info.num + 9*info.num_drone*info.up_steps;
+    num_pending = 0;
+    if(this->chunk_frames > 0)
+        chunk.resize((size_t)this->chunk_frames*frame_size);
+
+    int32_t header_bytes = 8 + 8*sizeof(int32_t) + 4*sizeof(float) + 6*(info.num_drone + info.num_obs)*sizeof(float);
+
+    file.open(file_name, std :: ios :: binary);
+    if(!file.is_open())
+        ROS_ERROR_STREAM("Could not open " << file_name);
+    file.write("AMSWLOG", 8);
+    writeInts(file, {TRAJ_LOG_VERSION, header_bytes, info.num_drone, info.num, info.num_up, info.up_steps, info.num_obs, this->chunk_frames});
+    writeFloats(file, {info.dt, info.a_drone, info.b_drone, info.c_drone});
+    writeRows(file, info.init_drone, info.num_drone);
+    writeRows(file, info.goal_drone, info.num_drone);
+    writeRows(file, info.pos_static_obs, info.num_obs);
+    writeRows(file, info.dim_static_obs, info.num_obs);
+}
+
+TrajectoryLog :: ~TrajectoryLog(){
+    close();
+}
+
+void TrajectoryLog :: writeFrame(const float *frame){
+    if(chunk_frames == 0){
+        file.write(reinterpret_cast<const char*>(frame), (size_t)frame_size*sizeof(float));
+        return;
+    }
+    std :: memcpy(chunk.data() + (size_t)num_pending*frame_size, frame, (size_t)frame_size*sizeof(float));
+    if(++num_pending == chunk_frames)
+        flushChunk();
+}
+
+void TrajectoryLog :: flushChunk(){
+    if(num_pending == 0)
+        return;
+#ifdef AMSWARM_HAVE_ZLIB
+    uLong raw_bytes = (uLong)num_pending*frame_size*sizeof(float);
+    uLongf num_bytes = compressBound(raw_bytes);
+    deflated.resize(num_bytes);
+    if(compress2(deflated.data(), &num_bytes, reinterpret_cast<const Bytef*>(chunk.data()), raw_bytes, Z_BEST_SPEED) != Z_OK)
+        ROS_ERROR_STREAM("Compressing a trajectory log chunk failed");
+
+    uint32_t chunk_header[2] = {(uint32_t)num_pending, (uint32_t)num_bytes};
+    file.write(reinterpret_cast<const char*>(chunk_header), sizeof(chunk_header));
+    file.write(reinterpret_cast<const char*>(deflated.data()), num_bytes);
+#endif
+    num_pending = 0;
+}
+
+void TrajectoryLog :: flush(){
+    file.flush();
+}
+
+void TrajectoryLog :: close(){
+    if(!file.is_open())
+        return;
+    flushChunk();
+    file.close();
+}